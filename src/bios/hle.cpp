@@ -0,0 +1,200 @@
+#include "hle.h"
+#include <cstring>
+#include "system.h"
+#include "utils/address.h"
+
+namespace bios {
+
+namespace {
+// A0/B0/C0 dispatcher, function prologue and epilogue
+const int CALL_OVERHEAD = 16;
+
+// Host pointer to [address, address + size) in RAM, nullptr if range is not entirely inside of single RAM mirror
+uint8_t* ramRange(System* sys, uint32_t address, uint32_t size) {
+    if (address >= 0xc000'0000) return nullptr;
+    uint32_t phys = address & 0x1fff'ffff;
+    if (!in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(phys)) return nullptr;
+
+    uint32_t offset = (phys - System::RAM_BASE) & (sys->ram.size() - 1);
+    if (size > sys->ram.size() - offset) return nullptr;
+    return sys->ram.data() + offset;
+}
+
+// Length of the string (without terminator), -1 if it is not terminated within RAM
+int32_t stringLength(System* sys, uint32_t address) {
+    uint8_t* str = ramRange(sys, address, 1);
+    if (str == nullptr) return -1;
+
+    size_t remaining = sys->ram.data() + sys->ram.size() - str;
+    auto end = static_cast<uint8_t*>(memchr(str, 0, remaining));
+    if (end == nullptr) return -1;
+    return static_cast<int32_t>(end - str);
+}
+
+void invalidateCode(System* sys, uint8_t* dst, uint32_t size) {
+    if (size == 0) return;
+    uint32_t offset = static_cast<uint32_t>(dst - sys->ram.data());
+    const int shift = mips::CPU::CODE_PAGE_SHIFT;
+    for (uint32_t page = offset >> shift; page <= (offset + size - 1) >> shift; page++) {
+        sys->cpu->invalidateCode(page << shift);
+    }
+}
+
+// BIOS copies byte by byte from the beginning, overlapping ranges repeat the pattern
+void copyForward(uint8_t* dst, const uint8_t* src, uint32_t size) {
+    if (dst > src && dst < src + size) {
+        for (uint32_t i = 0; i < size; i++) dst[i] = src[i];
+    } else {
+        memmove(dst, src, size);
+    }
+}
+
+int copy(System* sys, uint32_t dstAddress, uint32_t srcAddress, uint32_t len) {
+    if (dstAddress == 0 || srcAddress == 0 || static_cast<int32_t>(len) < 0) return 0;
+
+    uint8_t* dst = ramRange(sys, dstAddress, len);
+    uint8_t* src = ramRange(sys, srcAddress, len);
+    if (dst == nullptr || src == nullptr) return 0;
+
+    copyForward(dst, src, len);
+    invalidateCode(sys, dst, len);
+    return CALL_OVERHEAD + len * 6;
+}
+
+int fill(System* sys, uint32_t dstAddress, uint8_t value, uint32_t len) {
+    if (dstAddress == 0 || static_cast<int32_t>(len) <= 0) return 0;
+
+    uint8_t* dst = ramRange(sys, dstAddress, len);
+    if (dst == nullptr) return 0;
+
+    memset(dst, value, len);
+    invalidateCode(sys, dst, len);
+    return CALL_OVERHEAD + len * 5;
+}
+
+// A(2Ah) memcpy(dst, src, len)
+int nativeMemcpy(System* sys, Hle::Call& call) {
+    call.v0 = call.a[0];
+    return copy(sys, call.a[0], call.a[1], call.a[2]);
+}
+
+// A(27h) bcopy(src, dst, len)
+int nativeBcopy(System* sys, Hle::Call& call) {
+    call.v0 = call.a[0];
+    return copy(sys, call.a[1], call.a[0], call.a[2]);
+}
+
+// A(2Bh) memset(dst, value, len)
+int nativeMemset(System* sys, Hle::Call& call) {
+    call.v0 = call.a[0];
+    return fill(sys, call.a[0], static_cast<uint8_t>(call.a[1]), call.a[2]);
+}
+
+// A(28h) bzero(dst, len)
+int nativeBzero(System* sys, Hle::Call& call) {
+    call.v0 = call.a[0];
+    return fill(sys, call.a[0], 0, call.a[1]);
+}
+
+// A(1Bh) strlen(src)
+int nativeStrlen(System* sys, Hle::Call& call) {
+    if (call.a[0] == 0) return 0;
+
+    int32_t len = stringLength(sys, call.a[0]);
+    if (len < 0) return 0;
+
+    call.v0 = len;
+    return CALL_OVERHEAD + (len + 1) * 5;
+}
+
+// A(17h) strcmp(str1, str2)
+int nativeStrcmp(System* sys, Hle::Call& call) {
+    if (call.a[0] == 0 || call.a[1] == 0) return 0;
+
+    int32_t len1 = stringLength(sys, call.a[0]);
+    int32_t len2 = stringLength(sys, call.a[1]);
+    if (len1 < 0 || len2 < 0) return 0;
+
+    auto str1 = reinterpret_cast<const int8_t*>(ramRange(sys, call.a[0], len1 + 1));
+    auto str2 = reinterpret_cast<const int8_t*>(ramRange(sys, call.a[1], len2 + 1));
+    int32_t i = 0;
+    while (str1[i] == str2[i] && str1[i] != 0) i++;
+
+    call.v0 = static_cast<uint32_t>(str1[i] - str2[i]);
+    return CALL_OVERHEAD + (i + 1) * 8;
+}
+
+// A(19h) strcpy(dst, src)
+int nativeStrcpy(System* sys, Hle::Call& call) {
+    if (call.a[0] == 0 || call.a[1] == 0) return 0;
+
+    int32_t len = stringLength(sys, call.a[1]);
+    if (len < 0) return 0;
+
+    call.v0 = call.a[0];
+    return copy(sys, call.a[0], call.a[1], len + 1);
+}
+};  // namespace
+
+Hle::Hle() {
+    functions = {
+        {0, 0x17, "strcmp", nativeStrcmp},  //
+        {0, 0x19, "strcpy", nativeStrcpy},  //
+        {0, 0x1B, "strlen", nativeStrlen},  //
+        {0, 0x27, "bcopy", nativeBcopy},    //
+        {0, 0x28, "bzero", nativeBzero},    //
+        {0, 0x2A, "memcpy", nativeMemcpy},  //
+        {0, 0x2B, "memset", nativeMemset},  //
+    };
+
+    for (auto& table : lookup) table.fill(-1);
+    for (size_t i = 0; i < functions.size(); i++) {
+        lookup[functions[i].table][functions[i].number] = static_cast<int16_t>(i);
+    }
+}
+
+void Hle::setEnabled(bool enabled) {
+    for (auto& function : functions) function.enabled = enabled;
+}
+
+void Hle::setEnabled(std::string_view name, bool enabled) {
+    for (auto& function : functions) {
+        if (function.name == name) function.enabled = enabled;
+    }
+}
+
+void Hle::resetCounters() {
+    for (auto& function : functions) {
+        function.hits = 0;
+        function.instructions = 0;
+    }
+}
+
+int Hle::call(System* sys, int table, uint8_t number) {
+    int index = lookup[table][number];
+    if (index < 0) return 0;
+
+    auto& function = functions[index];
+    if (!function.enabled) return 0;
+
+    auto cpu = sys->cpu.get();
+    if (cpu->cop0.status.isolateCache) return 0;
+
+    // Value loaded in the delay slot of the call is already visible to the function
+    auto reg = [cpu](uint32_t r) { return cpu->slots[0].reg == r ? cpu->slots[0].data : cpu->reg[r]; };
+
+    Call call = {{reg(4), reg(5), reg(6), reg(7)}, 0};
+    int instructions = function.handler(sys, call);
+    if (instructions == 0) return 0;
+
+    uint32_t ra = reg(31);
+    cpu->moveLoadDelaySlots();
+    cpu->setReg(2, call.v0);
+    cpu->setPC(ra);
+
+    sys->cycles += instructions;
+    function.hits++;
+    function.instructions += instructions;
+    return instructions;
+}
+};  // namespace bios
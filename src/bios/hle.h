@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+struct System;
+
+namespace bios {
+
+/**
+ * HLE - native implementations of BIOS library functions.
+ * Called at A0/B0/C0 vector (with ENABLE_BIOS_HOOKS), function runs directly on guest RAM,
+ * sets v0 and returns to ra, skipping the interpreted BIOS routine.
+ * Calls with arguments outside of RAM (or unusual edge cases) are left to the BIOS.
+ */
+class Hle {
+   public:
+    // Arguments (a0-a3) and result (v0) of the call
+    struct Call {
+        uint32_t a[4];
+        uint32_t v0;
+    };
+    // Returns number of instructions the BIOS routine would execute, 0 if call is not handled
+    using Handler = int (*)(System* sys, Call& call);
+
+    struct Function {
+        int table;  // 0 - A0, 1 - B0, 2 - C0
+        uint8_t number;
+        std::string_view name;
+        Handler handler;
+
+        bool enabled = false;  // Set from options.system.biosHle and biosHleFunctions, toggled in BIOS HLE debug window
+        uint64_t hits = 0;
+        uint64_t instructions = 0;  // Total number of instructions which were not interpreted
+    };
+
+    std::vector<Function> functions;
+
+    Hle();
+    void setEnabled(bool enabled);
+    void setEnabled(std::string_view name, bool enabled);
+    void resetCounters();
+
+    // Executes the function if it is enabled, returns number of instructions charged for it (0 if BIOS should run)
+    int call(System* sys, int table, uint8_t number);
+
+   private:
+    // Index to functions, -1 if function has no native implementation
+    std::array<std::array<int16_t, 256>, 3> lookup;
+};
+};  // namespace bios
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <unordered_map>
+#include "cpu/cpu_mode.h"
 #include "device/controller/controller_type.h"
 #include "device/gpu/rendering_mode.h"
 #include "utils/event.h"
@@ -64,6 +65,8 @@ struct avocado_config_t {
             bool vsync = false;
             bool forceNtsc = false;
             bool nativeTextureFormat = true;
+            int rendererThreads = 0;  // Software renderer worker threads, 0 - draw on emulation thread
+            bool asyncGpu = false;    // Process GP0 commands on separate thread
         } graphics;
 
         struct {
@@ -77,6 +80,10 @@ struct avocado_config_t {
 
         struct {
             bool ram8mb = false;
+            CpuMode cpuMode = CpuMode::interpreter;
+            bool fastmem = false;
+            bool biosHle = false;  // Native BIOS functions, requires ENABLE_BIOS_HOOKS
+            std::unordered_map<std::string, bool> biosHleFunctions;  // Per function override (by name), missing - enabled
         } system;
 
     } options;
@@ -0,0 +1,183 @@
+#include "cached_interpreter.h"
+#include "cpu/cpu.h"
+#include "system.h"
+#include "utils/address.h"
+
+namespace mips {
+
+static bool isBranch(Opcode i) {
+    if (i.op >= 1 && i.op <= 7) return true;                    // REGIMM, j, jal, beq, bne, blez, bgtz
+    if (i.op == 0 && (i.fun == 8 || i.fun == 9)) return true;  // jr, jalr
+    return false;
+}
+
+// mtc0 and rfe can enable pending interrupt, syscall and break always throw an exception
+static bool endsBlock(Opcode i) {
+    if (i.op == 16) return true;
+    if (i.op == 0 && (i.fun == 12 || i.fun == 13)) return true;
+    return false;
+}
+
+CachedInterpreter::CachedInterpreter(CPU* cpu, System* sys) : cpu(cpu), sys(sys) {
+    ramBlocks.resize(sys->ram.size() / 4);
+    biosBlocks.resize(System::BIOS_SIZE / 4);
+}
+
+std::unique_ptr<CachedInterpreter::Block>* CachedInterpreter::lookup(uint32_t address) {
+    uint32_t phys = address & 0x1fff'ffff;
+    if (in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(phys)) {
+        return &ramBlocks[((phys - System::RAM_BASE) & (sys->ram.size() - 1)) / 4];
+    }
+    if (in_range<System::BIOS_BASE, System::BIOS_SIZE>(phys)) {
+        return &biosBlocks[(phys - System::BIOS_BASE) / 4];
+    }
+    return nullptr;
+}
+
+int CachedInterpreter::execute(int count) {
+    int executed = 0;
+    Block* previous = nullptr;
+    while (executed < count && likely(!cpu->breakpointsEnabled) && likely(!sys->scheduler.yieldCpu)) {
+        Block* block = nullptr;
+        if (cpu->nextPC == cpu->PC + 4) {
+            if (auto entry = lookup(cpu->PC); entry != nullptr) {
+                if (*entry && (*entry)->pc == cpu->PC) {
+                    block = entry->get();
+                } else {
+                    block = decode(cpu->PC);
+                    previous = nullptr;
+                }
+            }
+        }
+
+        // Code outside RAM and BIOS or jump in Branch Delay slot
+        if (block == nullptr) {
+            cpu->interpret(1);
+            executed++;
+            previous = nullptr;
+            continue;
+        }
+
+#ifdef ENABLE_BIOS_HOOKS
+        uint32_t maskedPc = cpu->PC & 0x1fff'ffff;
+        if (maskedPc == 0xa0 || maskedPc == 0xb0 || maskedPc == 0xc0) {
+            // Function was executed natively, CPU returned to the caller
+            if (int charged = sys->handleBiosFunction(); charged != 0) {
+                executed += charged;
+                previous = nullptr;
+                continue;
+            }
+        }
+#endif
+
+        cpu->saveStateForException();
+        if (unlikely(cpu->attention)) {
+            cpu->checkForInterrupts();
+            if (cpu->PC != block->pc) {  // Interrupt taken
+                previous = nullptr;
+                continue;
+            }
+        }
+
+        int n = 0;
+        currentBlock = block;
+        for (const auto& i : block->instructions) {
+            // State for the first instruction is saved before the block is entered
+            if (n != 0 && i.saveState) cpu->saveStateForException();
+
+            uint32_t pc = cpu->nextPC;
+            cpu->setPC(pc);
+            i.handler(cpu, i.opcode);
+            cpu->moveLoadDelaySlots();
+            n++;
+
+            // Exception was thrown - PC points to the handler
+            if (unlikely(cpu->PC != pc)) break;
+        }
+        executed += n;
+        sys->cycles += n;
+
+        // Idle loop iterated at least twice - nothing changes until next event
+        if (unlikely(block->idleLoop != nullptr) && block == previous && cpu->PC == block->pc) {
+            executed += block->idleLoop->skip(cpu, sys);
+        }
+        previous = block;
+        currentBlock = nullptr;
+        retiredBlock.reset();
+    }
+    return executed;
+}
+
+CachedInterpreter::Block* CachedInterpreter::decode(uint32_t pc) {
+    auto startEntry = lookup(pc);
+    auto block = std::make_unique<Block>();
+    block->pc = pc;
+
+    bool inDelaySlot = false;
+    for (uint32_t address = pc;; address += 4) {
+        // Stop at region boundary (or RAM mirror wrap)
+        if (lookup(address) != startEntry + block->instructions.size()) break;
+
+        Opcode opcode(sys->readMemory32(address));
+        bool branch = isBranch(opcode);
+        if (inDelaySlot && branch) break;  // Leave branch in delay slot to the interpreter
+
+        auto handler = instructions::OpcodeTable[opcode.op].instruction;
+        if (opcode.op == 0) handler = instructions::SpecialTable[opcode.fun].instruction;
+        // Delay slot also clears branch state left by the branch
+        block->instructions.push_back({handler, opcode, inDelaySlot || instructions::canThrow(opcode)});
+
+        if (inDelaySlot) break;
+        if (branch) {
+            inDelaySlot = true;
+            continue;
+        }
+        if (endsBlock(opcode) || block->instructions.size() >= MAX_BLOCK_INSTRUCTIONS) break;
+    }
+    if (block->instructions.empty()) return nullptr;
+
+    std::vector<Opcode> opcodes;
+    for (const auto& i : block->instructions) opcodes.push_back(i.opcode);
+    block->idleLoop = IdleLoop::detect(pc, opcodes);
+
+    uint32_t phys = pc & 0x1fff'ffff;
+    if (in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(phys)) {
+        uint32_t ramAddress = (phys - System::RAM_BASE) & (sys->ram.size() - 1);
+        uint32_t size = static_cast<uint32_t>(block->instructions.size() * 4);
+        for (uint32_t a = ramAddress; a < ramAddress + size; a += 4) {
+            cpu->codePages[a >> CPU::CODE_PAGE_SHIFT] = 1;
+        }
+    }
+
+    *startEntry = std::move(block);
+    return startEntry->get();
+}
+
+void CachedInterpreter::invalidatePage(uint32_t page) {
+    uint32_t begin = page << CPU::CODE_PAGE_SHIFT;
+    uint32_t end = begin + (1 << CPU::CODE_PAGE_SHIFT);
+
+    // Blocks starting in previous page might overlap with this one
+    uint32_t address = begin >= MAX_BLOCK_SIZE ? begin - MAX_BLOCK_SIZE : 0;
+    for (; address < end; address += 4) {
+        auto& block = ramBlocks[address / 4];
+        if (block && address + block->instructions.size() * 4 > begin) {
+            remove(block);
+        }
+    }
+}
+
+void CachedInterpreter::invalidateAll() {
+    for (auto& block : ramBlocks) remove(block);
+    for (auto& block : biosBlocks) remove(block);
+    ramBlocks.resize(sys->ram.size() / 4);  // RAM size might change after loading save state
+}
+
+void CachedInterpreter::remove(std::unique_ptr<Block>& block) {
+    if (block.get() == currentBlock) {
+        retiredBlock = std::move(block);
+    } else {
+        block.reset();
+    }
+}
+};  // namespace mips
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "cpu/idle_loop.h"
+#include "cpu/instructions.h"
+
+struct System;
+
+namespace mips {
+struct CPU;
+
+/**
+ * Interpreter running pre-decoded basic blocks.
+ * Each instruction is decoded once to its final handler (SPECIAL opcodes are resolved
+ * to SpecialTable entry), blocks are invalidated using CPU::codePages like recompiled code.
+ */
+class CachedInterpreter {
+    static const int MAX_BLOCK_INSTRUCTIONS = 64;
+    static const uint32_t MAX_BLOCK_SIZE = (MAX_BLOCK_INSTRUCTIONS + 1) * 4;
+
+    struct CachedInstruction {
+        instructions::_Instruction handler;
+        Opcode opcode;
+        bool saveState;  // Exception state has to be saved before the handler is called
+    };
+
+    struct Block {
+        uint32_t pc;  // Virtual address block was decoded for
+        std::vector<CachedInstruction> instructions;
+        std::unique_ptr<IdleLoop> idleLoop;
+    };
+
+    CPU* cpu;
+    System* sys;
+
+    // Block cache indexed by (physical address / 4)
+    std::vector<std::unique_ptr<Block>> ramBlocks;
+    std::vector<std::unique_ptr<Block>> biosBlocks;
+
+    // Block modifying its own code is kept alive until it finishes
+    Block* currentBlock = nullptr;
+    std::unique_ptr<Block> retiredBlock;
+
+    std::unique_ptr<Block>* lookup(uint32_t address);
+    Block* decode(uint32_t address);
+    void remove(std::unique_ptr<Block>& block);
+
+   public:
+    CachedInterpreter(CPU* cpu, System* sys);
+
+    // Runs at least count instructions (or until breakpoint is set), returns number of executed instructions
+    int execute(int count);
+    void invalidatePage(uint32_t page);
+    void invalidateAll();
+};
+};  // namespace mips
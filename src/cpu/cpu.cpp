@@ -1,7 +1,13 @@
 #include "cpu.h"
+#include <fmt/core.h>
 #include "bios/functions.h"
+#include "config.h"
+#include "cpu/cached_interpreter.h"
+#include "cpu/idle_loop.h"
 #include "cpu/instructions.h"
+#include "cpu/recompiler/recompiler.h"
 #include "system.h"
+#include "utils/address.h"
 
 namespace mips {
 CPU::CPU(System* sys) : sys(sys) {
@@ -14,23 +20,27 @@ CPU::CPU(System* sys) : sys(sys) {
 
     for (auto& slot : slots) slot = {DUMMY_REG, 0};
     for (auto& line : icache) line = {0, 0};
-}
-
-INLINE void CPU::moveLoadDelaySlots() {
-    reg[slots[0].reg] = slots[0].data;
-    slots[0] = slots[1];
-    slots[1].reg = DUMMY_REG;  // invalidate
-}
 
-void CPU::saveStateForException() {
-    exceptionPC = PC;
-    exceptionIsInBranchDelay = inBranchDelay;
-    exceptionIsBranchTaken = branchTaken;
+    codePages.resize(sys->ram.size() >> CODE_PAGE_SHIFT, 0);
 
-    inBranchDelay = false;
-    branchTaken = false;
+    if (config.options.system.cpuMode == CpuMode::cachedInterpreter) {
+        cachedInterpreter = std::make_unique<CachedInterpreter>(this, sys);
+    }
+    if (config.options.system.cpuMode == CpuMode::recompiler) {
+#ifdef HAS_RECOMPILER
+        recompiler = std::make_unique<recompiler::Recompiler>(this, sys);
+        if (!recompiler->isValid()) {
+            fmt::print("[CPU] Unable to allocate memory for recompiler, using interpreter\n");
+            recompiler.reset();
+        }
+#else
+        fmt::print("[CPU] Recompiler is not supported on this platform, using interpreter\n");
+#endif
+    }
 }
 
+CPU::~CPU() = default;
+
 void CPU::handleHardwareBreakpoints() {
     if (cop0.dcic.codeBreakpointEnabled() && ((PC ^ cop0.bpcm) & cop0.bpc) == 0) {
         cop0.dcic.codeBreakpointHit = 1;
@@ -77,35 +87,113 @@ INLINE uint32_t CPU::fetchInstruction(uint32_t address) {
 }
 
 bool CPU::executeInstructions(int count) {
-    for (int i = 0; i < count; i++) {
+    if (likely(!breakpointsEnabled)) {
+        if (recompiler) {
+            count -= recompiler->execute(count);
+        } else if (cachedInterpreter) {
+            count -= cachedInterpreter->execute(count);
+        }
+    }
+    return interpret(count);
+}
+
+bool CPU::interpret(int count) {
+    for (int i = 0; i < count && likely(!sys->scheduler.yieldCpu); i++) {
 #ifdef ENABLE_BIOS_HOOKS
         uint32_t maskedPc = PC & 0x1fff'ffff;
-        if (maskedPc == 0xa0 || maskedPc == 0xb0 || maskedPc == 0xc0) sys->handleBiosFunction();
+        if (maskedPc == 0xa0 || maskedPc == 0xb0 || maskedPc == 0xc0) {
+            // Function was executed natively, CPU returned to the caller
+            if (int charged = sys->handleBiosFunction(); charged != 0) {
+                i += charged - 1;
+                continue;
+            }
+        }
 #endif
 
-        saveStateForException();
-        checkForInterrupts();
-        if (unlikely(breakpointsEnabled)) {
-            handleHardwareBreakpoints();
-            if (handleSoftwareBreakpoints()) return false;
+        // Exception state is saved lazily - only when interrupt or the instruction can throw,
+        // and in branch delay slot (to clear branch state left by the branch)
+        bool stateSaved = false;
+        if (unlikely(attention)) {
+            saveStateForException();
+            stateSaved = true;
+            checkForInterrupts();
+            if (unlikely(breakpointsEnabled)) {
+                handleHardwareBreakpoints();
+                if (handleSoftwareBreakpoints()) return false;
+            }
         }
 
         const auto opcode = Opcode(fetchInstruction(PC));
         const auto& op = instructions::OpcodeTable[opcode.op];
+        if (!stateSaved && (unlikely(inBranchDelay) || instructions::canThrow(opcode))) saveStateForException();
 
         setPC(nextPC);
         op.instruction(this, opcode);
         moveLoadDelaySlots();
 
         sys->cycles++;
+
+        if (unlikely(branchTaken)) i += handleTakenBranch();
     }
     return true;
 }
 
-void CPU::checkForInterrupts() {
-    if ((cop0.cause.interruptPending & cop0.status.interruptMask) && cop0.status.interruptEnable) {
-        instructions::exception(this, COP0::CAUSE::Exception::interrupt);
+// Called after branch instruction (PC points to its delay slot), returns number of instructions skipped in idle loop
+int CPU::handleTakenBranch() {
+    uint32_t target = nextPC;
+    if (target != idleLoopPc) {
+        idleLoopPc = target;
+        idleLoopIterations = 0;
+        idleLoop.reset();
+        return 0;
     }
+
+    // Loop iterated at least twice - nothing changes until next event
+    if (idleLoopIterations > 0) return idleLoop ? idleLoop->skip(this, sys) : 0;
+    idleLoopIterations++;
+
+    if (target >= PC || PC - target >= IdleLoop::MAX_INSTRUCTIONS * 4) return 0;
+
+    std::vector<Opcode> opcodes;
+    for (uint32_t address = target; address <= PC; address += 4) opcodes.emplace_back(sys->readMemory32(address));
+    idleLoop = IdleLoop::detect(target, opcodes);
+    if (!idleLoop) return 0;
+
+    // Code writes to the loop have to invalidate it
+    uint32_t phys = target & 0x1fff'ffff;
+    if (in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(phys)) {
+        for (uint32_t address = phys; address <= (PC & 0x1fff'ffff); address += 4) {
+            uint32_t ramAddress = (address - System::RAM_BASE) & (sys->ram.size() - 1);
+            codePages[ramAddress >> CODE_PAGE_SHIFT] = 1;
+        }
+    }
+    return idleLoop->skip(this, sys);
+}
+
+void CPU::checkForInterrupts() {
+    attention = breakpointsEnabled;
+    if (!interruptDeliverable()) return;
+
+    instructions::exception(this, COP0::CAUSE::Exception::interrupt);
+
+    // Interrupt was delayed (GTE command), check again before next instruction
+    if (interruptDeliverable()) attention = true;
+}
+
+void CPU::invalidateCodePage(uint32_t page) {
+    codePages[page] = 0;
+    idleLoopPc = 0;
+    idleLoop.reset();
+    if (cachedInterpreter) cachedInterpreter->invalidatePage(page);
+    if (recompiler) recompiler->invalidatePage(page);
+}
+
+void CPU::invalidateAllCode() {
+    codePages.assign(sys->ram.size() >> CODE_PAGE_SHIFT, 0);
+    idleLoopPc = 0;
+    idleLoop.reset();
+    if (cachedInterpreter) cachedInterpreter->invalidateAll();
+    if (recompiler) recompiler->invalidateAll();
 }
 
 void CPU::busError() { instructions::exception(this, COP0::CAUSE::Exception::busErrorData); }
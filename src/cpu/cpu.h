@@ -1,6 +1,8 @@
 #pragma once
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 #include "cpu/cop0.h"
 #include "cpu/gte/gte.h"
 #include "opcode.h"
@@ -9,6 +11,11 @@
 struct System;
 
 namespace mips {
+class CachedInterpreter;
+class IdleLoop;
+namespace recompiler {
+class Recompiler;
+}
 
 /*
 Based on http://problemkaputt.de/psx-spx.htm
@@ -88,9 +95,33 @@ struct CPU {
 
     bool breakpointsEnabled = false;
 
+    // Set when deliverable interrupt or breakpoint state might have changed (IRQ, COP0 write, breakpoint edit),
+    // execution loops check interrupts and breakpoints only while it is set
+    bool attention = true;
+
+    // Code cache invalidation, one flag per 4KB page of RAM containing cached or recompiled code
+    inline static const int CODE_PAGE_SHIFT = 12;
+    std::vector<uint8_t> codePages;
+    std::unique_ptr<CachedInterpreter> cachedInterpreter;
+    std::unique_ptr<recompiler::Recompiler> recompiler;
+
+    // Interpreter idle loop - loop closed by the last taken branch, detected on its second iteration
+    uint32_t idleLoopPc = 0;
+    int idleLoopIterations = 0;
+    std::unique_ptr<IdleLoop> idleLoop;
+    int handleTakenBranch();
+
     CPU(System* sys);
+    ~CPU();
+    INLINE bool interruptDeliverable() const {
+        return (cop0.cause.interruptPending & cop0.status.interruptMask) && cop0.status.interruptEnable;
+    }
     void checkForInterrupts();
-    INLINE void moveLoadDelaySlots();
+    INLINE void moveLoadDelaySlots() {
+        reg[slots[0].reg] = slots[0].data;
+        slots[0] = slots[1];
+        slots[1].reg = DUMMY_REG;  // invalidate
+    }
     INLINE void loadDelaySlot(uint32_t r, uint32_t data) {
         if (r == 0) return;
         if (r == slots[0].reg) {
@@ -117,11 +148,26 @@ struct CPU {
         nextPC = address + 4;
     }
 
-    void saveStateForException();
+    INLINE void saveStateForException() {
+        exceptionPC = PC;
+        exceptionIsInBranchDelay = inBranchDelay;
+        exceptionIsBranchTaken = branchTaken;
+
+        inBranchDelay = false;
+        branchTaken = false;
+    }
     void handleHardwareBreakpoints();
     bool handleSoftwareBreakpoints();
     INLINE uint32_t fetchInstruction(uint32_t address);
     bool executeInstructions(int count);
+    bool interpret(int count);
+
+    INLINE void invalidateCode(uint32_t ramAddress) {
+        uint32_t page = ramAddress >> CODE_PAGE_SHIFT;
+        if (unlikely(codePages[page])) invalidateCodePage(page);
+    }
+    void invalidateCodePage(uint32_t page);
+    void invalidateAllCode();
 
     void busError();
 
@@ -144,7 +190,10 @@ struct CPU {
         breakpoints.erase(address);
         updateBreakpointsFlag();
     }
-    void updateBreakpointsFlag() { breakpointsEnabled = !breakpoints.empty() || cop0.dcic.codeBreakpointEnabled(); }
+    void updateBreakpointsFlag() {
+        breakpointsEnabled = !breakpoints.empty() || cop0.dcic.codeBreakpointEnabled();
+        attention = true;
+    }
 
     template <class Archive>
     void serialize(Archive& ar) {
@@ -100,7 +100,10 @@ uint32_t GTE::read(uint8_t n) {
             case 60: return dqb;
             case 61: return (int32_t)(int16_t)zsf3;  // gte_bug?: sign extended
             case 62: return (int32_t)(int16_t)zsf4;  // gte_bug?: sign extended
-            case 63: flag.calculate(); return flag.reg;
+            case 63:
+                calculateFlag();
+                flag.calculate();
+                return flag.reg;
             default: return 0;
         }
     }(n);
@@ -115,6 +118,9 @@ void GTE::write(uint8_t n, uint32_t d) {
     if (logging) {
         log.push_back({GTE_ENTRY::MODE::write, n, d});
     }
+    // Replay of the last command needs control registers it was executed with
+    if (n >= 32 && n < 63) calculateFlag();
+
     switch (n) {
         case 0:
             v[0].y = d >> 16;
@@ -256,7 +262,10 @@ void GTE::write(uint8_t n, uint32_t d) {
         case 60: dqb = d; break;
         case 61: zsf3 = d; break;
         case 62: zsf4 = d; break;
-        case 63: flag.reg = d & 0x7FFFF000; break;
+        case 63:
+            flag.reg = d & 0x7FFFF000;
+            flagPending = false;
+            break;
         default: return;
     }
 }
@@ -266,6 +275,13 @@ void GTE::command(gte::Command& cmd) {
         log.push_back({GTE_ENTRY::MODE::func, cmd.cmd, 0});
     }
 
+    lastInput = static_cast<gte::DataRegisters&>(*this);
+    lastCommand = cmd;
+    flagPending = true;
+    execute(cmd);
+}
+
+void GTE::execute(gte::Command cmd) {
     flag.reg = 0;
     this->sf = cmd.sf;
     this->lm = cmd.lm;
@@ -294,4 +310,19 @@ void GTE::command(gte::Command& cmd) {
         case 0x3e: gpl(); break;
         case 0x3f: ncct(); break;
     }
-}
\ No newline at end of file
+}
+
+void GTE::calculateFlag() {
+    if (!flagPending) return;
+    flagPending = false;
+
+    auto& data = static_cast<gte::DataRegisters&>(*this);
+    gte::DataRegisters current = data;
+    data = lastInput;
+
+    computeFlags = true;
+    execute(lastCommand);
+    computeFlags = false;
+
+    data = current;
+}
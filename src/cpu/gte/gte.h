@@ -7,11 +7,46 @@
 #include "math.h"
 #include "utils/logic.h"
 
+#ifdef __AVX2__
+#define GTE_SIMD
+#endif
+
 namespace gui::debug {
 class GTE;
 }
 
-class GTE {
+namespace gte {
+// Data registers 0-31 - command inputs and results, saved before every command for FLAG replay
+struct DataRegisters {
+    gte::Vector<int16_t> v[3];
+    Reg32 rgbc;
+    uint16_t otz = 0;
+    int16_t ir[4] = {0};
+    gte::Vector<int16_t, int16_t, uint16_t> s[4];
+    Reg32 rgb[3];
+    uint32_t res1 = 0;     // prohibited
+    int32_t mac[4] = {0};  // Sum of products
+    int32_t lzcs = 0;
+    int32_t lzcr = 0;
+};
+
+// Control registers 32-62 - never modified by commands
+struct ControlRegisters {
+    gte::Matrix rotation;
+    gte::Vector<int32_t> translation;
+    gte::Matrix light;
+    gte::Vector<int32_t> backgroundColor;
+    gte::Matrix color;
+    gte::Vector<int32_t> farColor;
+    int32_t of[2] = {0};
+    uint16_t h = 0;
+    int16_t dqa = 0;
+    int32_t dqb = 0;
+    int16_t zsf3 = 0;
+    int16_t zsf4 = 0;
+};
+
+struct Registers : DataRegisters, ControlRegisters {
     union Flag {
         enum {
             IR0_SATURATED = 1 << 12,
@@ -63,6 +98,11 @@ class GTE {
         void calculate() { flag = or_range<30, 23>(reg) | or_range<18, 13>(reg); }
     };
 
+    Flag flag;
+};
+};  // namespace gte
+
+class GTE : gte::Registers {
     friend gui::debug::GTE;
 
     const std::array<uint8_t, 0x101> unrTable;
@@ -72,34 +112,18 @@ class GTE {
     bool sf;  // Used for setMac and setIr functions
     bool lm;  // saved as fields to prevent passing them to every function
 
-    // GTE registers 0-63
-    gte::Vector<int16_t> v[3];
-    Reg32 rgbc;
-    uint16_t otz = 0;
-    int16_t ir[4] = {0};
-    gte::Vector<int16_t, int16_t, uint16_t> s[4];
-    Reg32 rgb[3];
-    uint32_t res1 = 0;     // prohibited
-    int32_t mac[4] = {0};  // Sum of products
-    int32_t lzcs = 0;
-    int32_t lzcr = 0;
-
-    gte::Matrix rotation;
-    gte::Vector<int32_t> translation;
-    gte::Matrix light;
-    gte::Vector<int32_t> backgroundColor;
-    gte::Matrix color;
-    gte::Vector<int32_t> farColor;
-    int32_t of[2] = {0};
-    uint16_t h = 0;
-    int16_t dqa = 0;
-    int32_t dqb = 0;
-    int16_t zsf3 = 0;
-    int16_t zsf4 = 0;
-    Flag flag;
+    // FLAG is rarely read, so commands are executed without it (values are just clamped).
+    // Data registers from before the last command are kept and the command is replayed with flags enabled when FLAG is read.
+    // Control registers are not saved - FLAG is calculated before any of them is written.
+    bool computeFlags = false;
+    bool flagPending = false;
+    gte::Command lastCommand = 0;
+    gte::DataRegisters lastInput;
 
     constexpr std::array<uint8_t, 0x101> generateUnrTable();
     void reload();
+    void execute(gte::Command cmd);
+    void calculateFlag();
 
     // Internal operations and helpers
     void multiplyVectors(gte::Vector<int16_t> v1, gte::Vector<int16_t> v2, gte::Vector<int16_t> tr = gte::Vector<int16_t>(0));
@@ -124,6 +148,15 @@ class GTE {
 
     template <int i>
     void setMacAndIr(int64_t value, bool lm = false);
+    void setMacAndIr(gte::Vector<int64_t> value, bool lm = false);
+
+#ifdef GTE_SIMD
+    // AVX2 versions of internal operations (simd.cpp), results are bit exact with scalar implementation.
+    // Overflow and saturation flags are tracked only when FLAG is calculated
+    void setMacAndIrSimd(gte::Vector<int64_t> value, bool lm);
+    void multiplyMatrixByVectorSimd(const gte::Matrix& m, gte::Vector<int16_t> v, gte::Vector<int32_t> tr);
+    int64_t multiplyMatrixByVectorRTPSimd(const gte::Matrix& m, gte::Vector<int16_t> v, gte::Vector<int32_t> tr);
+#endif
 
     void setOtz(int64_t value);
     void pushScreenXY(int32_t x, int32_t y);
@@ -168,6 +201,8 @@ class GTE {
     };
     std::vector<GTE_ENTRY> log;
 
+    bool forceScalar = false;  // Use scalar reference implementation of SIMD accelerated operations
+
     GTE();
     ~GTE();
 
@@ -177,6 +212,7 @@ class GTE {
 
     template <class Archive>
     void serialize(Archive& ar) {
+        calculateFlag();
         ar(v);
         ar(rgbc);
         ar(otz);
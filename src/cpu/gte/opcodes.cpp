@@ -1,10 +1,14 @@
 #include "gte.h"
+#include <algorithm>
+#include "utils/macros.h"
 
 using gte::Matrix;
 using gte::toVector;
 using gte::Vector;
 
 int32_t GTE::clip(int32_t value, int32_t max, int32_t min, uint32_t flags) {
+    if (likely(!computeFlags)) return std::min(std::max(value, min), max);
+
     if (value > max) {
         flag.reg |= flags;
         return max;
@@ -18,6 +22,7 @@ int32_t GTE::clip(int32_t value, int32_t max, int32_t min, uint32_t flags) {
 
 template <int bit_size>
 void GTE::checkOverflow(int64_t value, uint32_t overflowBits, uint32_t underflowFlags) {
+    if (likely(!computeFlags)) return;
     if (value >= (1LL << (bit_size - 1))) flag.reg |= overflowBits;
     if (value < -(1LL << (bit_size - 1))) flag.reg |= underflowFlags;
 }
@@ -85,6 +90,18 @@ void GTE::setMacAndIr(int64_t value, bool lm) {
     setIr<i>(setMac<i>(value), lm);
 }
 
+void GTE::setMacAndIr(Vector<int64_t> value, bool lm) {
+#ifdef GTE_SIMD
+    if (likely(!forceScalar)) {
+        setMacAndIrSimd(value, lm);
+        return;
+    }
+#endif
+    setMacAndIr<1>(value.x, lm);
+    setMacAndIr<2>(value.y, lm);
+    setMacAndIr<3>(value.z, lm);
+}
+
 void GTE::setOtz(int64_t value) { otz = clip(value >> 12, 0xffff, 0x0000, Flag::SZ3_OTZ_SATURATED); }
 
 #define R (rgbc.read(0) << 4)
@@ -96,12 +113,19 @@ void GTE::nclip() {
 }
 
 void GTE::multiplyVectors(Vector<int16_t> v1, Vector<int16_t> v2, Vector<int16_t> tr) {
-    setMacAndIr<1>(((int64_t)tr.x << 12) + v1.x * v2.x, lm);
-    setMacAndIr<2>(((int64_t)tr.y << 12) + v1.y * v2.y, lm);
-    setMacAndIr<3>(((int64_t)tr.z << 12) + v1.z * v2.z, lm);
+    setMacAndIr(Vector<int64_t>(((int64_t)tr.x << 12) + v1.x * v2.x,  //
+                                ((int64_t)tr.y << 12) + v1.y * v2.y,  //
+                                ((int64_t)tr.z << 12) + v1.z * v2.z),
+                lm);
 }
 
 void GTE::multiplyMatrixByVector(Matrix m, Vector<int16_t> v, Vector<int32_t> tr) {
+#ifdef GTE_SIMD
+    if (likely(!forceScalar)) {
+        multiplyMatrixByVectorSimd(m, v, tr);
+        return;
+    }
+#endif
     Vector<int64_t> result;
 
     result.x = O(1, O(1, O(1, ((int64_t)tr.x << 12) + m[0][0] * v.x) + m[0][1] * v.y) + m[0][2] * v.z);
@@ -114,6 +138,9 @@ void GTE::multiplyMatrixByVector(Matrix m, Vector<int16_t> v, Vector<int32_t> tr
 }
 
 int64_t GTE::multiplyMatrixByVectorRTP(Matrix m, Vector<int16_t> v, Vector<int32_t> tr) {
+#ifdef GTE_SIMD
+    if (likely(!forceScalar)) return multiplyMatrixByVectorRTPSimd(m, v, tr);
+#endif
     Vector<int64_t> result;
 
     result.x = O(1, O(1, O(1, ((int64_t)tr.x << 12) + m[0][0] * v.x) + m[0][1] * v.y) + m[0][2] * v.z);
@@ -139,13 +166,14 @@ void GTE::ncds(int n) {
 
     auto prevIr = toVector(ir);
 
-    setMacAndIr<1>(((int64_t)farColor.r << 12) - (R * ir[1]));
-    setMacAndIr<2>(((int64_t)farColor.g << 12) - (G * ir[2]));
-    setMacAndIr<3>(((int64_t)farColor.b << 12) - (B * ir[3]));
+    setMacAndIr(Vector<int64_t>(((int64_t)farColor.r << 12) - (R * ir[1]),  //
+                                ((int64_t)farColor.g << 12) - (G * ir[2]),  //
+                                ((int64_t)farColor.b << 12) - (B * ir[3])));
 
-    setMacAndIr<1>((R * prevIr.x) + ir[0] * ir[1], lm);
-    setMacAndIr<2>((G * prevIr.y) + ir[0] * ir[2], lm);
-    setMacAndIr<3>((B * prevIr.z) + ir[0] * ir[3], lm);
+    setMacAndIr(Vector<int64_t>((R * prevIr.x) + ir[0] * ir[1],  //
+                                (G * prevIr.y) + ir[0] * ir[2],  //
+                                (B * prevIr.z) + ir[0] * ir[3]),
+                lm);
     pushColor();
 }
 
@@ -179,13 +207,14 @@ void GTE::cdp() {
 
     auto prevIr = toVector(ir);
 
-    setMacAndIr<1>(((int64_t)farColor.r << 12) - (R * ir[1]));
-    setMacAndIr<2>(((int64_t)farColor.g << 12) - (G * ir[2]));
-    setMacAndIr<3>(((int64_t)farColor.b << 12) - (B * ir[3]));
+    setMacAndIr(Vector<int64_t>(((int64_t)farColor.r << 12) - (R * ir[1]),  //
+                                ((int64_t)farColor.g << 12) - (G * ir[2]),  //
+                                ((int64_t)farColor.b << 12) - (B * ir[3])));
 
-    setMacAndIr<1>((R * prevIr.x) + ir[0] * ir[1], lm);
-    setMacAndIr<2>((G * prevIr.y) + ir[0] * ir[2], lm);
-    setMacAndIr<3>((B * prevIr.z) + ir[0] * ir[3], lm);
+    setMacAndIr(Vector<int64_t>((R * prevIr.x) + ir[0] * ir[1],  //
+                                (G * prevIr.y) + ir[0] * ir[2],  //
+                                (B * prevIr.z) + ir[0] * ir[3]),
+                lm);
     pushColor();
 }
 
@@ -213,9 +242,9 @@ void GTE::dpcs(bool useRGB0) {
     int16_t g = useRGB0 ? rgb[0].read(1) << 4 : G;
     int16_t b = useRGB0 ? rgb[0].read(2) << 4 : B;
 
-    setMacAndIr<1>(((int64_t)farColor.r << 12) - (r << 12));
-    setMacAndIr<2>(((int64_t)farColor.g << 12) - (g << 12));
-    setMacAndIr<3>(((int64_t)farColor.b << 12) - (b << 12));
+    setMacAndIr(Vector<int64_t>(((int64_t)farColor.r << 12) - (r << 12),  //
+                                ((int64_t)farColor.g << 12) - (g << 12),  //
+                                ((int64_t)farColor.b << 12) - (b << 12)));
 
     multiplyVectors(Vector<int16_t>(ir[0]), toVector(ir), Vector<int16_t>(r, g, b));
     pushColor();
@@ -224,22 +253,23 @@ void GTE::dpcs(bool useRGB0) {
 void GTE::dcpl() {
     auto prevIr = toVector(ir);
 
-    setMacAndIr<1>(((int64_t)farColor.r << 12) - (R * prevIr.x));
-    setMacAndIr<2>(((int64_t)farColor.g << 12) - (G * prevIr.y));
-    setMacAndIr<3>(((int64_t)farColor.b << 12) - (B * prevIr.z));
+    setMacAndIr(Vector<int64_t>(((int64_t)farColor.r << 12) - (R * prevIr.x),  //
+                                ((int64_t)farColor.g << 12) - (G * prevIr.y),  //
+                                ((int64_t)farColor.b << 12) - (B * prevIr.z)));
 
-    setMacAndIr<1>(R * prevIr.x + ir[0] * ir[1], lm);
-    setMacAndIr<2>(G * prevIr.y + ir[0] * ir[2], lm);
-    setMacAndIr<3>(B * prevIr.z + ir[0] * ir[3], lm);
+    setMacAndIr(Vector<int64_t>(R * prevIr.x + ir[0] * ir[1],  //
+                                G * prevIr.y + ir[0] * ir[2],  //
+                                B * prevIr.z + ir[0] * ir[3]),
+                lm);
     pushColor();
 }
 
 void GTE::intpl() {
     auto prevIr = toVector(ir);
 
-    setMacAndIr<1>(((int64_t)farColor.r << 12) - (prevIr.x << 12));
-    setMacAndIr<2>(((int64_t)farColor.g << 12) - (prevIr.y << 12));
-    setMacAndIr<3>(((int64_t)farColor.b << 12) - (prevIr.z << 12));
+    setMacAndIr(Vector<int64_t>(((int64_t)farColor.r << 12) - (prevIr.x << 12),  //
+                                ((int64_t)farColor.g << 12) - (prevIr.y << 12),  //
+                                ((int64_t)farColor.b << 12) - (prevIr.z << 12)));
 
     multiplyVectors(Vector<int16_t>(ir[0]), toVector(ir), prevIr);
     pushColor();
@@ -460,9 +490,10 @@ void GTE::gpf() {
  * Multiply vector (ir[1..3]) by scalar(ir[0]) and add mac[1..3]
  */
 void GTE::gpl() {
-    setMacAndIr<1>(((int64_t)mac[1] << (sf * 12)) + ir[0] * ir[1], lm);
-    setMacAndIr<2>(((int64_t)mac[2] << (sf * 12)) + ir[0] * ir[2], lm);
-    setMacAndIr<3>(((int64_t)mac[3] << (sf * 12)) + ir[0] * ir[3], lm);
+    setMacAndIr(Vector<int64_t>(((int64_t)mac[1] << (sf * 12)) + ir[0] * ir[1],  //
+                                ((int64_t)mac[2] << (sf * 12)) + ir[0] * ir[2],  //
+                                ((int64_t)mac[3] << (sf * 12)) + ir[0] * ir[3]),
+                lm);
     pushColor();
 }
 
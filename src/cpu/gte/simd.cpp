@@ -0,0 +1,149 @@
+#include "gte.h"
+
+#ifdef GTE_SIMD
+#include <immintrin.h>
+#include "utils/macros.h"
+
+using gte::Matrix;
+using gte::Vector;
+
+// Components 1..3 are kept in lanes 0..2, lane 3 is unused (always 0)
+namespace {
+const int64_t MAC_MAX = (1LL << 43) - 1;
+const int64_t MAC_MIN = -(1LL << 43);
+
+// Lane mask (bit n - lane n) to flag bits, component 1 uses the highest bit
+template <int firstBit>
+struct LaneFlags {
+    std::array<uint32_t, 8> table = {};
+
+    constexpr LaneFlags() {
+        for (int mask = 0; mask < 8; mask++) {
+            table[mask] = ((mask & 1) << firstBit) | ((mask & 2) << (firstBit - 2)) | ((mask & 4) << (firstBit - 4));
+        }
+    }
+    uint32_t operator[](int mask) const { return table[mask]; }
+};
+constexpr LaneFlags<30> macPositiveFlags;
+constexpr LaneFlags<27> macNegativeFlags;
+constexpr LaneFlags<24> irSaturatedFlags;
+
+int laneMask(__m256i mask) { return _mm256_movemask_pd(_mm256_castsi256_pd(mask)) & 7; }
+
+// checkOverflow<44> for MAC1..3, overflow masks are accumulated and converted to flags once
+struct MacOverflow {
+    __m256i positive = _mm256_setzero_si256();
+    __m256i negative = _mm256_setzero_si256();
+
+    void check(__m256i value) {
+        positive = _mm256_or_si256(positive, _mm256_cmpgt_epi64(value, _mm256_set1_epi64x(MAC_MAX)));
+        negative = _mm256_or_si256(negative, _mm256_cmpgt_epi64(_mm256_set1_epi64x(MAC_MIN), value));
+    }
+
+    uint32_t flags() const { return macPositiveFlags[laneMask(positive)] | macNegativeFlags[laneMask(negative)]; }
+};
+
+// extend_sign<44>
+__m256i extend44(__m256i value) {
+    const __m256i bias = _mm256_set1_epi64x(1LL << 43);
+    __m256i biased = _mm256_and_si256(_mm256_add_epi64(value, bias), _mm256_set1_epi64x((1LL << 44) - 1));
+    return _mm256_sub_epi64(biased, bias);
+}
+
+// Arithmetic shift by 12 (AVX2 has no 64bit arithmetic shift)
+__m256i shiftRight12(__m256i value) {
+    const __m256i sign = _mm256_set1_epi64x(1LL << 51);
+    return _mm256_sub_epi64(_mm256_xor_si256(_mm256_srli_epi64(value, 12), sign), sign);
+}
+
+// O(O(O((tr << 12) + m[i][0] * v.x) + m[i][1] * v.y) + m[i][2] * v.z) for every row
+template <bool flags>
+INLINE __m256i multiply(const Matrix& m, Vector<int16_t> v, Vector<int32_t> tr, MacOverflow& overflow) {
+    static_assert(sizeof(Matrix) == 9 * sizeof(int16_t), "Matrix must be packed");
+
+    // Elements 0..7 and 1..8, columns are gathered from them with byte shuffles
+    const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m[0][0]));
+    const __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m[0][1]));
+    const __m128i columns[3] = {
+        _mm_shuffle_epi8(first, _mm_setr_epi8(0, 1, 6, 7, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(first, _mm_setr_epi8(2, 3, 8, 9, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(last, _mm_setr_epi8(2, 3, 8, 9, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+    };
+    const int16_t vec[3] = {v.x, v.y, v.z};
+
+    __m256i acc = _mm256_slli_epi64(_mm256_setr_epi64x(tr.x, tr.y, tr.z, 0), 12);
+    for (int c = 0; c < 3; c++) {
+        __m256i product = _mm256_mul_epi32(_mm256_cvtepi16_epi64(columns[c]), _mm256_set1_epi64x(vec[c]));
+        acc = _mm256_add_epi64(acc, product);
+        if (flags) overflow.check(acc);
+        acc = extend44(acc);
+    }
+    return acc;
+}
+
+// MAC value (shifted if sf is set) truncated to 32 bits
+__m128i toMac(__m256i value, bool sf) {
+    if (sf) value = shiftRight12(value);
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(value, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+}
+
+// IR value clipped to 0x7fff..-0x8000 (or 0 if lm is set)
+__m128i toIr(__m128i mac, bool lm) { return _mm_min_epi32(_mm_max_epi32(mac, _mm_set1_epi32(lm ? 0 : -0x8000)), _mm_set1_epi32(0x7fff)); }
+
+// Lanes mask of IR values that were saturated
+int irSaturated(__m128i mac, bool lm) {
+    const __m128i max = _mm_set1_epi32(0x7fff);
+    const __m128i min = _mm_set1_epi32(lm ? 0 : -0x8000);
+    return _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(_mm_cmpgt_epi32(mac, max), _mm_cmplt_epi32(mac, min)))) & 7;
+}
+
+void store(int32_t mac[4], int16_t ir[4], __m128i macValue, __m128i irValue) {
+    alignas(16) int32_t m[4];
+    alignas(16) int32_t i[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(m), macValue);
+    _mm_store_si128(reinterpret_cast<__m128i*>(i), irValue);
+    for (int n = 0; n < 3; n++) {
+        mac[n + 1] = m[n];
+        ir[n + 1] = i[n];
+    }
+}
+};  // namespace
+
+void GTE::setMacAndIrSimd(Vector<int64_t> value, bool lm) {
+    __m256i v = _mm256_setr_epi64x(value.x, value.y, value.z, 0);
+    __m128i macValue = toMac(v, sf);
+    store(mac, ir, macValue, toIr(macValue, lm));
+
+    if (unlikely(computeFlags)) {
+        MacOverflow overflow;
+        overflow.check(v);
+        flag.reg |= overflow.flags() | irSaturatedFlags[irSaturated(macValue, lm)];
+    }
+}
+
+void GTE::multiplyMatrixByVectorSimd(const Matrix& m, Vector<int16_t> v, Vector<int32_t> tr) {
+    MacOverflow overflow;
+    __m256i result = unlikely(computeFlags) ? multiply<true>(m, v, tr, overflow) : multiply<false>(m, v, tr, overflow);
+
+    __m128i macValue = toMac(result, sf);
+    store(mac, ir, macValue, toIr(macValue, lm));
+
+    if (unlikely(computeFlags)) flag.reg |= overflow.flags() | irSaturatedFlags[irSaturated(macValue, lm)];
+}
+
+int64_t GTE::multiplyMatrixByVectorRTPSimd(const Matrix& m, Vector<int16_t> v, Vector<int32_t> tr) {
+    MacOverflow overflow;
+    __m256i result = unlikely(computeFlags) ? multiply<true>(m, v, tr, overflow) : multiply<false>(m, v, tr, overflow);
+
+    __m128i macValue = toMac(result, sf);
+    store(mac, ir, macValue, toIr(macValue, lm));
+
+    int64_t z = _mm256_extract_epi64(result, 2);
+    if (unlikely(computeFlags)) {
+        // IR3 is clipped using lm bit, but its saturation flag is calculated separately
+        flag.reg |= overflow.flags() | irSaturatedFlags[irSaturated(macValue, lm) & 3];
+        clip(z >> 12, 0x7fff, -0x8000, Flag::IR3_SATURATED);
+    }
+    return z;
+}
+#endif
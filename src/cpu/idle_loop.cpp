@@ -0,0 +1,149 @@
+#include "idle_loop.h"
+#include <algorithm>
+#include "cpu.h"
+#include "system.h"
+#include "utils/address.h"
+
+namespace mips {
+
+namespace {
+struct Operands {
+    bool allowed;
+    uint32_t reads;  // Bitmask of source registers
+    int write;       // Destination register (0 if none)
+    bool load;
+};
+
+uint32_t bit(uint32_t r) { return 1u << r; }
+
+Operands decodeOperands(Opcode i) {
+    switch (i.op) {
+        case 0:
+            switch (i.fun) {
+                case 0:
+                case 2:
+                case 3: return {true, bit(i.rt), (int)i.rd, false};  // sll, srl, sra
+                case 4:
+                case 6:
+                case 7: return {true, bit(i.rs) | bit(i.rt), (int)i.rd, false};  // sllv, srlv, srav
+                case 16:
+                case 18: return {true, 0, (int)i.rd, false};  // mfhi, mflo (hi/lo are not written in the loop)
+                case 32:
+                case 33:
+                case 34:
+                case 35:
+                case 36:
+                case 37:
+                case 38:
+                case 39:
+                case 42:
+                case 43: return {true, bit(i.rs) | bit(i.rt), (int)i.rd, false};  // alu, slt, sltu
+                default: return {false, 0, 0, false};
+            }
+        case 1:
+            if (i.rt != 0 && i.rt != 1) return {false, 0, 0, false};  // Only bltz, bgez - no link
+            return {true, bit(i.rs), 0, false};
+        case 2: return {true, 0, 0, false};                      // j
+        case 4:
+        case 5: return {true, bit(i.rs) | bit(i.rt), 0, false};  // beq, bne
+        case 6:
+        case 7: return {true, bit(i.rs), 0, false};  // blez, bgtz
+        case 8:
+        case 9:
+        case 10:
+        case 11:
+        case 12:
+        case 13:
+        case 14: return {true, bit(i.rs), (int)i.rt, false};  // alu immediate
+        case 15: return {true, 0, (int)i.rt, false};          // lui
+        case 32:
+        case 33:
+        case 35:
+        case 36:
+        case 37: return {true, bit(i.rs), (int)i.rt, true};  // lb, lh, lw, lbu, lhu
+        default: return {false, 0, 0, false};
+    }
+}
+
+uint32_t branchTarget(uint32_t address, Opcode i) {
+    if (i.op == 2) return ((address + 4) & 0xf000'0000) | (i.target << 2);
+    return address + 4 + (i.offset << 2);
+}
+
+// Polled memory can change only as a result of scheduled event
+bool isStable(uint32_t address) {
+    if (address >= 0xc000'0000) return false;
+    uint32_t phys = address & 0x1fff'ffff;
+    if (in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(phys)) return true;
+    if (in_range<System::SCRATCHPAD_BASE, System::SCRATCHPAD_SIZE>(phys)) return true;
+    if (in_range<System::BIOS_BASE, System::BIOS_SIZE>(phys)) return true;
+    if (in_range<0x1f80'1070, 8>(phys)) return true;  // I_STAT, I_MASK
+    return false;
+}
+};  // namespace
+
+std::unique_ptr<IdleLoop> IdleLoop::detect(uint32_t pc, const std::vector<Opcode>& opcodes) {
+    size_t size = opcodes.size();
+    if (size < 2 || size > MAX_INSTRUCTIONS) return nullptr;
+
+    // Block must end with branch (and its delay slot) back to the beginning
+    uint32_t branchAddress = pc + static_cast<uint32_t>(size - 2) * 4;
+    Opcode branch = opcodes[size - 2];
+    if (branch.op < 1 || branch.op > 7 || branch.op == 3) return nullptr;
+    if (branchTarget(branchAddress, branch) != pc) return nullptr;
+
+    uint32_t loopWrites = 0;
+    for (size_t n = 0; n < size; n++) {
+        Opcode opcode = opcodes[n];
+        // Loop body must not branch anywhere else (interpreter passes raw code, not a block)
+        if (n != size - 2 && opcode.op >= 1 && opcode.op <= 7) return nullptr;
+
+        auto operands = decodeOperands(opcode);
+        if (!operands.allowed) return nullptr;
+        loopWrites |= bit(operands.write);
+    }
+    loopWrites &= ~1u;
+
+    // Each register written in the loop must be written before it is read,
+    // otherwise iterations depend on each other (eg. counter)
+    auto loop = std::make_unique<IdleLoop>();
+    uint32_t written = 0;
+    int pendingLoad = 0;
+    for (auto opcode : opcodes) {
+        auto operands = decodeOperands(opcode);
+        if (operands.reads & loopWrites & ~written) return nullptr;
+        if (operands.write != 0 && operands.write == pendingLoad) return nullptr;
+
+        // Load result is visible after the next instruction (Load Delay slot)
+        written |= bit(pendingLoad);
+        pendingLoad = 0;
+
+        if (operands.load) {
+            loop->loads.push_back({static_cast<uint8_t>(opcode.rs), opcode.offset});
+            pendingLoad = operands.write;
+        } else if (operands.write != 0) {
+            written |= bit(operands.write);
+        }
+    }
+    return loop;
+}
+
+int IdleLoop::skip(CPU* cpu, System* sys) const {
+    // Interrupt will be taken before next iteration
+    if (cpu->interruptDeliverable()) return 0;
+
+    for (auto& load : loads) {
+        if (!isStable(cpu->reg[load.base] + load.offset)) return 0;
+    }
+
+    uint64_t now = sys->scheduler.now();
+    uint64_t next = sys->scheduler.nextEventTime();
+    if (next <= now || next == Scheduler::NEVER) return 0;
+
+    uint64_t instructions = (next - now + Scheduler::CYCLES_PER_INSTRUCTION - 1) / Scheduler::CYCLES_PER_INSTRUCTION;
+    int skipped = static_cast<int>(std::min<uint64_t>(instructions, INT32_MAX));
+    sys->cycles += skipped;
+    sys->idleCycles += skipped;
+    return skipped;
+}
+};  // namespace mips
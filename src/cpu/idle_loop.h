@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "opcode.h"
+
+struct System;
+
+namespace mips {
+struct CPU;
+
+/**
+ * Idle loop - block branching to itself without side effects, which only polls memory
+ * (eg. waiting for VBlank handler to set a flag or for I_STAT bit).
+ * Every iteration computes the same values until a device event changes polled memory,
+ * so time can be fast-forwarded to the next scheduled event.
+ */
+class IdleLoop {
+   public:
+    static const int MAX_INSTRUCTIONS = 16;
+
+   private:
+    struct Load {
+        uint8_t base;
+        int16_t offset;
+    };
+    std::vector<Load> loads;
+
+   public:
+    // Returns nullptr if block starting at pc is not an idle loop
+    static std::unique_ptr<IdleLoop> detect(uint32_t pc, const std::vector<Opcode>& opcodes);
+
+    // Advances system time to the next event, returns number of skipped instructions
+    int skip(CPU* cpu, System* sys) const;
+};
+};  // namespace mips
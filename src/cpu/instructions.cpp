@@ -1,5 +1,6 @@
 #include "instructions.h"
 #include <cstdio>
+#include <cstring>
 #include "system.h"
 
 using namespace mips;
@@ -582,6 +583,7 @@ void op_cop0(CPU *cpu, Opcode i) {
             // Restore from exception
             // RFE
             cpu->cop0.returnFromException();
+            cpu->attention = true;
             break;
 
         default: exception(cpu, COP0::CAUSE::Exception::reservedInstruction); break;
@@ -617,11 +619,47 @@ void op_cop2(CPU *cpu, Opcode i) {
     }
 }
 
+// With fastmem enabled RAM is accessed directly through the arena (KUSEG, KSEG0 and KSEG1 mirrors),
+// everything else goes through System
+INLINE uint8_t *fastmemRam(CPU *cpu, uint32_t address) {
+    auto &arena = cpu->sys->fastmemArena;
+    if (!arena) return nullptr;
+
+    uint32_t segment = address >> 29;
+    if (segment != 0 && segment != 4 && segment != 5) return nullptr;
+    if ((address & 0x1fffffff) >= System::RAM_SIZE_8MB) return nullptr;
+    return arena->data() + address;
+}
+
+template <typename T>
+INLINE T load(CPU *cpu, uint32_t address) {
+    if (uint8_t *ram = fastmemRam(cpu, address); ram != nullptr) {
+        T data;
+        memcpy(&data, ram, sizeof(T));
+        return data;
+    }
+    if constexpr (sizeof(T) == 1) return cpu->sys->readMemory8(address);
+    else if constexpr (sizeof(T) == 2) return cpu->sys->readMemory16(address);
+    else return cpu->sys->readMemory32(address);
+}
+
+template <typename T>
+INLINE void store(CPU *cpu, uint32_t address, T data) {
+    if (uint8_t *ram = fastmemRam(cpu, address); ram != nullptr && likely(!cpu->cop0.status.isolateCache)) {
+        cpu->invalidateCode((address & 0x1fffffff) & (cpu->sys->ram.size() - 1));
+        memcpy(ram, &data, sizeof(T));
+        return;
+    }
+    if constexpr (sizeof(T) == 1) cpu->sys->writeMemory8(address, data);
+    else if constexpr (sizeof(T) == 2) cpu->sys->writeMemory16(address, data);
+    else cpu->sys->writeMemory32(address, data);
+}
+
 // Load Byte
 // LB rt, offset(base)
 void op_lb(CPU *cpu, Opcode i) {
     uint32_t addr = cpu->reg[i.rs] + i.offset;
-    cpu->loadDelaySlot(i.rt, ((int32_t)(cpu->sys->readMemory8(addr) << 24)) >> 24);
+    cpu->loadDelaySlot(i.rt, ((int32_t)(load<uint8_t>(cpu, addr) << 24)) >> 24);
 }
 
 // Load Halfword
@@ -633,14 +671,14 @@ void op_lh(CPU *cpu, Opcode i) {
         exception(cpu, COP0::CAUSE::Exception::addressErrorLoad);
         return;
     }
-    cpu->loadDelaySlot(i.rt, (int32_t)(int16_t)cpu->sys->readMemory16(addr));
+    cpu->loadDelaySlot(i.rt, (int32_t)(int16_t)load<uint16_t>(cpu, addr));
 }
 
 // Load Word Left
 // LWL rt, offset(base)
 void op_lwl(CPU *cpu, Opcode i) {
     uint32_t addr = cpu->reg[i.rs] + i.offset;
-    uint32_t mem = cpu->sys->readMemory32(addr & 0xfffffffc);
+    uint32_t mem = load<uint32_t>(cpu, addr & 0xfffffffc);
 
     uint32_t reg;
     if (cpu->slots[0].reg == i.rt) {
@@ -668,14 +706,14 @@ void op_lw(CPU *cpu, Opcode i) {
         exception(cpu, COP0::CAUSE::Exception::addressErrorLoad);
         return;
     }
-    cpu->loadDelaySlot(i.rt, cpu->sys->readMemory32(addr));
+    cpu->loadDelaySlot(i.rt, load<uint32_t>(cpu, addr));
 }
 
 // Load Byte Unsigned
 // LBU rt, offset(base)
 void op_lbu(CPU *cpu, Opcode i) {
     uint32_t addr = cpu->reg[i.rs] + i.offset;
-    cpu->loadDelaySlot(i.rt, cpu->sys->readMemory8(addr));
+    cpu->loadDelaySlot(i.rt, load<uint8_t>(cpu, addr));
 }
 
 // Load Halfword Unsigned
@@ -687,7 +725,7 @@ void op_lhu(CPU *cpu, Opcode i) {
         exception(cpu, COP0::CAUSE::Exception::addressErrorLoad);
         return;
     }
-    cpu->loadDelaySlot(i.rt, cpu->sys->readMemory16(addr));
+    cpu->loadDelaySlot(i.rt, load<uint16_t>(cpu, addr));
 }
 
 // Load Word Right
@@ -695,7 +733,7 @@ void op_lhu(CPU *cpu, Opcode i) {
 void op_lwr(CPU *cpu, Opcode i) {
     uint32_t addr = cpu->reg[i.rs] + i.offset;
 
-    uint32_t mem = cpu->sys->readMemory32(addr & 0xfffffffc);
+    uint32_t mem = load<uint32_t>(cpu, addr & 0xfffffffc);
 
     uint32_t reg;
     if (cpu->slots[0].reg == i.rt) {
@@ -718,7 +756,7 @@ void op_lwr(CPU *cpu, Opcode i) {
 // SB rt, offset(base)
 void op_sb(CPU *cpu, Opcode i) {
     uint32_t addr = cpu->reg[i.rs] + i.offset;
-    cpu->sys->writeMemory8(addr, cpu->reg[i.rt]);
+    store<uint8_t>(cpu, addr, cpu->reg[i.rt]);
 }
 
 // Store Halfword
@@ -730,14 +768,14 @@ void op_sh(CPU *cpu, Opcode i) {
         exception(cpu, COP0::CAUSE::Exception::addressErrorStore);
         return;
     }
-    cpu->sys->writeMemory16(addr, cpu->reg[i.rt]);
+    store<uint16_t>(cpu, addr, cpu->reg[i.rt]);
 }
 
 // Store Word Left
 // SWL rt, offset(base)
 void op_swl(CPU *cpu, Opcode i) {
     uint32_t addr = cpu->reg[i.rs] + i.offset;
-    uint32_t mem = cpu->sys->readMemory32(addr & 0xfffffffc);
+    uint32_t mem = load<uint32_t>(cpu, addr & 0xfffffffc);
     uint32_t reg = cpu->reg[i.rt];
 
     uint32_t result = 0;
@@ -747,7 +785,7 @@ void op_swl(CPU *cpu, Opcode i) {
         case 2: result = (mem & 0xff000000) | (reg >> 8); break;
         case 3: result = (mem & 0x00000000) | (reg); break;
     }
-    cpu->sys->writeMemory32(addr & 0xfffffffc, result);
+    store<uint32_t>(cpu, addr & 0xfffffffc, result);
 }
 
 // Store Word
@@ -759,14 +797,14 @@ void op_sw(CPU *cpu, Opcode i) {
         exception(cpu, COP0::CAUSE::Exception::addressErrorStore);
         return;
     }
-    cpu->sys->writeMemory32(addr, cpu->reg[i.rt]);
+    store<uint32_t>(cpu, addr, cpu->reg[i.rt]);
 }
 
 // Store Word Right
 // SWR rt, offset(base)
 void op_swr(CPU *cpu, Opcode i) {
     uint32_t addr = cpu->reg[i.rs] + i.offset;
-    uint32_t mem = cpu->sys->readMemory32(addr & 0xfffffffc);
+    uint32_t mem = load<uint32_t>(cpu, addr & 0xfffffffc);
     uint32_t reg = cpu->reg[i.rt];
 
     uint32_t result = 0;
@@ -776,7 +814,7 @@ void op_swr(CPU *cpu, Opcode i) {
         case 2: result = (reg << 16) | (mem & 0x0000ffff); break;
         case 3: result = (reg << 24) | (mem & 0x00ffffff); break;
     }
-    cpu->sys->writeMemory32(addr & 0xfffffffc, result);
+    store<uint32_t>(cpu, addr & 0xfffffffc, result);
 }
 
 // Load to coprocessor 2
@@ -785,7 +823,7 @@ void op_lwc2(CPU *cpu, Opcode i) {
     uint32_t addr = cpu->reg[i.rs] + i.offset;
 
     assert(i.rt < 64);
-    auto data = cpu->sys->readMemory32(addr);
+    auto data = load<uint32_t>(cpu, addr);
     cpu->gte.write(i.rt, data);
 }
 
@@ -795,6 +833,6 @@ void op_swc2(CPU *cpu, Opcode i) {
     uint32_t addr = cpu->reg[i.rs] + i.offset;
     assert(i.rt < 64);
     auto gteRead = cpu->gte.read(i.rt);
-    cpu->sys->writeMemory32(addr, gteRead);
+    store<uint32_t>(cpu, addr, gteRead);
 }
 };  // namespace instructions
@@ -15,6 +15,40 @@ struct PrimaryInstruction {
 
 void exception(CPU* cpu, COP0::CAUSE::Exception cause);
 
+// Shifts, hi/lo, non-trapping ALU and branches other than jr/jalr never throw an exception
+inline bool canThrow(Opcode i) {
+    if (i.op == 0) {
+        switch (i.fun) {
+            case 0:
+            case 2:
+            case 3:
+            case 4:
+            case 6:
+            case 7:
+            case 16:
+            case 17:
+            case 18:
+            case 19:
+            case 24:
+            case 25:
+            case 26:
+            case 27:
+            case 33:
+            case 35:
+            case 36:
+            case 37:
+            case 38:
+            case 39:
+            case 42:
+            case 43: return false;
+            default: return true;
+        }
+    }
+    if (i.op >= 1 && i.op <= 7) return false;    // bltz, bgez, j, jal, beq, bne, blez, bgtz
+    if (i.op >= 9 && i.op <= 15) return false;  // addiu, slti, sltiu, andi, ori, xori, lui
+    return true;
+}
+
 void dummy(CPU* cpu, Opcode i);
 void invalid(CPU* cpu, Opcode i);
 void special(CPU* cpu, Opcode i);
@@ -83,4 +117,5 @@ void op_swc2(CPU* cpu, Opcode i);
 void op_breakpoint(CPU* cpu, Opcode i);
 
 extern std::array<PrimaryInstruction, 64> OpcodeTable;
+extern std::array<PrimaryInstruction, 64> SpecialTable;
 }  // namespace instructions
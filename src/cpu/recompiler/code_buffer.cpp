@@ -0,0 +1,43 @@
+#include "code_buffer.h"
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace mips::recompiler {
+CodeBuffer::CodeBuffer(size_t size) {
+#ifdef _WIN32
+    void* ptr = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) ptr = nullptr;
+#endif
+    if (ptr == nullptr) return;
+
+    memory = static_cast<uint8_t*>(ptr);
+    capacity = size;
+}
+
+CodeBuffer::~CodeBuffer() {
+    if (memory == nullptr) return;
+#ifdef _WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, capacity);
+#endif
+}
+
+void* CodeBuffer::append(const uint8_t* code, size_t size) {
+    // Keep blocks 16 byte aligned
+    size_t aligned = (size + 15) & ~15;
+    if (memory == nullptr || aligned > freeSpace()) return nullptr;
+
+    uint8_t* ptr = memory + used;
+    memcpy(ptr, code, size);
+    used += aligned;
+    return ptr;
+}
+};  // namespace mips::recompiler
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace mips::recompiler {
+
+// Block of host memory with read, write and execute permissions
+class CodeBuffer {
+    uint8_t* memory = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+
+   public:
+    CodeBuffer(size_t size);
+    ~CodeBuffer();
+    CodeBuffer(const CodeBuffer&) = delete;
+    CodeBuffer& operator=(const CodeBuffer&) = delete;
+
+    bool isValid() const { return memory != nullptr; }
+    size_t freeSpace() const { return capacity - used; }
+
+    // Copies code to the buffer, returns nullptr if there is no free space left
+    void* append(const uint8_t* code, size_t size);
+    void reset() { used = 0; }
+};
+};  // namespace mips::recompiler
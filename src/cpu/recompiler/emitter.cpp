@@ -0,0 +1,346 @@
+#include "emitter.h"
+#include <cassert>
+#include <cstring>
+
+namespace mips::recompiler {
+
+static bool fitsInt8(int32_t v) { return v >= -128 && v <= 127; }
+
+// spl, bpl, sil and dil require REX prefix when used as byte registers
+static bool needsRexForByte(Reg r) { return r >= Reg::rsp && r <= Reg::rdi; }
+
+void Emitter::emit32(uint32_t v) {
+    for (int i = 0; i < 4; i++) emit8((v >> (i * 8)) & 0xff);
+}
+
+void Emitter::emit64(uint64_t v) {
+    for (int i = 0; i < 8; i++) emit8((v >> (i * 8)) & 0xff);
+}
+
+void Emitter::rex(bool w, int reg, int index, int base, bool force) {
+    uint8_t prefix = 0x40 | (w << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+    if (prefix != 0x40 || force) emit8(prefix);
+}
+
+void Emitter::modrm(int reg, const Mem& m) {
+    int base = static_cast<int>(m.base) & 7;
+    bool sib = m.hasIndex || base == 4;
+    int mod;
+    if (m.disp == 0 && base != 5) {
+        mod = 0;
+    } else if (fitsInt8(m.disp)) {
+        mod = 1;
+    } else {
+        mod = 2;
+    }
+
+    emit8((mod << 6) | ((reg & 7) << 3) | (sib ? 4 : base));
+    if (sib) {
+        int ss = 0;
+        if (m.scale == 2) ss = 1;
+        if (m.scale == 4) ss = 2;
+        if (m.scale == 8) ss = 3;
+        int index = m.hasIndex ? (static_cast<int>(m.index) & 7) : 4;
+        emit8((ss << 6) | (index << 3) | base);
+    }
+
+    if (mod == 1) emit8(static_cast<uint8_t>(m.disp));
+    if (mod == 2) emit32(static_cast<uint32_t>(m.disp));
+}
+
+void Emitter::modrm(int reg, Reg rm) { emit8(0xc0 | ((reg & 7) << 3) | (static_cast<int>(rm) & 7)); }
+
+#define R(x) static_cast<int>(x)
+#define INDEX(m) ((m).hasIndex ? R((m).index) : 0)
+
+void Emitter::mov(Reg dst, Reg src) {
+    rex(false, R(src), 0, R(dst));
+    emit8(0x89);
+    modrm(R(src), dst);
+}
+
+void Emitter::mov(Reg dst, const Mem& src) {
+    rex(false, R(dst), INDEX(src), R(src.base));
+    emit8(0x8b);
+    modrm(R(dst), src);
+}
+
+void Emitter::mov(const Mem& dst, Reg src) {
+    rex(false, R(src), INDEX(dst), R(dst.base));
+    emit8(0x89);
+    modrm(R(src), dst);
+}
+
+void Emitter::mov(Reg dst, uint32_t imm) {
+    rex(false, 0, 0, R(dst));
+    emit8(0xb8 + (R(dst) & 7));
+    emit32(imm);
+}
+
+void Emitter::mov(const Mem& dst, uint32_t imm) {
+    rex(false, 0, INDEX(dst), R(dst.base));
+    emit8(0xc7);
+    modrm(0, dst);
+    emit32(imm);
+}
+
+void Emitter::mov64(Reg dst, Reg src) {
+    rex(true, R(src), 0, R(dst));
+    emit8(0x89);
+    modrm(R(src), dst);
+}
+
+void Emitter::mov64(Reg dst, const Mem& src) {
+    rex(true, R(dst), INDEX(src), R(src.base));
+    emit8(0x8b);
+    modrm(R(dst), src);
+}
+
+void Emitter::mov64(const Mem& dst, Reg src) {
+    rex(true, R(src), INDEX(dst), R(dst.base));
+    emit8(0x89);
+    modrm(R(src), dst);
+}
+
+void Emitter::mov64(Reg dst, uint64_t imm) {
+    rex(true, 0, 0, R(dst));
+    emit8(0xb8 + (R(dst) & 7));
+    emit64(imm);
+}
+
+void Emitter::mov8(const Mem& dst, Reg src) {
+    rex(false, R(src), INDEX(dst), R(dst.base), needsRexForByte(src));
+    emit8(0x88);
+    modrm(R(src), dst);
+}
+
+void Emitter::mov8(const Mem& dst, uint8_t imm) {
+    rex(false, 0, INDEX(dst), R(dst.base));
+    emit8(0xc6);
+    modrm(0, dst);
+    emit8(imm);
+}
+
+void Emitter::mov16(const Mem& dst, Reg src) {
+    emit8(0x66);
+    rex(false, R(src), INDEX(dst), R(dst.base));
+    emit8(0x89);
+    modrm(R(src), dst);
+}
+
+void Emitter::movzx8(Reg dst, Reg src) {
+    rex(false, R(dst), 0, R(src), needsRexForByte(src));
+    emit8(0x0f);
+    emit8(0xb6);
+    modrm(R(dst), src);
+}
+
+void Emitter::movzx8(Reg dst, const Mem& src) {
+    rex(false, R(dst), INDEX(src), R(src.base));
+    emit8(0x0f);
+    emit8(0xb6);
+    modrm(R(dst), src);
+}
+
+void Emitter::movsx8(Reg dst, const Mem& src) {
+    rex(false, R(dst), INDEX(src), R(src.base));
+    emit8(0x0f);
+    emit8(0xbe);
+    modrm(R(dst), src);
+}
+
+void Emitter::movzx16(Reg dst, const Mem& src) {
+    rex(false, R(dst), INDEX(src), R(src.base));
+    emit8(0x0f);
+    emit8(0xb7);
+    modrm(R(dst), src);
+}
+
+void Emitter::movsx16(Reg dst, const Mem& src) {
+    rex(false, R(dst), INDEX(src), R(src.base));
+    emit8(0x0f);
+    emit8(0xbf);
+    modrm(R(dst), src);
+}
+
+void Emitter::movsxd(Reg dst, const Mem& src) {
+    rex(true, R(dst), INDEX(src), R(src.base));
+    emit8(0x63);
+    modrm(R(dst), src);
+}
+
+void Emitter::alu(AluOp op, Reg dst, Reg src) {
+    rex(false, R(src), 0, R(dst));
+    emit8((R(op) << 3) | 0x01);
+    modrm(R(src), dst);
+}
+
+void Emitter::alu(AluOp op, Reg dst, const Mem& src) {
+    rex(false, R(dst), INDEX(src), R(src.base));
+    emit8((R(op) << 3) | 0x03);
+    modrm(R(dst), src);
+}
+
+void Emitter::alu(AluOp op, Reg dst, uint32_t imm) {
+    rex(false, 0, 0, R(dst));
+    if (fitsInt8(static_cast<int32_t>(imm))) {
+        emit8(0x83);
+        modrm(R(op), dst);
+        emit8(static_cast<uint8_t>(imm));
+    } else {
+        emit8(0x81);
+        modrm(R(op), dst);
+        emit32(imm);
+    }
+}
+
+void Emitter::alu(AluOp op, const Mem& dst, uint32_t imm) {
+    rex(false, 0, INDEX(dst), R(dst.base));
+    if (fitsInt8(static_cast<int32_t>(imm))) {
+        emit8(0x83);
+        modrm(R(op), dst);
+        emit8(static_cast<uint8_t>(imm));
+    } else {
+        emit8(0x81);
+        modrm(R(op), dst);
+        emit32(imm);
+    }
+}
+
+void Emitter::alu8(AluOp op, const Mem& dst, uint8_t imm) {
+    rex(false, 0, INDEX(dst), R(dst.base));
+    emit8(0x80);
+    modrm(R(op), dst);
+    emit8(imm);
+}
+
+void Emitter::alu64(AluOp op, Reg dst, int8_t imm) {
+    rex(true, 0, 0, R(dst));
+    emit8(0x83);
+    modrm(R(op), dst);
+    emit8(static_cast<uint8_t>(imm));
+}
+
+void Emitter::shift(ShiftOp op, Reg dst, uint8_t imm) {
+    rex(false, 0, 0, R(dst));
+    emit8(0xc1);
+    modrm(R(op), dst);
+    emit8(imm);
+}
+
+void Emitter::shiftCl(ShiftOp op, Reg dst) {
+    rex(false, 0, 0, R(dst));
+    emit8(0xd3);
+    modrm(R(op), dst);
+}
+
+void Emitter::shr64(Reg dst, uint8_t imm) {
+    rex(true, 0, 0, R(dst));
+    emit8(0xc1);
+    modrm(R(ShiftOp::shr), dst);
+    emit8(imm);
+}
+
+void Emitter::not_(Reg dst) {
+    rex(false, 0, 0, R(dst));
+    emit8(0xf7);
+    modrm(2, dst);
+}
+
+void Emitter::imul64(Reg dst, Reg src) {
+    rex(true, R(dst), 0, R(src));
+    emit8(0x0f);
+    emit8(0xaf);
+    modrm(R(dst), src);
+}
+
+void Emitter::test(Reg a, uint32_t imm) {
+    rex(false, 0, 0, R(a));
+    emit8(0xf7);
+    modrm(0, a);
+    emit32(imm);
+}
+
+void Emitter::test(const Mem& a, uint32_t imm) {
+    rex(false, 0, INDEX(a), R(a.base));
+    emit8(0xf7);
+    modrm(0, a);
+    emit32(imm);
+}
+
+void Emitter::test8(Reg a, Reg b) {
+    rex(false, R(b), 0, R(a), needsRexForByte(a) || needsRexForByte(b));
+    emit8(0x84);
+    modrm(R(b), a);
+}
+
+void Emitter::setcc(Cond cond, Reg dst) {
+    rex(false, 0, 0, R(dst), needsRexForByte(dst));
+    emit8(0x0f);
+    emit8(0x90 + R(cond));
+    modrm(0, dst);
+}
+
+void Emitter::rel32(Label& label) {
+    if (label.bound) {
+        emit32(static_cast<uint32_t>(static_cast<int32_t>(label.position - (code.size() + 4))));
+    } else {
+        label.patches.push_back(code.size());
+        emit32(0);
+    }
+}
+
+void Emitter::bind(Label& label) {
+    assert(!label.bound);
+    label.position = code.size();
+    label.bound = true;
+    for (size_t patch : label.patches) {
+        int32_t rel = static_cast<int32_t>(label.position - (patch + 4));
+        memcpy(&code[patch], &rel, sizeof(rel));
+    }
+    label.patches.clear();
+}
+
+void Emitter::jmp(Label& label) {
+    emit8(0xe9);
+    rel32(label);
+}
+
+void Emitter::jcc(Cond cond, Label& label) {
+    emit8(0x0f);
+    emit8(0x80 + R(cond));
+    rel32(label);
+}
+
+void Emitter::call(const void* function) {
+    mov64(Reg::rax, reinterpret_cast<uint64_t>(function));
+    rex(false, 0, 0, R(Reg::rax));
+    emit8(0xff);
+    modrm(2, Reg::rax);
+}
+
+void Emitter::push(Reg r) {
+    rex(false, 0, 0, R(r));
+    emit8(0x50 + (R(r) & 7));
+}
+
+void Emitter::pop(Reg r) {
+    rex(false, 0, 0, R(r));
+    emit8(0x58 + (R(r) & 7));
+}
+
+void Emitter::ret() { emit8(0xc3); }
+
+void Emitter::nop() { emit8(0x90); }
+
+void Emitter::patchJump(uint8_t* code, size_t length, const void* target) {
+    assert(length >= 5);
+    int32_t rel = static_cast<int32_t>(static_cast<const uint8_t*>(target) - (code + 5));
+    code[0] = 0xe9;
+    memcpy(code + 1, &rel, sizeof(rel));
+    memset(code + 5, 0x90, length - 5);
+}
+
+#undef INDEX
+#undef R
+};  // namespace mips::recompiler
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mips::recompiler {
+
+// Minimal x86-64 assembler, implements only encodings used by the recompiler.
+// Unless noted otherwise all operations are 32bit.
+enum class Reg : uint8_t { rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi, r8, r9, r10, r11, r12, r13, r14, r15 };
+
+enum class Cond : uint8_t {
+    o = 0x0,   // Overflow
+    no = 0x1,  // Not overflow
+    b = 0x2,   // Below (unsigned <)
+    ae = 0x3,  // Above or equal (unsigned >=)
+    e = 0x4,   // Equal
+    ne = 0x5,  // Not equal
+    be = 0x6,  // Below or equal (unsigned <=)
+    a = 0x7,   // Above (unsigned >)
+    s = 0x8,   // Sign
+    ns = 0x9,  // Not sign
+    l = 0xc,   // Less (signed <)
+    ge = 0xd,  // Greater or equal (signed >=)
+    le = 0xe,  // Less or equal (signed <=)
+    g = 0xf,   // Greater (signed >)
+};
+
+// Encoded as /digit field of 0x81 opcode
+enum class AluOp : uint8_t { add = 0, or_ = 1, and_ = 4, sub = 5, xor_ = 6, cmp = 7 };
+
+// Encoded as /digit field of 0xc1 and 0xd3 opcodes
+enum class ShiftOp : uint8_t { shl = 4, shr = 5, sar = 7 };
+
+// [base + index * scale + disp]
+struct Mem {
+    Reg base;
+    int32_t disp;
+    bool hasIndex = false;
+    Reg index = Reg::rax;
+    uint8_t scale = 1;
+
+    Mem(Reg base, int32_t disp) : base(base), disp(disp) {}
+    Mem(Reg base, Reg index, uint8_t scale, int32_t disp) : base(base), disp(disp), hasIndex(true), index(index), scale(scale) {}
+};
+
+struct Label {
+    size_t position = 0;
+    bool bound = false;
+    std::vector<size_t> patches;  // Offsets of rel32 fields referencing this label
+};
+
+class Emitter {
+    std::vector<uint8_t> code;
+
+    void emit8(uint8_t v) { code.push_back(v); }
+    void emit32(uint32_t v);
+    void emit64(uint64_t v);
+
+    void rex(bool w, int reg, int index, int base, bool force = false);
+    void modrm(int reg, const Mem& m);
+    void modrm(int reg, Reg rm);
+    void rel32(Label& label);
+
+   public:
+    const std::vector<uint8_t>& data() const { return code; }
+    size_t size() const { return code.size(); }
+    void clear() { code.clear(); }
+
+    // mov
+    void mov(Reg dst, Reg src);
+    void mov(Reg dst, const Mem& src);
+    void mov(const Mem& dst, Reg src);
+    void mov(Reg dst, uint32_t imm);
+    void mov(const Mem& dst, uint32_t imm);
+    void mov64(Reg dst, Reg src);
+    void mov64(Reg dst, const Mem& src);
+    void mov64(const Mem& dst, Reg src);
+    void mov64(Reg dst, uint64_t imm);
+    void mov8(const Mem& dst, Reg src);
+    void mov8(const Mem& dst, uint8_t imm);
+    void mov16(const Mem& dst, Reg src);
+    void movzx8(Reg dst, Reg src);
+    void movzx8(Reg dst, const Mem& src);
+    void movsx8(Reg dst, const Mem& src);
+    void movzx16(Reg dst, const Mem& src);
+    void movsx16(Reg dst, const Mem& src);
+    void movsxd(Reg dst, const Mem& src);
+
+    // Arithmetic
+    void alu(AluOp op, Reg dst, Reg src);
+    void alu(AluOp op, Reg dst, const Mem& src);
+    void alu(AluOp op, Reg dst, uint32_t imm);
+    void alu(AluOp op, const Mem& dst, uint32_t imm);
+    void alu8(AluOp op, const Mem& dst, uint8_t imm);
+    void alu64(AluOp op, Reg dst, int8_t imm);
+    void shift(ShiftOp op, Reg dst, uint8_t imm);
+    void shiftCl(ShiftOp op, Reg dst);
+    void shr64(Reg dst, uint8_t imm);
+    void not_(Reg dst);
+    void imul64(Reg dst, Reg src);
+    void test(Reg a, uint32_t imm);
+    void test(const Mem& a, uint32_t imm);
+    void test8(Reg a, Reg b);
+    void setcc(Cond cond, Reg dst);
+
+    // Control flow
+    void bind(Label& label);
+    void jmp(Label& label);
+    void jcc(Cond cond, Label& label);
+    void call(const void* function);
+    void push(Reg r);
+    void pop(Reg r);
+    void ret();
+    void nop();
+
+    // Overwrites length bytes of existing code with jmp to target (padded with nops)
+    static void patchJump(uint8_t* code, size_t length, const void* target);
+};
+};  // namespace mips::recompiler
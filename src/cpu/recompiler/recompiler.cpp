@@ -0,0 +1,723 @@
+#include "recompiler.h"
+#include <fmt/core.h>
+#include "cpu/cpu.h"
+#include "cpu/instructions.h"
+#include "system.h"
+#include "utils/address.h"
+
+namespace mips::recompiler {
+
+#ifdef _WIN32
+const Reg ARG0 = Reg::rcx;
+const Reg ARG1 = Reg::rdx;
+#else
+const Reg ARG0 = Reg::rdi;
+const Reg ARG1 = Reg::rsi;
+#endif
+
+// Register allocation inside compiled block:
+// rbx - CPU*
+// r12 - expected PC after handler call in branch delay slot
+// r13 - number of executed instructions (exception exit path)
+// r14 - fastmem arena base
+const Reg CPU_STATE = Reg::rbx;
+const Reg FASTMEM_BASE = Reg::r14;
+
+static bool isBranch(Opcode i) {
+    if (i.op >= 1 && i.op <= 7) return true;                    // REGIMM, j, jal, beq, bne, blez, bgtz
+    if (i.op == 0 && (i.fun == 8 || i.fun == 9)) return true;  // jr, jalr
+    return false;
+}
+
+static instructions::_Instruction handlerFor(Opcode i) {
+    if (i.op == 0) return instructions::SpecialTable[i.fun].instruction;
+    return instructions::OpcodeTable[i.op].instruction;
+}
+
+static bool endsBlock(Opcode i) {
+    if (i.op == 16) return true;                                 // COP0 - mtc0 or rfe can enable pending interrupt
+    if (i.op == 0 && (i.fun == 12 || i.fun == 13)) return true;  // syscall, break
+    if (handlerFor(i) == instructions::invalid) return true;
+    return false;
+}
+
+// Handlers which do not throw exceptions, use PC or Load Delay slots
+static bool isPureCall(Opcode i) {
+    return i.op == 0 && (i.fun == 26 || i.fun == 27);  // div, divu
+}
+
+// lb, lh, lw, lbu, lhu, sb, sh, sw - translated to host code with fastmem enabled
+static bool isMemoryAccess(Opcode i) {
+    switch (i.op) {
+        case 32:
+        case 33:
+        case 35:
+        case 36:
+        case 37:
+        case 40:
+        case 41:
+        case 43: return true;
+        default: return false;
+    }
+}
+
+static bool isNative(Opcode i) {
+    if (i.op == 0) {
+        switch (i.fun) {
+            case 0:   // sll
+            case 2:   // srl
+            case 3:   // sra
+            case 4:   // sllv
+            case 6:   // srlv
+            case 7:   // srav
+            case 16:  // mfhi
+            case 17:  // mthi
+            case 18:  // mflo
+            case 19:  // mtlo
+            case 24:  // mult
+            case 25:  // multu
+            case 33:  // addu
+            case 35:  // subu
+            case 36:  // and
+            case 37:  // or
+            case 38:  // xor
+            case 39:  // nor
+            case 42:  // slt
+            case 43:  // sltu
+                return true;
+            default: return false;
+        }
+    }
+    return (i.op >= 1 && i.op <= 7)      // branches
+           || (i.op >= 9 && i.op <= 15);  // addiu, slti, sltiu, andi, ori, xori, lui
+}
+
+Recompiler::Recompiler(CPU* cpu, System* sys) : cpu(cpu), sys(sys), buffer(CODE_BUFFER_SIZE) {
+    ramBlocks.resize(sys->ram.size() / 4);
+    biosBlocks.resize(System::BIOS_SIZE / 4);
+
+    if (sys->fastmemArena) {
+        fastmemBase = sys->fastmemArena->data();
+        fastmemPatches.assign(FASTMEM_PATCH_SLOTS, FastmemPatch());
+        sys->fastmemArena->setFaultHandler(handleFastmemFault, this);
+    }
+}
+
+Recompiler::~Recompiler() {
+    if (sys->fastmemArena) sys->fastmemArena->setFaultHandler(nullptr, nullptr);
+}
+
+// Runs in the signal handler - must not allocate or take locks
+uintptr_t Recompiler::handleFastmemFault(void* context, uintptr_t pc) {
+    auto recompiler = static_cast<Recompiler*>(context);
+    auto& patches = recompiler->fastmemPatches;
+    if (patches.empty()) return 0;
+
+    for (size_t slot = fastmemSlot(pc);; slot = (slot + 1) % FASTMEM_PATCH_SLOTS) {
+        FastmemPatch& patch = patches[slot];
+        if (patch.site == 0) return 0;
+        if (patch.site != pc) continue;
+        if (patch.applied) return 0;
+
+        // Access to unmapped page (most likely IO) - use slow path from now on
+        Emitter::patchJump(reinterpret_cast<uint8_t*>(pc), patch.length, reinterpret_cast<const void*>(patch.slowPath));
+        patch.applied = true;
+        return patch.slowPath;
+    }
+}
+
+void Recompiler::addFastmemPatch(uintptr_t site, uintptr_t slowPath, size_t length) {
+    size_t slot = fastmemSlot(site);
+    while (fastmemPatches[slot].site != 0 && fastmemPatches[slot].site != site) {
+        slot = (slot + 1) % FASTMEM_PATCH_SLOTS;
+    }
+
+    FastmemPatch& patch = fastmemPatches[slot];
+    if (patch.site == 0) fastmemPatchCount++;
+    patch.slowPath = slowPath;
+    patch.length = length;
+    patch.applied = false;
+    patch.site = site;  // Written last, slot is complete once it is visible to the handler
+}
+
+std::unique_ptr<Block>* Recompiler::lookup(uint32_t address) {
+    uint32_t phys = address & 0x1fff'ffff;
+    if (in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(phys)) {
+        return &ramBlocks[((phys - System::RAM_BASE) & (sys->ram.size() - 1)) / 4];
+    }
+    if (in_range<System::BIOS_BASE, System::BIOS_SIZE>(phys)) {
+        return &biosBlocks[(phys - System::BIOS_BASE) / 4];
+    }
+    return nullptr;
+}
+
+int Recompiler::execute(int count) {
+    int executed = 0;
+    Block* previous = nullptr;
+    while (executed < count && likely(!cpu->breakpointsEnabled) && likely(!sys->scheduler.yieldCpu)) {
+        Block* block = nullptr;
+        if (cpu->nextPC == cpu->PC + 4) {
+            if (auto entry = lookup(cpu->PC); entry != nullptr) {
+                if (*entry && (*entry)->pc == cpu->PC) {
+                    block = entry->get();
+                } else {
+                    block = compile(cpu->PC);
+                    previous = nullptr;
+                }
+            }
+        }
+
+        // Code outside RAM and BIOS or jump in Branch Delay slot
+        if (block == nullptr) {
+            cpu->interpret(1);
+            executed++;
+            previous = nullptr;
+            continue;
+        }
+
+#ifdef ENABLE_BIOS_HOOKS
+        uint32_t maskedPc = cpu->PC & 0x1fff'ffff;
+        if (maskedPc == 0xa0 || maskedPc == 0xb0 || maskedPc == 0xc0) {
+            // Function was executed natively, CPU returned to the caller
+            if (int charged = sys->handleBiosFunction(); charged != 0) {
+                executed += charged;
+                previous = nullptr;
+                continue;
+            }
+        }
+#endif
+
+        cpu->saveStateForException();
+        if (unlikely(cpu->attention)) {
+            cpu->checkForInterrupts();
+            if (cpu->PC != block->pc) {  // Interrupt taken
+                previous = nullptr;
+                continue;
+            }
+        }
+
+        // Block might be invalidated by its own write (idle loop never writes)
+        uint32_t pc = block->pc;
+        const IdleLoop* idleLoop = block->idleLoop.get();
+
+        int n = block->function(cpu);
+        executed += n;
+        sys->cycles += n;
+
+        // Idle loop iterated at least twice - nothing changes until next event
+        if (unlikely(idleLoop != nullptr) && block == previous && cpu->PC == pc) {
+            executed += idleLoop->skip(cpu, sys);
+        }
+        previous = block;
+    }
+    return executed;
+}
+
+Block* Recompiler::compile(uint32_t pc) {
+    if (buffer.freeSpace() < MAX_BLOCK_CODE_SIZE || fastmemPatchCount + MAX_BLOCK_INSTRUCTIONS + 1 > MAX_FASTMEM_PATCHES) {
+        cpu->invalidateAllCode();
+    }
+
+    std::vector<Instruction> block;
+    auto startEntry = lookup(pc);
+    bool inDelaySlot = false;
+    for (uint32_t address = pc;; address += 4) {
+        // Stop at region boundary (or RAM mirror wrap)
+        if (lookup(address) != startEntry + block.size()) break;
+
+        Opcode opcode(sys->readMemory32(address));
+        bool branch = isBranch(opcode);
+        if (inDelaySlot && branch) break;  // Leave branch in delay slot to the interpreter
+
+        bool native = isNative(opcode) || (fastmemBase != nullptr && isMemoryAccess(opcode));
+        bool load = native && isMemoryAccess(opcode) && opcode.op < 40;
+        block.push_back({address, opcode, inDelaySlot, native, (!native && !isPureCall(opcode)) || load});
+
+        if (inDelaySlot) break;
+        if (branch) {
+            inDelaySlot = true;
+            continue;
+        }
+        if (endsBlock(opcode) || block.size() >= MAX_BLOCK_INSTRUCTIONS) break;
+    }
+    if (block.empty()) return nullptr;
+
+    e.clear();
+    blockFastmemSites.clear();
+    std::vector<Label> exceptionExits(block.size());
+    std::vector<Label> slowPaths(block.size()), resumes(block.size());
+    Label exceptionExit, exit, finish;
+
+    emitPrologue();
+    for (size_t n = 0; n < block.size(); n++) {
+        const auto& i = block[n];
+        bool slotLive = n == 0 || block[n - 1].mayLoad;
+
+        if (i.native && isMemoryAccess(i.opcode)) {
+            emitMemoryAccess(i, slotLive, slowPaths[n]);
+            e.bind(resumes[n]);
+        } else if (i.native) {
+            emitNative(i, slotLive);
+        } else {
+            emitCall(i, n == 0, exceptionExits[n]);
+        }
+
+        if (n == 0 || block[n - 1].mayLoad || i.mayLoad) {
+            emitMoveLoadDelaySlots();
+        }
+    }
+
+    // Leave CPU in the same state as interpreter would (handler calls other than div/divu update PC themselves)
+    const auto& last = block.back();
+    bool updatePC = last.native || isPureCall(last.opcode);
+    if (last.inDelaySlot) {
+        if (updatePC) {
+            e.mov(Reg::rax, state(&cpu->nextPC));
+            e.mov(state(&cpu->PC), Reg::rax);
+            e.alu(AluOp::add, Reg::rax, 4);
+            e.mov(state(&cpu->nextPC), Reg::rax);
+            e.mov8(state(&cpu->inBranchDelay), 0);
+            e.mov8(state(&cpu->branchTaken), 0);
+        }
+    } else if (updatePC) {
+        e.mov(state(&cpu->PC), last.address + 4);
+        if (!isBranch(last.opcode)) {
+            e.mov(state(&cpu->nextPC), last.address + 8);
+        }
+    }
+    e.bind(finish);
+    e.mov(Reg::rax, static_cast<uint32_t>(block.size()));
+
+    e.bind(exit);
+    emitEpilogue();
+
+    // Fastmem slow path (misaligned access, write to RAM with code or isolated cache, patched faulting access)
+    for (size_t n = 0; n < block.size(); n++) {
+        const auto& i = block[n];
+        if (!i.native || !isMemoryAccess(i.opcode)) continue;
+
+        e.bind(slowPaths[n]);
+        emitCall(i, n == 0, exceptionExits[n]);
+        if (n + 1 < block.size()) {
+            e.jmp(resumes[n]);
+            continue;
+        }
+
+        // Handler has already updated PC, skip the update at the end of block
+        if (n == 0 || block[n - 1].mayLoad || i.mayLoad) {
+            emitMoveLoadDelaySlots();
+        }
+        e.jmp(finish);
+    }
+
+    // Handler has thrown an exception, finish current instruction and leave the block
+    for (size_t n = 0; n < block.size(); n++) {
+        if (exceptionExits[n].patches.empty()) continue;
+        e.bind(exceptionExits[n]);
+        e.mov(Reg::r13, static_cast<uint32_t>(n + 1));
+        e.jmp(exceptionExit);
+    }
+    e.bind(exceptionExit);
+    emitMoveLoadDelaySlots();
+    e.mov(Reg::rax, Reg::r13);
+    e.jmp(exit);
+
+    void* code = buffer.append(e.data().data(), e.size());
+    if (code == nullptr) {
+        fmt::print("[CPU] Recompiler code buffer exhausted\n");
+        return nullptr;
+    }
+
+    auto hostCode = static_cast<uint8_t*>(code);
+    for (const auto& site : blockFastmemSites) {
+        auto slowPath = reinterpret_cast<uintptr_t>(hostCode + site.slowPath->position);
+        addFastmemPatch(reinterpret_cast<uintptr_t>(hostCode + site.offset), slowPath, site.length);
+    }
+
+    uint32_t size = static_cast<uint32_t>(block.size() * 4);
+    std::vector<Opcode> opcodes;
+    for (const auto& i : block) opcodes.push_back(i.opcode);
+    *startEntry = std::make_unique<Block>(Block{pc, size, reinterpret_cast<BlockFunction>(code), IdleLoop::detect(pc, opcodes)});
+
+    uint32_t phys = pc & 0x1fff'ffff;
+    if (in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(phys)) {
+        uint32_t ramAddress = (phys - System::RAM_BASE) & (sys->ram.size() - 1);
+        for (uint32_t a = ramAddress; a < ramAddress + size; a += 4) {
+            cpu->codePages[a >> CPU::CODE_PAGE_SHIFT] = 1;
+        }
+    }
+
+    return startEntry->get();
+}
+
+void Recompiler::invalidatePage(uint32_t page) {
+    uint32_t begin = page << CPU::CODE_PAGE_SHIFT;
+    uint32_t end = begin + (1 << CPU::CODE_PAGE_SHIFT);
+
+    // Blocks starting in previous page might overlap with this one
+    uint32_t address = begin >= MAX_BLOCK_SIZE ? begin - MAX_BLOCK_SIZE : 0;
+    for (; address < end; address += 4) {
+        auto& block = ramBlocks[address / 4];
+        if (block && address + block->size > begin) {
+            block.reset();
+        }
+    }
+}
+
+void Recompiler::invalidateAll() {
+    for (auto& block : ramBlocks) block.reset();
+    for (auto& block : biosBlocks) block.reset();
+    ramBlocks.resize(sys->ram.size() / 4);  // RAM size might change after loading save state
+    buffer.reset();
+    fastmemBase = sys->fastmemArena ? sys->fastmemArena->data() : nullptr;
+    fastmemPatches.assign(fastmemBase != nullptr ? FASTMEM_PATCH_SLOTS : 0, FastmemPatch());
+    fastmemPatchCount = 0;
+}
+
+Mem Recompiler::state(const void* field) const {
+    return Mem(CPU_STATE, static_cast<int32_t>(static_cast<const uint8_t*>(field) - reinterpret_cast<const uint8_t*>(cpu)));
+}
+
+Mem Recompiler::reg(uint32_t r) const { return state(&cpu->reg[r]); }
+
+void Recompiler::loadReg(Reg dst, uint32_t r) {
+    if (r == 0) {
+        e.mov(dst, 0u);
+    } else {
+        e.mov(dst, reg(r));
+    }
+}
+
+// Equivalent of CPU::setReg
+void Recompiler::storeReg(uint32_t r, Reg src, bool slotLive) {
+    if (r == 0) return;
+    e.mov(reg(r), src);
+
+    if (slotLive) {
+        Label skip;
+        e.alu(AluOp::cmp, state(&cpu->slots[0].reg), r);
+        e.jcc(Cond::ne, skip);
+        e.mov(state(&cpu->slots[0].reg), static_cast<uint32_t>(DUMMY_REG));
+        e.bind(skip);
+    }
+}
+
+void Recompiler::emitPrologue() {
+    // 4 pushes + return address + 8 bytes of padding keep the stack 16 byte aligned, 32 bytes is Win64 shadow space
+    e.push(Reg::rbx);
+    e.push(Reg::r12);
+    e.push(Reg::r13);
+    e.push(Reg::r14);
+    e.alu64(AluOp::sub, Reg::rsp, 40);
+    e.mov64(CPU_STATE, ARG0);
+    if (fastmemBase != nullptr) {
+        e.mov64(FASTMEM_BASE, reinterpret_cast<uint64_t>(fastmemBase));
+    }
+}
+
+void Recompiler::emitEpilogue() {
+    e.alu64(AluOp::add, Reg::rsp, 40);
+    e.pop(Reg::r14);
+    e.pop(Reg::r13);
+    e.pop(Reg::r12);
+    e.pop(Reg::rbx);
+    e.ret();
+}
+
+// Equivalent of CPU::moveLoadDelaySlots
+void Recompiler::emitMoveLoadDelaySlots() {
+    e.mov(Reg::rax, state(&cpu->slots[0].reg));
+    e.mov(Reg::rcx, state(&cpu->slots[0].data));
+    e.mov(Mem(CPU_STATE, Reg::rax, 4, reg(0).disp), Reg::rcx);
+    e.mov64(Reg::rax, state(&cpu->slots[1]));
+    e.mov64(state(&cpu->slots[0]), Reg::rax);
+    e.mov(state(&cpu->slots[1].reg), static_cast<uint32_t>(DUMMY_REG));
+}
+
+void Recompiler::emitNative(const Instruction& ins, bool slotLive) {
+    Opcode i = ins.opcode;
+    uint32_t imm = i.imm;
+    uint32_t simm = static_cast<uint32_t>(static_cast<int32_t>(i.offset));
+
+    auto shiftImm = [&](ShiftOp op) {
+        if (i.rd == 0) return;
+        loadReg(Reg::rax, i.rt);
+        if (i.sh != 0) e.shift(op, Reg::rax, i.sh);
+        storeReg(i.rd, Reg::rax, slotLive);
+    };
+    auto shiftVar = [&](ShiftOp op) {
+        if (i.rd == 0) return;
+        loadReg(Reg::rcx, i.rs);
+        loadReg(Reg::rax, i.rt);
+        e.shiftCl(op, Reg::rax);
+        storeReg(i.rd, Reg::rax, slotLive);
+    };
+    auto aluReg = [&](AluOp op, bool invert = false) {
+        if (i.rd == 0) return;
+        loadReg(Reg::rax, i.rs);
+        e.alu(op, Reg::rax, reg(i.rt));
+        if (invert) e.not_(Reg::rax);
+        storeReg(i.rd, Reg::rax, slotLive);
+    };
+    auto aluImm = [&](AluOp op, uint32_t value) {
+        if (i.rt == 0) return;
+        loadReg(Reg::rax, i.rs);
+        e.alu(op, Reg::rax, value);
+        storeReg(i.rt, Reg::rax, slotLive);
+    };
+    auto setOnReg = [&](Cond cond) {
+        if (i.rd == 0) return;
+        loadReg(Reg::rcx, i.rs);
+        e.alu(AluOp::cmp, Reg::rcx, reg(i.rt));
+        e.setcc(cond, Reg::rax);
+        e.movzx8(Reg::rax, Reg::rax);
+        storeReg(i.rd, Reg::rax, slotLive);
+    };
+    auto setOnImm = [&](Cond cond) {
+        if (i.rt == 0) return;
+        loadReg(Reg::rcx, i.rs);
+        e.alu(AluOp::cmp, Reg::rcx, simm);
+        e.setcc(cond, Reg::rax);
+        e.movzx8(Reg::rax, Reg::rax);
+        storeReg(i.rt, Reg::rax, slotLive);
+    };
+    auto move = [&](const void* from, const void* to) {
+        e.mov(Reg::rax, state(from));
+        e.mov(state(to), Reg::rax);
+    };
+
+    if (i.op == 0) {
+        switch (i.fun) {
+            case 0: shiftImm(ShiftOp::shl); break;
+            case 2: shiftImm(ShiftOp::shr); break;
+            case 3: shiftImm(ShiftOp::sar); break;
+            case 4: shiftVar(ShiftOp::shl); break;
+            case 6: shiftVar(ShiftOp::shr); break;
+            case 7: shiftVar(ShiftOp::sar); break;
+            case 16:
+                if (i.rd == 0) break;
+                e.mov(Reg::rax, state(&cpu->hi));
+                storeReg(i.rd, Reg::rax, slotLive);
+                break;
+            case 17: move(&cpu->reg[i.rs], &cpu->hi); break;
+            case 18:
+                if (i.rd == 0) break;
+                e.mov(Reg::rax, state(&cpu->lo));
+                storeReg(i.rd, Reg::rax, slotLive);
+                break;
+            case 19: move(&cpu->reg[i.rs], &cpu->lo); break;
+            case 24:
+            case 25:
+                if (i.fun == 24) {
+                    e.movsxd(Reg::rax, reg(i.rs));
+                    e.movsxd(Reg::rcx, reg(i.rt));
+                } else {
+                    e.mov(Reg::rax, reg(i.rs));
+                    e.mov(Reg::rcx, reg(i.rt));
+                }
+                e.imul64(Reg::rax, Reg::rcx);
+                e.mov(state(&cpu->lo), Reg::rax);
+                e.shr64(Reg::rax, 32);
+                e.mov(state(&cpu->hi), Reg::rax);
+                break;
+            case 33: aluReg(AluOp::add); break;
+            case 35: aluReg(AluOp::sub); break;
+            case 36: aluReg(AluOp::and_); break;
+            case 37: aluReg(AluOp::or_); break;
+            case 38: aluReg(AluOp::xor_); break;
+            case 39: aluReg(AluOp::or_, true); break;
+            case 42: setOnReg(Cond::l); break;
+            case 43: setOnReg(Cond::b); break;
+        }
+        return;
+    }
+
+    switch (i.op) {
+        case 1:
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+        case 6:
+        case 7: emitBranch(ins, slotLive); break;
+        case 9: aluImm(AluOp::add, simm); break;
+        case 10: setOnImm(Cond::l); break;
+        case 11: setOnImm(Cond::b); break;
+        case 12: aluImm(AluOp::and_, imm); break;
+        case 13: aluImm(AluOp::or_, imm); break;
+        case 14: aluImm(AluOp::xor_, imm); break;
+        case 15:
+            if (i.rt == 0) break;
+            e.mov(Reg::rax, imm << 16);
+            storeReg(i.rt, Reg::rax, slotLive);
+            break;
+    }
+}
+
+void Recompiler::emitBranch(const Instruction& ins, bool slotLive) {
+    Opcode i = ins.opcode;
+    uint32_t delaySlot = ins.address + 4;      // PC during branch execution
+    uint32_t returnAddress = ins.address + 8;  // nextPC during branch execution
+    uint32_t target = delaySlot + static_cast<int32_t>(i.offset) * 4;
+    bool conditional = true;
+    bool link = false;
+
+    e.mov8(state(&cpu->inBranchDelay), 1);
+    e.mov8(state(&cpu->branchTaken), 0);
+    e.mov(state(&cpu->nextPC), returnAddress);
+
+    // Condition is kept in dl
+    switch (i.op) {
+        case 1:  // bltz, bgez, bltzal, bgezal
+            loadReg(Reg::rax, i.rs);
+            e.alu(AluOp::cmp, Reg::rax, 0u);
+            e.setcc((i.rt & 1) ? Cond::ge : Cond::l, Reg::rdx);
+            link = (i.rt & 0x1e) == 0x10;
+            break;
+        case 2:  // j
+        case 3:  // jal
+            conditional = false;
+            link = i.op == 3;
+            target = (returnAddress & 0xf000'0000) | (i.target * 4);
+            break;
+        case 4:  // beq
+        case 5:  // bne
+            loadReg(Reg::rax, i.rs);
+            e.alu(AluOp::cmp, Reg::rax, reg(i.rt));
+            e.setcc(i.op == 4 ? Cond::e : Cond::ne, Reg::rdx);
+            break;
+        case 6:  // blez
+        case 7:  // bgtz
+            loadReg(Reg::rax, i.rs);
+            e.alu(AluOp::cmp, Reg::rax, 0u);
+            e.setcc(i.op == 6 ? Cond::le : Cond::g, Reg::rdx);
+            break;
+    }
+
+    if (link) {
+        e.mov(Reg::rcx, returnAddress);
+        storeReg(31, Reg::rcx, slotLive);
+    }
+
+    Label notTaken;
+    if (conditional) {
+        e.test8(Reg::rdx, Reg::rdx);
+        e.jcc(Cond::e, notTaken);
+    }
+    e.mov(state(&cpu->nextPC), target);
+    e.mov8(state(&cpu->branchTaken), 1);
+    if (conditional) e.bind(notTaken);
+}
+
+void Recompiler::emitMemoryAccess(const Instruction& ins, bool slotLive, Label& slowPath) {
+    Opcode i = ins.opcode;
+    bool store = i.op >= 40;
+    uint32_t alignMask = (i.op & 3) == 3 ? 3 : (i.op & 3);  // word, halfword or byte
+
+    loadReg(Reg::rcx, i.rs);
+    if (i.offset != 0) e.alu(AluOp::add, Reg::rcx, static_cast<uint32_t>(static_cast<int32_t>(i.offset)));
+    if (alignMask != 0) {
+        e.test(Reg::rcx, alignMask);  // Address error exception is thrown by the handler
+        e.jcc(Cond::ne, slowPath);
+    }
+
+    if (store) {
+        // Isolated cache redirects writes to icache, writes to RAM pages with code need invalidation
+        COP0::STATUS isolated;
+        isolated.isolateCache = 1;
+        e.test(state(&cpu->cop0.status), isolated._reg);
+        e.jcc(Cond::ne, slowPath);
+
+        Label notRam;
+        e.mov(Reg::rdx, Reg::rcx);
+        e.alu(AluOp::and_, Reg::rdx, 0x1fff'ffffu);
+        e.alu(AluOp::cmp, Reg::rdx, static_cast<uint32_t>(System::RAM_BASE + System::RAM_SIZE_8MB));
+        e.jcc(Cond::ae, notRam);
+        e.alu(AluOp::and_, Reg::rdx, static_cast<uint32_t>(sys->ram.size() - 1));
+        e.shift(ShiftOp::shr, Reg::rdx, CPU::CODE_PAGE_SHIFT);
+        e.mov64(Reg::rax, reinterpret_cast<uint64_t>(cpu->codePages.data()));
+        e.alu8(AluOp::cmp, Mem(Reg::rax, Reg::rdx, 1, 0), 0);
+        e.jcc(Cond::ne, slowPath);
+        e.bind(notRam);
+
+        loadReg(Reg::rax, i.rt);
+    }
+
+    Mem guest(FASTMEM_BASE, Reg::rcx, 1, 0);
+    size_t site = e.size();
+    switch (i.op) {
+        case 32: e.movsx8(Reg::rax, guest); break;
+        case 33: e.movsx16(Reg::rax, guest); break;
+        case 35: e.mov(Reg::rax, guest); break;
+        case 36: e.movzx8(Reg::rax, guest); break;
+        case 37: e.movzx16(Reg::rax, guest); break;
+        case 40: e.mov8(guest, Reg::rax); break;
+        case 41: e.mov16(guest, Reg::rax); break;
+        case 43: e.mov(guest, Reg::rax); break;
+    }
+    while (e.size() < site + 5) e.nop();  // Room for the jmp to slow path
+    blockFastmemSites.push_back({site, e.size() - site, &slowPath});
+
+    // Equivalent of CPU::loadDelaySlot
+    if (!store && i.rt != 0) {
+        if (slotLive) {
+            Label skip;
+            e.alu(AluOp::cmp, state(&cpu->slots[0].reg), i.rt);
+            e.jcc(Cond::ne, skip);
+            e.mov(state(&cpu->slots[0].reg), static_cast<uint32_t>(DUMMY_REG));
+            e.bind(skip);
+        }
+        e.mov(state(&cpu->slots[1].reg), i.rt);
+        e.mov(state(&cpu->slots[1].data), Reg::rax);
+    }
+}
+
+void Recompiler::emitCall(const Instruction& ins, bool firstInstruction, Label& exceptionExit) {
+    auto handler = handlerFor(ins.opcode);
+
+    if (isPureCall(ins.opcode)) {
+        e.mov64(ARG0, CPU_STATE);
+        e.mov(ARG1, ins.opcode.opcode);
+        e.call(reinterpret_cast<const void*>(handler));
+        return;
+    }
+
+    // Recreate state that CPU::saveStateForException and CPU::setPC would produce.
+    // For the first instruction saveStateForException is called before the block is entered.
+    if (ins.inDelaySlot) {
+        e.mov(state(&cpu->exceptionPC), ins.address);
+        e.movzx8(Reg::rax, state(&cpu->inBranchDelay));
+        e.mov8(state(&cpu->exceptionIsInBranchDelay), Reg::rax);
+        e.movzx8(Reg::rax, state(&cpu->branchTaken));
+        e.mov8(state(&cpu->exceptionIsBranchTaken), Reg::rax);
+        e.mov8(state(&cpu->inBranchDelay), 0);
+        e.mov8(state(&cpu->branchTaken), 0);
+
+        e.mov(Reg::r12, state(&cpu->nextPC));
+        e.mov(state(&cpu->PC), Reg::r12);
+        e.mov(Reg::rax, Reg::r12);
+        e.alu(AluOp::add, Reg::rax, 4);
+        e.mov(state(&cpu->nextPC), Reg::rax);
+    } else {
+        if (!firstInstruction) {
+            e.mov(state(&cpu->exceptionPC), ins.address);
+            e.mov8(state(&cpu->exceptionIsInBranchDelay), 0);
+            e.mov8(state(&cpu->exceptionIsBranchTaken), 0);
+        }
+        e.mov(state(&cpu->PC), ins.address + 4);
+        e.mov(state(&cpu->nextPC), ins.address + 8);
+    }
+
+    e.mov64(ARG0, CPU_STATE);
+    e.mov(ARG1, ins.opcode.opcode);
+    e.call(reinterpret_cast<const void*>(handler));
+
+    // Exception handler changes PC
+    if (ins.inDelaySlot) {
+        e.alu(AluOp::cmp, Reg::r12, state(&cpu->PC));
+    } else {
+        e.alu(AluOp::cmp, state(&cpu->PC), ins.address + 4);
+    }
+    e.jcc(Cond::ne, exceptionExit);
+}
+};  // namespace mips::recompiler
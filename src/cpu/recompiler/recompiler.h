@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "code_buffer.h"
+#include "cpu/idle_loop.h"
+#include "cpu/opcode.h"
+#include "emitter.h"
+
+/**
+ * Dynamic recompiler translating MIPS basic blocks to x86-64 code.
+ * Only available on x86-64 hosts, other platforms always use the interpreter.
+ */
+#if defined(__x86_64__) || defined(_M_X64)
+#define HAS_RECOMPILER
+#endif
+
+struct System;
+
+namespace mips {
+struct CPU;
+}
+
+namespace mips::recompiler {
+// Compiled block returns number of guest instructions executed
+typedef int (*BlockFunction)(CPU* cpu);
+
+struct Block {
+    uint32_t pc;    // Virtual address block was compiled for
+    uint32_t size;  // Size of guest code in bytes
+    BlockFunction function;
+    std::unique_ptr<IdleLoop> idleLoop;
+};
+
+struct Instruction {
+    uint32_t address;
+    Opcode opcode;
+    bool inDelaySlot;
+    bool native;   // Translated to host code, otherwise interpreter handler is called
+    bool mayLoad;  // Handler might modify Load Delay slots
+};
+
+class Recompiler {
+    static const int MAX_BLOCK_INSTRUCTIONS = 64;
+    static const uint32_t MAX_BLOCK_SIZE = (MAX_BLOCK_INSTRUCTIONS + 1) * 4;
+    static const size_t CODE_BUFFER_SIZE = 32 * 1024 * 1024;
+    static const size_t MAX_BLOCK_CODE_SIZE = 64 * 1024;
+
+    CPU* cpu;
+    System* sys;
+    CodeBuffer buffer;
+    Emitter e;
+
+    // Block cache indexed by (physical address / 4)
+    std::vector<std::unique_ptr<Block>> ramBlocks;
+    std::vector<std::unique_ptr<Block>> biosBlocks;
+
+    // Fastmem - loads and stores access the arena directly, access faulting on unmapped page (scratchpad, IO)
+    // is patched to jump to the slow path calling the interpreter handler
+    struct FastmemSite {
+        size_t offset;      // Offset of memory access in block code
+        size_t length;      // Bytes available for the patch (at least 5)
+        Label* slowPath;
+    };
+    struct FastmemPatch {
+        uintptr_t site = 0;  // Host address of memory access, 0 - empty slot
+        uintptr_t slowPath;
+        size_t length;
+        bool applied;
+    };
+    // Patches are looked up from the signal handler, so the table is an open addressing hash table
+    // allocated once - it never allocates or frees memory and applied entries are only marked as such.
+    static const size_t FASTMEM_PATCH_SLOTS = 1 << 18;
+    static const size_t MAX_FASTMEM_PATCHES = FASTMEM_PATCH_SLOTS / 2;  // Code cache is flushed when exceeded
+    uint8_t* fastmemBase = nullptr;
+    std::vector<FastmemSite> blockFastmemSites;  // Sites in currently compiled block
+    std::vector<FastmemPatch> fastmemPatches;
+    size_t fastmemPatchCount = 0;
+
+    static size_t fastmemSlot(uintptr_t site) { return (site * 0x9E3779B97F4A7C15ull) >> (64 - 18); }
+    void addFastmemPatch(uintptr_t site, uintptr_t slowPath, size_t length);
+
+    static uintptr_t handleFastmemFault(void* context, uintptr_t pc);
+
+    std::unique_ptr<Block>* lookup(uint32_t address);
+    Block* compile(uint32_t address);
+
+    // Code generation
+    Mem state(const void* field) const;
+    Mem reg(uint32_t r) const;
+    void loadReg(Reg dst, uint32_t r);
+    void storeReg(uint32_t r, Reg src, bool slotLive);
+    void emitPrologue();
+    void emitEpilogue();
+    void emitMoveLoadDelaySlots();
+    void emitNative(const Instruction& i, bool slotLive);
+    void emitBranch(const Instruction& i, bool slotLive);
+    void emitMemoryAccess(const Instruction& i, bool slotLive, Label& slowPath);
+    void emitCall(const Instruction& i, bool firstInstruction, Label& exceptionExit);
+
+   public:
+    Recompiler(CPU* cpu, System* sys);
+    ~Recompiler();
+    bool isValid() const { return buffer.isValid(); }
+
+    // Runs at least count instructions (or until breakpoint is set), returns number of executed instructions
+    int execute(int count);
+    void invalidatePage(uint32_t page);
+    void invalidateAll();
+};
+};  // namespace mips::recompiler
@@ -1,5 +1,6 @@
 #include "cdrom.h"
 #include <fmt/core.h>
+#include <algorithm>
 #include <cassert>
 #include <disc/track.h>
 #include "config.h"
@@ -168,30 +169,68 @@ void CDROM::handleSector() {
 
 void CDROM::step(int cycles) {
     if (!interruptQueue.is_empty()) {
-        interruptQueue.ref().delay -= cycles;
+        interruptQueue.ref().delay = std::max(interruptQueue.ref().delay - cycles, -1);
 
         if (interruptQueue.peek().delay <= 0) {
             status.transmissionBusy = 0;
-
-            if ((interruptEnable & 7) & (interruptQueue.peek().irq & 7)) {
-                sys->interrupt->trigger(interrupt::CDROM);
-            }
         }
     }
 
-    busyFor -= cycles;
+    busyFor = std::max(busyFor - cycles, -1);
     if (busyFor < 0) {
         status.transmissionBusy = 0;
     }
 
-    const int sectorsPerSecond = mode.speed ? 150 : 75;
-    const int cyclesPerSector = timing::CPU_CLOCK / sectorsPerSecond;
-
     readcnt += cycles;
-    for (int i = 0; i < readcnt / cyclesPerSector; i++) {
+    for (int i = 0; i < readcnt / cyclesPerSector(); i++) {
         handleSector();
     }
-    readcnt %= cyclesPerSector;
+    readcnt %= cyclesPerSector();
+}
+
+void CDROM::checkInterrupt() {
+    if (interruptQueue.is_empty() || interruptQueue.peek().delay > 0) return;
+
+    if ((interruptEnable & 7) & (interruptQueue.peek().irq & 7)) {
+        sys->interrupt->trigger(interrupt::CDROM);
+    }
+}
+
+void CDROM::update() {
+    uint64_t now = sys->scheduler.now() * 2 / 3;  // System cycles to CPU cycles
+    if (now == lastUpdate) return;
+
+    // Nothing is scheduled while drive is idle, so elapsed time might be long
+    step(static_cast<int>(std::min<uint64_t>(now - lastUpdate, timing::CPU_CLOCK)));
+    lastUpdate = now;
+}
+
+void CDROM::handleEvent() {
+    update();
+    checkInterrupt();
+    scheduleNext();
+}
+
+void CDROM::scheduleNext() {
+    int64_t cycles = INT64_MAX;
+    if (!interruptQueue.is_empty()) {
+        int delay = interruptQueue.peek().delay;
+        cycles = delay > 0 ? delay : IRQ_RECHECK_CYCLES;
+    }
+    if (stat.read || stat.play) {
+        cycles = std::min<int64_t>(cycles, cyclesPerSector() - readcnt);
+    }
+
+    if (cycles == INT64_MAX) {
+        sys->scheduler.cancel(Scheduler::Event::cdrom);
+        return;
+    }
+    sys->scheduler.schedule(Scheduler::Event::cdrom, ((lastUpdate + cycles) * 3 + 1) / 2);
+}
+
+void CDROM::reschedule() {
+    lastUpdate = sys->scheduler.now() * 2 / 3;
+    scheduleNext();
 }
 
 void CDROM::writeResponse(uint8_t byte) {
@@ -207,6 +246,13 @@ void CDROM::writeResponse(uint8_t byte) {
 }
 
 uint8_t CDROM::read(uint32_t address) {
+    update();
+    uint8_t data = readRegister(address);
+    if (address == 1) scheduleNext();  // Reading whole response acknowledges the interrupt
+    return data;
+}
+
+uint8_t CDROM::readRegister(uint32_t address) {
     if (address == 0) {  // CD Status
         // status.transmissionBusy = !interruptQueue.empty();
         if (verbose == 2) fmt::print("CDROM: R STATUS: 0x{:02x}\n", status._reg);
@@ -360,6 +406,12 @@ void CDROM::handleCommand(uint8_t cmd) {
 }
 
 void CDROM::write(uint32_t address, uint8_t data) {
+    update();
+    writeRegister(address, data);
+    scheduleNext();
+}
+
+void CDROM::writeRegister(uint32_t address, uint8_t data) {
     if (address == 0) {
         if (verbose == 3) fmt::print("CDROM: W INDEX: 0x{:02x}\n", data);
         status.index = data & 3;
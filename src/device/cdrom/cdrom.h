@@ -4,6 +4,7 @@
 #include <memory>
 #include "disc/disc.h"
 #include "fifo.h"
+#include "utils/timing.h"
 
 struct System;
 
@@ -182,6 +183,17 @@ class CDROM {
 
     void handleSector();
 
+    // Device state is updated lazily - on register access and on scheduled events (in CPU cycles)
+    uint64_t lastUpdate = 0;
+    // While interrupt is pending it is asserted again periodically
+    static const int IRQ_RECHECK_CYCLES = 200;
+
+    int cyclesPerSector() const { return timing::CPU_CLOCK / (mode.speed ? 150 : 75); }
+    void step(int cycles);
+    void checkInterrupt();
+    uint8_t readRegister(uint32_t address);
+    void writeRegister(uint32_t address, uint8_t data);
+
    public:
     std::deque<std::pair<int16_t, int16_t>> audio;
     std::vector<uint8_t> rawSector;
@@ -200,7 +212,10 @@ class CDROM {
     int previousTrack;  // for CDDA autopause
 
     CDROM(System* sys);
-    void step(int cycles);
+    void update();
+    void handleEvent();
+    void scheduleNext();
+    void reschedule();
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
 
@@ -214,6 +229,7 @@ class CDROM {
                 writeResponse(0x08);
             }
         }
+        scheduleNext();
     }
     bool getShell() const { return stat.getShell(); }
     void ackMoreData() {
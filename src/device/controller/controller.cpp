@@ -38,6 +38,7 @@ void Controller::handleByte(uint8_t byte) {
         }
         if (card[port]->state == 0) deviceSelected = DeviceSelected::None;
     }
+    reschedule();
 }
 
 Controller::Controller(System* sys) : sys(sys) {
@@ -81,6 +82,15 @@ void Controller::step() {
     if (irq) {
         sys->interrupt->trigger(interrupt::CONTROLLER);
     }
+    reschedule();
+}
+
+void Controller::reschedule() {
+    if (irqTimer > 0 || irq) {
+        sys->scheduler.scheduleIn(Scheduler::Event::controller, IRQ_TIMER_CYCLES);
+    } else {
+        sys->scheduler.cancel(Scheduler::Event::controller);
+    }
 }
 
 uint8_t Controller::read(uint32_t address) {
@@ -26,7 +26,10 @@ class Controller {
     Reg16 control;
     Reg16 baud;
     bool irq = false;
-    int irqTimer = 0;
+    int irqTimer = 0;  // in IRQ_TIMER_CYCLES units
+
+    // Controller is stepped only when ACK is pending
+    static const int IRQ_TIMER_CYCLES = 300;
 
     void handleByte(uint8_t byte);
 
@@ -50,6 +53,7 @@ class Controller {
     ~Controller();
     void reload();
     void step();
+    void reschedule();
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
     void update();
@@ -28,6 +28,7 @@ void DMA::reset() {
 }
 
 void DMA::step() {
+    bool running = false;
     for (int channel = 0; channel < 7; channel++) {
         dma[channel]->step();
         if (dma[channel]->irqFlag) {
@@ -37,12 +38,17 @@ void DMA::step() {
                 pendingInterrupt = status.calcMasterFlag();
             }
         }
+        if (dma[channel]->isRunning() && isChannelEnabled(static_cast<Channel>(channel))) running = true;
     }
 
     if (pendingInterrupt) {
         pendingInterrupt = false;
         sys->interrupt->trigger(interrupt::DMA);
     }
+
+    if (running) {
+        sys->scheduler.scheduleIn(Scheduler::Event::dma, POLL_CYCLES);
+    }
 }
 
 uint8_t DMA::read(uint32_t address) {
@@ -67,6 +73,7 @@ void DMA::write(uint32_t address, uint8_t data) {
         address += 0x80;
         if (address >= 0xF0 && address < 0xf4) {
             control._byte[address - 0xf0] = data;
+            sys->scheduler.schedule(Scheduler::Event::dma, sys->scheduler.now());
             return;
         }
         if (address >= 0xF4 && address < 0xf8) {
@@ -78,6 +85,9 @@ void DMA::write(uint32_t address, uint8_t data) {
     }
 
     dma[channel]->write(address % 0x10, data);
+    if (address % 0x10 == 0xb) {  // Channel started
+        sys->scheduler.schedule(Scheduler::Event::dma, sys->scheduler.now());
+    }
 }
 
 bool DMA::isChannelEnabled(Channel ch) {
@@ -102,6 +102,9 @@ class DMA {
 
     System* sys;
 
+    // Channels waiting for device (DREQ) are polled
+    static const int POLL_CYCLES = 300;
+
    public:
     DMA(System* sys);
     void reset();
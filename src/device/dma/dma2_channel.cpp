@@ -7,4 +7,8 @@ DMA2Channel::DMA2Channel(Channel channel, System *sys, gpu::GPU *gpu) : DMAChann
 uint32_t DMA2Channel::readDevice() { return gpu->read(0); }
 
 void DMA2Channel::writeDevice(uint32_t data) { gpu->write(0, data); }
+
+void DMA2Channel::writeDevicePacket(const uint32_t* data, size_t count) { gpu->writePacket(data, count); }
+
+void DMA2Channel::readDevicePacket(uint32_t* data, size_t count) { gpu->readPacket(data, count); }
 }  // namespace device::dma
\ No newline at end of file
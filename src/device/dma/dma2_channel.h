@@ -11,6 +11,8 @@ class DMA2Channel : public DMAChannel {
 
     uint32_t readDevice() override;
     void writeDevice(uint32_t data) override;
+    void writeDevicePacket(const uint32_t* data, size_t count) override;
+    void readDevicePacket(uint32_t* data, size_t count) override;
 
    public:
     DMA2Channel(Channel channel, System *sys, gpu::GPU *gpu);
@@ -1,9 +1,11 @@
 #include "dma_channel.h"
 #include <fmt/core.h>
+#include <algorithm>
+#include <array>
 #include <magic_enum.hpp>
 #include "config.h"
 #include "system.h"
-#include <unordered_set>
+#include "utils/address.h"
 
 namespace device::dma {
 DMAChannel::DMAChannel(Channel channel, System* sys) : channel(channel), sys(sys) { verbose = config.debug.log.dma; }
@@ -14,6 +16,18 @@ uint32_t DMAChannel::readDevice() { return 0; }
 
 void DMAChannel::writeDevice(uint32_t data) { (void)data; }
 
+void DMAChannel::writeDevicePacket(const uint32_t* data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        writeDevice(data[i]);
+    }
+}
+
+void DMAChannel::readDevicePacket(uint32_t* data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        data[i] = readDevice();
+    }
+}
+
 uint8_t DMAChannel::read(uint32_t address) {
     if (address < 0x4) return baseAddress._byte[address];
     if (address >= 0x4 && address < 0x8) return count._byte[address - 4];
@@ -68,15 +82,7 @@ void DMAChannel::burstTransfer() {
                    addr, magic_enum::enum_name(control.syncMode), wordCount);
         canLog = false;
     }
-    if (control.direction == CHCR::Direction::toRam) {
-        for (size_t i = 0; i < wordCount; i++, addr += control.step()) {
-            sys->writeMemory32(addr, readDevice());
-        }
-    } else if (control.direction == CHCR::Direction::fromRam) {
-        for (size_t i = 0; i < wordCount; i++, addr += control.step()) {
-            writeDevice(sys->readMemory32(addr));
-        }
-    }
+    transferWords(addr, wordCount);
 
     irqFlag = true;
     control.enabled = CHCR::Enabled::completed;
@@ -98,15 +104,7 @@ hack_transferLoop:
 
     // TODO: DREQ DACK for MDEC
     // TODO: Execute sync with chopping
-    if (control.direction == CHCR::Direction::toRam) {
-        for (int i = 0; i < count.syncMode1.blockSize; i++, addr += control.step()) {
-            sys->writeMemory32(addr, readDevice());
-        }
-    } else if (control.direction == CHCR::Direction::fromRam) {
-        for (int i = 0; i < count.syncMode1.blockSize; i++, addr += control.step()) {
-            writeDevice(sys->readMemory32(addr));
-        }
-    }
+    transferWords(addr, count.syncMode1.blockSize);
     // TODO: Need proper Chopping implementation for SPU READ to work
 
     baseAddress.address = addr;
@@ -119,6 +117,38 @@ hack_transferLoop:
     }
 }
 
+void DMAChannel::transferWords(uint32_t& addr, size_t count) {
+    if (control.direction == CHCR::Direction::toRam) {
+        // Device is read in chunks, RAM is written word by word to keep cached code invalidated
+        std::array<uint32_t, 256> buffer;
+        for (size_t i = 0; i < count; i += buffer.size()) {
+            const size_t n = std::min(count - i, buffer.size());
+            readDevicePacket(buffer.data(), n);
+            for (size_t j = 0; j < n; j++, addr += control.step()) {
+                sys->writeMemory32(addr, buffer[j]);
+            }
+        }
+    } else if (control.direction == CHCR::Direction::fromRam) {
+        if (const uint32_t* words = ramWords(addr, count); words != nullptr && control.step() > 0) {
+            writeDevicePacket(words, count);
+            addr += static_cast<uint32_t>(count) * 4;
+        } else {
+            for (size_t i = 0; i < count; i++, addr += control.step()) {
+                writeDevice(sys->readMemory32(addr));
+            }
+        }
+    }
+}
+
+const uint32_t* DMAChannel::ramWords(uint32_t address, int count) const {
+    uint32_t addr = address & 0xffffff & ~3;
+    if (!in_range<System::RAM_BASE, System::RAM_SIZE_8MB>(addr)) return nullptr;
+
+    uint32_t offset = (addr - System::RAM_BASE) & (sys->ram.size() - 1);
+    if (offset + count * 4 > sys->ram.size()) return nullptr;
+    return reinterpret_cast<const uint32_t*>(sys->ram.data() + offset);
+}
+
 void DMAChannel::linkedListTransfer() {
     uint32_t addr = baseAddress.address;
 
@@ -128,8 +158,13 @@ void DMAChannel::linkedListTransfer() {
         canLog = false;
     }
 
+    // List which revisits a node never ends. Nodes are compared with one saved at power of two intervals
+    // (Brent's cycle detection), so a loop is found within twice the list length without remembering every node.
+    uint32_t savedNode = addr;
+    size_t interval = 1;
+    size_t nodes = 0;
+
     // TODO: Break execution in between
-    std::unordered_set<uint32_t> visited;
     for (;;) {
         uint32_t blockInfo = sys->readMemory32(addr);
         int commandCount = blockInfo >> 24;
@@ -141,18 +176,26 @@ void DMAChannel::linkedListTransfer() {
         }
 
         addr += control.step();
-        for (int i = 0; i < commandCount; i++, addr += control.step()) {
-            writeDevice(sys->readMemory32(addr));
+        if (const uint32_t* packet = ramWords(addr, commandCount); packet != nullptr && control.step() > 0) {
+            writeDevicePacket(packet, commandCount);
+        } else {
+            for (int i = 0; i < commandCount; i++, addr += control.step()) {
+                writeDevice(sys->readMemory32(addr));
+            }
         }
 
         addr = nextAddr;
         if (addr == 0xffffff || addr == 0) break;
 
-        if (visited.find(addr) != visited.end()) {
-            fmt::print("[DMA{}] GPU DMA transfer loop detected, breaking.\n", (int)channel);
+        if (addr == savedNode) {
+            fmt::print("[DMA{}] GPU DMA transfer loop detected at 0x{:06x}, breaking.\n", (int)channel, addr);
             break;
         }
-        visited.insert(addr);
+        if (++nodes == interval) {
+            savedNode = addr;
+            interval *= 2;
+            nodes = 0;
+        }
     }
 
     baseAddress.address = addr;
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include "device/device.h"
 
 struct System;
@@ -91,11 +92,17 @@ class DMAChannel {
 
     virtual uint32_t readDevice();
     virtual void writeDevice(uint32_t data);
+    virtual void writeDevicePacket(const uint32_t* data, size_t count);
+    virtual void readDevicePacket(uint32_t* data, size_t count);
     virtual void maskControl();
 
     virtual void burstTransfer();
     void syncBlockTransfer();
     void linkedListTransfer();
+    void transferWords(uint32_t& addr, size_t count);  // Block of burst and sync 1 transfers
+
+    // Host pointer to count words at address, nullptr if they are not entirely inside of single RAM mirror
+    const uint32_t* ramWords(uint32_t address, int count) const;
 
     // DACK/DREQ
     virtual bool dataRequest() { return true; }
@@ -109,6 +116,7 @@ class DMAChannel {
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
     void step();
+    bool isRunning() const { return control.enabled == CHCR::Enabled::start; }
 
     template <class Archive>
     void serialize(Archive& ar) {
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gpu {
+
+// Arguments of logged command, valid until the log is modified
+struct LogArgs {
+    const uint32_t* data = nullptr;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+    const uint32_t& operator[](size_t i) const { return data[i]; }
+    const uint32_t* begin() const { return data; }
+    const uint32_t* end() const { return data + count; }
+};
+
+// Debug/rewind
+struct LogEntry {
+    uint8_t type;  // 0 - gp0, 1 - gp1
+    LogArgs args;
+
+    uint8_t cmd() const { return (args[0] >> 24) & 0xff; }
+};
+
+/**
+ * GP0/GP1 commands recorded during draw list capture.
+ * Entries are stored back to back in one buffer using GpuDrawList file layout -
+ * header word (type << 24 | argument count) followed by the arguments.
+ */
+class CommandLog {
+    // Enough for a few frames of commands, buffer grows if capture needs more
+    static const size_t INITIAL_CAPACITY = 1024 * 1024;
+
+    std::vector<uint32_t> words;
+    std::vector<uint32_t> headers;  // Position of header of every entry in words
+
+   public:
+    size_t size() const { return headers.size(); }
+    bool empty() const { return headers.empty(); }
+
+    // Raw entries, as written to the GpuDrawList file
+    const std::vector<uint32_t>& data() const { return words; }
+
+    LogEntry operator[](size_t i) const {
+        uint32_t header = words[headers[i]];
+        return LogEntry{static_cast<uint8_t>(header >> 24), LogArgs{&words[headers[i] + 1], header & 0xffffff}};
+    }
+
+    void clear() {
+        words.clear();
+        headers.clear();
+    }
+
+    void reserve() {
+        words.reserve(INITIAL_CAPACITY);
+        headers.reserve(INITIAL_CAPACITY / 4);
+    }
+
+    void push(uint8_t type, const uint32_t* args, size_t count) {
+        headers.push_back(static_cast<uint32_t>(words.size()));
+        words.push_back((type << 24) | static_cast<uint32_t>(count));
+        words.insert(words.end(), args, args + count);
+    }
+
+    void push(uint8_t type, uint32_t word) { push(type, &word, 1); }
+    void pushGP0(uint8_t cmd, uint32_t data) { push(0, (cmd << 24) | (data & 0x00ffffff)); }
+    void pushGP1(uint8_t cmd, uint32_t data) { push(1, (cmd << 24) | (data & 0x00ffffff)); }
+
+    // Adds argument to one of the last few entries with given GP0 command (data words of CPU -> VRAM transfer)
+    void append(uint8_t cmd, uint32_t arg) {
+        const size_t SEARCH_DEPTH = 6;
+        for (size_t n = 0; n < SEARCH_DEPTH && n < headers.size(); n++) {
+            size_t i = headers.size() - 1 - n;
+            uint32_t header = words[headers[i]];
+            if ((header >> 24) != 0 || (header & 0xffffff) == 0 || (words[headers[i] + 1] >> 24) != cmd) continue;
+
+            // Entries logged after the transfer started (GP1 writes) are moved by one word
+            words[headers[i]]++;
+            words.insert(words.begin() + headers[i] + 1 + (header & 0xffffff), arg);
+            for (size_t j = i + 1; j < headers.size(); j++) headers[j]++;
+            return;
+        }
+    }
+};
+}  // namespace gpu
@@ -1,8 +1,10 @@
 #include "gpu.h"
 #include <fmt/core.h>
 #include <cassert>
+#include <cstring>
 #include "config.h"
 #include "render/render.h"
+#include "render/tile_renderer.h"
 #include "system.h"
 #include "utils/file.h"
 #include "utils/logic.h"
@@ -13,23 +15,223 @@
 #include <stb_image_write.h>
 
 namespace gpu {
+struct MaskCopy {
+    constexpr static int x(int x) { return x & 0x3ff; }
+    constexpr static int y(int y) { return y & 0x1ff; }
+    constexpr static int w(int w) { return ((w - 1) & 0x3ff) + 1; }
+    constexpr static int h(int h) { return ((h - 1) & 0x1ff) + 1; }
+};
+
 GPU::GPU(System* sys) : sys(sys) {
     busToken = bus.listen<Event::Config::Graphics>([&](auto) { reload(); });
     reload();
     reset();
 }
 
-GPU::~GPU() { bus.unlistenAll(busToken); }
+GPU::~GPU() {
+    bus.unlistenAll(busToken);
+    stopThread();
+}
 
 void GPU::reload() {
+    stopThread();
+
     verbose = config.debug.log.gpu;
     forceNtsc = config.options.graphics.forceNtsc;
     auto mode = config.options.graphics.renderingMode;
     softwareRendering = (mode & RenderingMode::software) != 0;
     hardwareRendering = (mode & RenderingMode::hardware) != 0;
+
+    int threads = softwareRendering ? config.options.graphics.rendererThreads : 0;
+    tileRenderer.reset();
+    if (threads > 0) {
+        tileRenderer = std::make_unique<TileRenderer>(this, threads);
+    }
+
+    if (config.options.graphics.asyncGpu) {
+        startThread();
+    }
+}
+
+void GPU::startThread() {
+    gp0Fifo = std::make_unique<SpscQueue<uint32_t, GP0_FIFO_SIZE>>();
+    loadGP0Shadow();
+    threadExit = false;
+    thread = std::thread(&GPU::threadFunc, this);
+}
+
+void GPU::stopThread() {
+    if (!thread.joinable()) return;
+
+    sync();
+    {
+        std::unique_lock<std::mutex> lk(threadMutex);
+        threadExit = true;
+        threadWakeUp.notify_one();
+    }
+    thread.join();
+    gp0Fifo.reset();
+}
+
+void GPU::threadFunc() {
+    // Words are released in batches, emulation thread waits for the whole batch when it synchronizes
+    const size_t MAX_BATCH = 1024;
+
+    for (;;) {
+        size_t count = std::min(gp0Fifo->contiguous(), MAX_BATCH);
+        if (count == 0) {
+            std::unique_lock<std::mutex> lk(threadMutex);
+            threadSleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);  // Pairs with the fence in pushGP0
+            threadWakeUp.wait(lk, [&] { return threadExit || !gp0Fifo->empty(); });
+            threadSleeping.store(false, std::memory_order_relaxed);
+
+            if (threadExit) return;
+            continue;
+        }
+
+        writeGP0(&gp0Fifo->peek(), count);
+        gp0Fifo->pop(count);
+    }
+}
+
+void GPU::pushGP0(const uint32_t* data, size_t count) {
+    trackGP0(data, count);
+
+    for (;;) {
+        size_t pushed = gp0Fifo->push(data, count);
+        data += pushed;
+        count -= pushed;
+        if (count == 0) break;
+
+        std::this_thread::yield();
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (threadSleeping.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> lk(threadMutex);
+        threadWakeUp.notify_one();
+    }
+}
+
+void GPU::sync() {
+    if (!gp0Fifo) return;
+
+    while (!gp0Fifo->empty()) {
+        std::this_thread::yield();
+    }
+
+    if (irqPending.exchange(false)) {
+        sys->interrupt->trigger(interrupt::IrqNumber::GPU);
+    }
+    loadGP0Shadow();
+}
+
+// Copy texture bits from Polygon draw command to E1 register
+// texpagex, texpagey, semi-transparency, texture disable bits
+const uint32_t E1_TEXPAGE_MASK = 0b00001001'11111111;
+
+uint32_t GPU::texpageToE1(uint32_t texpage) const {
+    uint32_t bits = (texpage >> 16) & E1_TEXPAGE_MASK;
+    if (!textureDisableAllowed) {
+        bits &= ~(1 << 11);
+    }
+    return bits;
+}
+
+static bool isTexturedPolygon(uint8_t command) { return command >= 0x20 && command < 0x40 && PolygonArgs(command).isTextureMapped; }
+
+// Argument with the texpage is the UV of the second vertex
+static int texpageArgument(uint8_t command) { return PolygonArgs(command).gouraudShading ? 5 : 4; }
+
+// Follows command boundaries the same way as writeGP0, without decoding the arguments
+void GPU::trackGP0(const uint32_t* data, size_t count) {
+    auto& s = gp0Shadow;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t word = data[i];
+
+        if (s.remaining == 0) {
+            uint8_t command = s.command = word >> 24;
+            s.argument = 1;
+            s.polyLine = false;
+            s.copyData = false;
+
+            if (command == 0x02) {
+                s.remaining = 2;
+            } else if (command >= 0x20 && command < 0x40) {
+                s.remaining = PolygonArgs(command).getArgumentCount();
+            } else if (command >= 0x40 && command < 0x60) {
+                s.remaining = LineArgs(command).getArgumentCount();
+                s.polyLine = LineArgs(command).polyLine;
+            } else if (command >= 0x60 && command < 0x80) {
+                s.remaining = RectangleArgs(command).getArgumentCount();
+            } else if (command >= 0x80 && command <= 0x9f) {
+                s.remaining = 3;
+            } else if (command >= 0xa0 && command <= 0xdf) {
+                s.remaining = 2;
+            } else if (command == 0xe1) {
+                s.e1._reg = word;
+                if (!textureDisableAllowed) {
+                    s.e1.textureDisable = false;
+                }
+            } else if (command == 0xe6) {
+                s.e6._reg = word;
+            } else if (command == 0x1f) {
+                irqRequest = true;
+            }
+            continue;
+        }
+
+        if (s.polyLine && (word & 0xf000f000) == 0x50005000) {
+            s.remaining = 0;
+            continue;
+        }
+
+        if (isTexturedPolygon(s.command) && s.argument == texpageArgument(s.command)) {
+            s.texpage = word;
+        }
+        s.argument++;
+
+        if (--s.remaining != 0) continue;
+
+        if (isTexturedPolygon(s.command)) {
+            s.e1._reg = (s.e1._reg & ~E1_TEXPAGE_MASK) | texpageToE1(s.texpage);
+        } else if (s.polyLine) {
+            s.remaining = LineArgs(s.command).getArgumentCount() - 1;
+        } else if (s.command >= 0xa0 && s.command <= 0xbf && !s.copyData) {
+            s.copyData = true;
+            s.remaining = (MaskCopy::w(word & 0xffff) * MaskCopy::h(word >> 16) + 1) / 2;
+        } else if (s.command >= 0xc0 && s.command <= 0xdf) {
+            s.vramRead = true;
+        }
+    }
+}
+
+// GPU thread must be idle
+void GPU::loadGP0Shadow() {
+    auto& s = gp0Shadow;
+    s.e1 = gp0_e1;
+    s.e6 = gp0_e6;
+    s.command = command;
+    s.argument = currentArgument;
+    if (isTexturedPolygon(command)) s.texpage = arguments[texpageArgument(command)];
+    s.polyLine = cmd == Command::Line && LineArgs(command).polyLine;
+    s.copyData = cmd == Command::CopyCpuToVram2;
+    s.vramRead = readMode == ReadMode::Vram;
+
+    if (cmd == Command::None) {
+        s.remaining = 0;
+    } else if (s.copyData) {
+        int pixels = (endY - currY) * (endX - startX) - (currX - startX);
+        s.remaining = (pixels + 1) / 2;
+    } else {
+        s.remaining = argumentCount - currentArgument;
+    }
 }
 
 void GPU::reset() {
+    sync();
+
     irqRequest = false;
     displayDisable = true;
     dmaDirection = 0;
@@ -54,6 +256,80 @@ void GPU::reset() {
     clutCachePos = ivec2(-1, -1);
 }
 
+void GPU::loadClutCache(ColorDepth bits, ivec2 clut) {
+    // Only paletted textures should reload the color look-up table cache
+    if (bits != ColorDepth::BIT_4 && bits != ColorDepth::BIT_8) {
+        return;
+    }
+
+    bool textureFormatRequireReload = bits > clutCacheColorDepth;
+    bool clutPositionChanged = clutCachePos != clut;
+
+    if (!textureFormatRequireReload && !clutPositionChanged) {
+        return;
+    }
+
+    clutCacheColorDepth = bits;
+    clutCachePos = clut;
+
+    int entries = (bits == ColorDepth::BIT_8) ? 256 : 16;
+    for (int i = 0; i < entries; i++) {
+        clutCache[i] = VRAM[clut.y][clut.x + i];
+    }
+}
+
+primitive::DrawState GPU::drawState(int bits, ivec2 clut) {
+    if (bits == 4 || bits == 8) {
+        // CLUT is read when primitive is submitted
+        if (tileRenderer) tileRenderer->flush(clut.x, clut.y, bits == 8 ? 256 : 16, 1);
+        loadClutCache(bitsToDepth(bits), clut);
+    }
+
+    primitive::DrawState state;
+    state.drawMode = gp0_e1;
+    state.textureWindow = gp0_e2;
+    state.maskSettings = gp0_e6;
+    state.drawingArea = drawingArea;
+    state.clip = {0, 0, VRAM_WIDTH - 1, VRAM_HEIGHT - 1};
+    state.clut = clutCache.data();
+
+    // In 480i mode lines of the displayed field are not drawn, unless drawing to display area is allowed.
+    // Field alternates every frame (GPUSTAT.31 reads 0 in vblank, so it can't be used here),
+    // display area starting at odd line shows the other VRAM lines.
+    if (isInterlaced480() && gp0_e1.drawingToDisplayArea == GP0_E1::DrawingToDisplayArea::prohibited) {
+        state.skippedField = (frames % 2) ^ (displayAreaStartY & 1);
+    }
+    return state;
+}
+
+void GPU::useTextureCache(primitive::DrawState& state, int bits, ivec2 texpage, const TextureCache::Area& area, ivec2 min, ivec2 max) {
+    if ((bits != 4 && bits != 8) || Render::forceVramTextures) return;
+
+    // Primitive drawing over its own texture page samples texels it has just written
+    const int width = bits == 8 ? 128 : 64;
+    const bool overlapsY = texpage.y <= max.y && texpage.y + 256 > min.y;
+    const bool overlapsX = (texpage.x <= max.x && texpage.x + width > min.x)  //
+                           || (texpage.x - VRAM_WIDTH <= max.x && texpage.x + width - VRAM_WIDTH > min.x);
+    if (overlapsX && overlapsY) return;
+
+    auto depth = bitsToDepth(bits);
+    auto entry = textureCache.find(depth, texpage, clutCachePos, clutCache.data());
+    if (entry == nullptr) {
+        // Texels of replaced entry might be used by queued primitives
+        if (tileRenderer) tileRenderer->flush();
+        entry = &textureCache.replace(depth, texpage, clutCachePos, clutCache.data());
+    }
+    textureCache.decode(*entry, vram.data(), area);
+    state.texture = entry->texels->data();
+}
+
+void GPU::flushRendering() {
+    sync();
+    if (tileRenderer) tileRenderer->flush();
+}
+
+void GPU::invalidateTextureCache() { textureCache.invalidate(0, 0, VRAM_WIDTH, VRAM_HEIGHT); }
+
 void GPU::drawTriangle(const primitive::Triangle& triangle) {
     if (hardwareRendering) {
         int flags = 0;
@@ -82,7 +358,24 @@ void GPU::drawTriangle(const primitive::Triangle& triangle) {
     }
 
     if (softwareRendering) {
-        Render::drawTriangle(this, triangle);
+        auto state = drawState(triangle.bits, triangle.clut);
+
+        const auto& v = triangle.v;
+        const ivec2 min(state.minDrawingX(std::min({v[0].pos.x, v[1].pos.x, v[2].pos.x})),
+                        state.minDrawingY(std::min({v[0].pos.y, v[1].pos.y, v[2].pos.y})));
+        const ivec2 max(state.maxDrawingX(std::max({v[0].pos.x, v[1].pos.x, v[2].pos.x})),
+                        state.maxDrawingY(std::max({v[0].pos.y, v[1].pos.y, v[2].pos.y})));
+        // Interpolated coordinates stay within vertex coordinates, margin covers rounding
+        const ivec2 uvMin(std::min({v[0].uv.x, v[1].uv.x, v[2].uv.x}) - 1, std::min({v[0].uv.y, v[1].uv.y, v[2].uv.y}) - 1);
+        const ivec2 uvMax(std::max({v[0].uv.x, v[1].uv.x, v[2].uv.x}) + 1, std::max({v[0].uv.y, v[1].uv.y, v[2].uv.y}) + 1);
+        useTextureCache(state, triangle.bits, triangle.texpage, TextureCache::Area::of(uvMin, uvMax, gp0_e2), min, max);
+        textureCache.invalidate(min.x, min.y, max.x - min.x + 1, max.y - min.y + 1);
+
+        if (tileRenderer) {
+            tileRenderer->drawTriangle(triangle, state);
+        } else {
+            Render::drawTriangle(this, triangle, state);
+        }
     }
 }
 
@@ -127,7 +420,18 @@ void GPU::drawLine(const primitive::Line& line) {
     }
 
     if (softwareRendering) {
-        Render::drawLine(this, line);
+        auto state = drawState();
+
+        const auto& p = line.pos;
+        const ivec2 min(state.minDrawingX(std::min(p[0].x, p[1].x)), state.minDrawingY(std::min(p[0].y, p[1].y)));
+        const ivec2 max(state.maxDrawingX(std::max(p[0].x, p[1].x)), state.maxDrawingY(std::max(p[0].y, p[1].y)));
+        textureCache.invalidate(min.x, min.y, max.x - min.x + 1, max.y - min.y + 1);
+
+        if (tileRenderer) {
+            tileRenderer->drawLine(line, state);
+        } else {
+            Render::drawLine(this, line, state);
+        }
     }
 }
 
@@ -189,7 +493,21 @@ void GPU::drawRectangle(const primitive::Rect& rect) {
     }
 
     if (softwareRendering) {
-        Render::drawRectangle(this, rect);
+        auto state = drawState(rect.bits, rect.clut);
+
+        const ivec2 min(state.minDrawingX(rect.pos.x), state.minDrawingY(rect.pos.y));
+        const ivec2 max(state.maxDrawingX(rect.pos.x + rect.size.x - 1), state.maxDrawingY(rect.pos.y + rect.size.y - 1));
+        // Texture might be flipped in either direction
+        const ivec2 uvMin(rect.uv.x - rect.size.x, rect.uv.y - rect.size.y);
+        const ivec2 uvMax(rect.uv.x + rect.size.x, rect.uv.y + rect.size.y);
+        useTextureCache(state, rect.bits, rect.texpage, TextureCache::Area::of(uvMin, uvMax, gp0_e2), min, max);
+        textureCache.invalidate(min.x, min.y, max.x - min.x + 1, max.y - min.y + 1);
+
+        if (tileRenderer) {
+            tileRenderer->drawRectangle(rect, state);
+        } else {
+            Render::drawRectangle(this, rect, state);
+        }
     }
 }
 
@@ -208,6 +526,9 @@ void GPU::cmdFillRectangle() {
 
     uint32_t color = to15bit(arguments[0] & 0xffffff);
 
+    if (tileRenderer) tileRenderer->flush(startX, startY, endX - startX, endY - startY);
+    textureCache.invalidate(startX, startY, endX - startX, endY - startY);
+
     // Note: not sure if coords should include last column and row
     for (int y = startY; y < endY; y++) {
         for (int x = startX; x < endX; x++) {
@@ -290,17 +611,7 @@ void GPU::cmdPolygon(PolygonArgs arg) {
         triangle.clut.y = tex.getClutY();
         triangle.transparency = tex.semiTransparencyBlending();
 
-        // Copy texture bits from Polygon draw command to E1 register
-        // texpagex, texpagey, semi-transparency, texture disable bits
-        const uint32_t E1_MASK = 0b00001001'11111111;
-
-        uint16_t newBits = (tex.texpage >> 16) & E1_MASK;
-        if (!textureDisableAllowed) {
-            newBits &= ~(1 << 11);
-        }
-
-        gp0_e1._reg &= ~E1_MASK;
-        gp0_e1._reg |= newBits;
+        gp0_e1._reg = (gp0_e1._reg & ~E1_TEXPAGE_MASK) | texpageToE1(tex.texpage);
     }
 
     triangle.assureCcw();
@@ -415,13 +726,6 @@ void GPU::cmdRectangle(RectangleArgs arg) {
     cmd = Command::None;
 }
 
-struct MaskCopy {
-    constexpr static int x(int x) { return x & 0x3ff; }
-    constexpr static int y(int y) { return y & 0x1ff; }
-    constexpr static int w(int w) { return ((w - 1) & 0x3ff) + 1; }
-    constexpr static int h(int h) { return ((h - 1) & 0x1ff) + 1; }
-};
-
 void GPU::cmdCpuToVram1() {
     startX = currX = MaskCopy::x(arguments[1] & 0xffff);
     startY = currY = MaskCopy::y((arguments[1] & 0xffff0000) >> 16);
@@ -429,6 +733,9 @@ void GPU::cmdCpuToVram1() {
     endX = startX + MaskCopy::w(arguments[2] & 0xffff);
     endY = startY + MaskCopy::h((arguments[2] & 0xffff0000) >> 16);
 
+    if (tileRenderer) tileRenderer->flush(startX, startY, endX - startX, endY - startY);
+    textureCache.invalidate(startX, startY, endX - startX, endY - startY);
+
     cmd = Command::CopyCpuToVram2;
     argumentCount = 1;
     currentArgument = 0;
@@ -446,6 +753,39 @@ void GPU::maskedWrite(int x, int y, uint16_t value) {
     VRAM[y][x] = value | mask;
 }
 
+void GPU::maskedWrite(int x, int y, const uint8_t* pixels, int count) {
+    x %= VRAM_WIDTH;
+    y %= VRAM_HEIGHT;
+
+    // Row wrapping around VRAM width is written in two parts
+    if (x + count > VRAM_WIDTH) {
+        const int first = VRAM_WIDTH - x;
+        maskedWrite(x, y, pixels, first);
+        maskedWrite(0, y, pixels + first * sizeof(uint16_t), count - first);
+        return;
+    }
+
+    uint16_t* dst = &VRAM[y][x];
+    const uint16_t mask = gp0_e6.setMaskWhileDrawing << 15;
+    if (likely(!gp0_e6.checkMaskBeforeDraw && mask == 0)) {
+        memcpy(dst, pixels, count * sizeof(uint16_t));
+        return;
+    }
+
+    // Loops without branches, so they are vectorized
+    uint16_t value[VRAM_WIDTH];
+    memcpy(value, pixels, count * sizeof(uint16_t));
+    if (gp0_e6.checkMaskBeforeDraw) {
+        for (int i = 0; i < count; i++) {
+            dst[i] = (dst[i] & 0x8000) ? dst[i] : (value[i] | mask);
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            dst[i] = value[i] | mask;
+        }
+    }
+}
+
 void GPU::cmdCpuToVram2() {
     const auto advanceOrBreak = [&]() {
         if (++currX >= endX) {
@@ -468,6 +808,33 @@ void GPU::cmdCpuToVram2() {
     if (advanceOrBreak()) return;
 }
 
+size_t GPU::cmdCpuToVram2(const uint32_t* data, size_t count) {
+    const auto pixels = reinterpret_cast<const uint8_t*>(data);
+    const size_t pixelCount = count * 2;
+
+    size_t written = 0;
+    while (written < pixelCount) {
+        const int n = static_cast<int>(std::min<size_t>(endX - currX, pixelCount - written));
+        maskedWrite(currX, currY, pixels + written * sizeof(uint16_t), n);
+        written += n;
+
+        currX += n;
+        if (currX >= endX) {
+            currX = startX;
+            if (++currY >= endY) {
+                cmd = Command::None;
+                break;
+            }
+        }
+    }
+
+    // Upper halfword of the last word is dropped when transfer ends at the lower one
+    const size_t used = (written + 1) / 2;
+    if (used > 0) arguments[0] = data[used - 1];
+    currentArgument = 0;
+    return used;
+}
+
 void GPU::cmdVramToCpu() {
     readMode = ReadMode::Vram;
     startX = currX = MaskCopy::x(arguments[1] & 0xffff);
@@ -488,6 +855,9 @@ uint32_t GPU::readVramData() {
         }
     };
 
+    // Primitives might have been submitted after the transfer command
+    flushRendering();
+
     uint32_t data = 0;
 
     data |= VRAM[currY % VRAM_HEIGHT][currX % VRAM_WIDTH];
@@ -498,6 +868,40 @@ uint32_t GPU::readVramData() {
     return data;
 }
 
+size_t GPU::readVramData(uint32_t* data, size_t count) {
+    // Primitives might have been submitted after the transfer command
+    flushRendering();
+
+    const auto pixels = reinterpret_cast<uint8_t*>(data);
+    const size_t pixelCount = count * 2;
+
+    size_t read = 0;
+    while (read < pixelCount && readMode == ReadMode::Vram) {
+        const int n = static_cast<int>(std::min<size_t>(endX - currX, pixelCount - read));
+        const int x = currX % VRAM_WIDTH;
+        const int first = std::min(n, VRAM_WIDTH - x);  // Row might wrap around VRAM width
+        memcpy(pixels + read * sizeof(uint16_t), &VRAM[currY % VRAM_HEIGHT][x], first * sizeof(uint16_t));
+        memcpy(pixels + (read + first) * sizeof(uint16_t), &VRAM[currY % VRAM_HEIGHT][0], (n - first) * sizeof(uint16_t));
+        read += n;
+
+        currX += n;
+        if (currX >= endX) {
+            currX = startX;
+            if (++currY >= endY) {
+                readMode = ReadMode::Register;
+            }
+        }
+    }
+
+    // Like readVramData(), upper halfword of the last word is read from position after the end of transfer
+    if (read % 2 != 0) {
+        uint16_t pixel = VRAM[currY % VRAM_HEIGHT][currX % VRAM_WIDTH];
+        memcpy(pixels + read * sizeof(uint16_t), &pixel, sizeof(pixel));
+        read++;
+    }
+    return read / 2;
+}
+
 void GPU::cmdVramToVram() {
     cmd = Command::None;
 
@@ -515,6 +919,12 @@ void GPU::cmdVramToVram() {
     // See gpu/vram-to-vram-overlap test
     bool dir = srcX < dstX;
 
+    if (tileRenderer) {
+        tileRenderer->flush(srcX, srcY, w, h);
+        tileRenderer->flush(dstX, dstY, w, h);
+    }
+    textureCache.invalidate(dstX, dstY, w, h);
+
     for (int y = 0; y < h; y++) {
         for (int _x = 0; _x < w; _x++) {
             int x = (!dir) ? _x : w - 1 - _x;
@@ -526,6 +936,13 @@ void GPU::cmdVramToVram() {
 }
 
 uint32_t GPU::getStat() {
+    // GPU thread might be behind, GP0 dependent bits come from the shadow state
+    const bool async = gp0Fifo != nullptr;
+    const GP0_E1 e1 = async ? gp0Shadow.e1 : gp0_e1;
+    const GP0_E6 e6 = async ? gp0Shadow.e6 : gp0_e6;
+    const bool ready = async ? gp0Shadow.remaining == 0 : cmd == Command::None;
+    const bool vramRead = async ? gp0Shadow.vramRead : readMode == ReadMode::Vram;
+
     uint32_t GPUSTAT = 0;
     uint8_t dataRequest = 0;
     if (dmaDirection == 0)
@@ -535,14 +952,14 @@ uint32_t GPU::getStat() {
     else if (dmaDirection == 2)
         dataRequest = 1;  // Same as bit28, ready to receive dma block
     else if (dmaDirection == 3)
-        dataRequest = readMode == ReadMode::Vram;  // Same as bit27, ready to send VRAM to CPU
+        dataRequest = vramRead;  // Same as bit27, ready to send VRAM to CPU
 
-    GPUSTAT = gp0_e1._reg & 0x7FF;
-    GPUSTAT |= gp0_e6.setMaskWhileDrawing << 11;
-    GPUSTAT |= gp0_e6.checkMaskBeforeDraw << 12;
+    GPUSTAT = e1._reg & 0x7FF;
+    GPUSTAT |= e6.setMaskWhileDrawing << 11;
+    GPUSTAT |= e6.checkMaskBeforeDraw << 12;
     GPUSTAT |= 1 << 13;  // always set
     GPUSTAT |= (uint8_t)gp1_08.reverseFlag << 14;
-    GPUSTAT |= (uint8_t)gp0_e1.textureDisable << 15;
+    GPUSTAT |= (uint8_t)e1.textureDisable << 15;
     GPUSTAT |= (uint8_t)gp1_08.horizontalResolution2 << 16;
     GPUSTAT |= (uint8_t)gp1_08.horizontalResolution1 << 17;
     GPUSTAT |= (uint8_t)gp1_08.verticalResolution << 19;
@@ -552,8 +969,8 @@ uint32_t GPU::getStat() {
     GPUSTAT |= displayDisable << 23;
     GPUSTAT |= irqRequest << 24;
     GPUSTAT |= dataRequest << 25;
-    GPUSTAT |= (cmd == Command::None) << 26;  // Ready for DMA command
-    GPUSTAT |= (readMode == ReadMode::Vram) << 27;
+    GPUSTAT |= ready << 26;  // Ready for DMA command
+    GPUSTAT |= vramRead << 27;
     GPUSTAT |= 1 << 28;  // Ready for receive DMA block
     GPUSTAT |= (dmaDirection & 3) << 29;
     GPUSTAT |= odd << 31;
@@ -564,8 +981,12 @@ uint32_t GPU::getStat() {
 uint32_t GPU::read(uint32_t address) {
     int reg = address & 0xfffffffc;
     if (reg == 0) {
+        // GPUREAD depends on GP0 commands
+        sync();
         if (readMode == ReadMode::Vram) {
-            return readVramData();
+            uint32_t data = readVramData();
+            if (gp0Fifo) gp0Shadow.vramRead = readMode == ReadMode::Vram;
+            return data;
         } else {
             return readData;
         }
@@ -582,8 +1003,69 @@ uint32_t GPU::read(uint32_t address) {
 }
 
 void GPU::write(uint32_t address, uint32_t data) {
-    if (address == 0) writeGP0(data);
-    if (address == 4) writeGP1(data);
+    if (address == 0) {
+        if (gp0Fifo) {
+            pushGP0(&data, 1);
+        } else {
+            writeGP0(data);
+        }
+    }
+    if (address == 4) {
+        // GP1 commands that reset or read the state of GP0 command processing,
+        // or change the state used while drawing wait for the GPU thread
+        uint8_t command = (data >> 24) & 0x3f;
+        bool touchesGP0 = command <= 0x01 || command == 0x05 || command == 0x08 || command == 0x09 ||
+                          (command >= 0x10 && command <= 0x1f);
+        if (gp0Fifo && (touchesGP0 || gpuLogEnabled)) {
+            sync();
+            writeGP1(data);
+            loadGP0Shadow();
+        } else {
+            writeGP1(data);
+        }
+    }
+}
+
+void GPU::writePacket(const uint32_t* data, size_t count) {
+    if (gp0Fifo) {
+        pushGP0(data, count);
+    } else {
+        writeGP0(data, count);
+    }
+}
+
+void GPU::readPacket(uint32_t* data, size_t count) {
+    sync();
+
+    size_t read = 0;
+    if (readMode == ReadMode::Vram) {
+        read = readVramData(data, count);
+    }
+    std::fill(data + read, data + count, readData);
+    if (gp0Fifo) gp0Shadow.vramRead = readMode == ReadMode::Vram;
+}
+
+void GPU::writeGP0(const uint32_t* data, size_t count) {
+    const uint32_t* end = data + count;
+    while (data != end) {
+        if (cmd == Command::None) {
+            writeGP0(*data++);
+
+            // Arguments of commands with known length are consumed at once when whole command is in the buffer
+            const size_t remaining = argumentCount - currentArgument;
+            const bool polyLine = cmd == Command::Line && LineArgs(command).polyLine;
+            if (cmd != Command::None && !polyLine && static_cast<size_t>(end - data) >= remaining) {
+                std::copy(data, data + remaining, arguments.begin() + currentArgument);
+                data += remaining;
+                currentArgument = argumentCount;
+                executeGP0();
+            }
+        } else if (cmd == Command::CopyCpuToVram2 && !gpuLogEnabled) {
+            data += cmdCpuToVram2(data, end - data);
+        } else {
+            writeGP0(*data++);
+        }
+    }
 }
 
 void GPU::writeGP0(uint32_t data) {
@@ -655,14 +1137,20 @@ void GPU::writeGP0(uint32_t data) {
             gp0_e6._reg = arguments[0];
         } else if (command == 0x1f) {
             // Interrupt request
-            irqRequest = true;
-            sys->interrupt->trigger(interrupt::IrqNumber::GPU);
+            if (gp0Fifo) {
+                // Interrupt controller and GPUSTAT.24 are owned by the emulation thread,
+                // IRQ is delivered on the next sync or scanline
+                irqPending = true;
+            } else {
+                irqRequest = true;
+                sys->interrupt->trigger(interrupt::IrqNumber::GPU);
+            }
         } else {
             fmt::print("GPU: GP0(0x{:02x}) args 0x{:06x}\n", command, arguments[0]);
         }
 
         if (gpuLogEnabled && cmd == Command::None) {
-            gpuLogList.push_back(LogEntry::GP0(arguments[0]));
+            gpuLogList.push(0, arguments[0]);
         }
         // TODO: Refactor gpu log to handle copies && multiline
 
@@ -684,23 +1172,15 @@ void GPU::writeGP0(uint32_t data) {
         }
     }
 
+    executeGP0();
+}
+
+void GPU::executeGP0() {
     if (gpuLogEnabled) {
         if (cmd == Command::CopyCpuToVram2) {
-            // Find last gp0(0xa0) command
-            int n = 5;
-            for (int i = gpuLogList.size() - 1; i >= 0; i--) {
-                auto& last = gpuLogList[i];
-                if (last.cmd() == 0xa0) {
-                    last.args.push_back(arguments[0]);
-                    break;
-                }
-                if (n-- == 0) break;
-            }
+            gpuLogList.append(0xa0, arguments[0]);
         } else {
-            LogEntry entry;
-            entry.type = 0;
-            entry.args = std::vector<uint32_t>(arguments.begin(), arguments.begin() + argumentCount);
-            gpuLogList.push_back(entry);
+            gpuLogList.push(0, arguments.data(), argumentCount);
         }
     }
     if (verbose && cmd != Command::CopyCpuToVram2) {
@@ -782,7 +1262,7 @@ void GPU::writeGP1(uint32_t data) {
         fmt::print("[GPU] W GP1(0x{:02x}): 0x{:06x}\n", command, argument);
     }
     if (gpuLogEnabled) {
-        gpuLogList.push_back(LogEntry::GP1(data));
+        gpuLogList.push(1, data);
     }
 }
 
@@ -793,6 +1273,8 @@ float GPU::cyclesPerLine() const {
         return timing::CYCLES_PER_LINE_PAL;
 }
 
+bool GPU::isInterlaced480() const { return gp1_08.verticalResolution == GP1_08::VerticalResolution::r480 && gp1_08.interlace; }
+
 int GPU::linesPerFrame() const {
     if (isNtsc())
         return timing::LINES_TOTAL_NTSC;
@@ -801,6 +1283,10 @@ int GPU::linesPerFrame() const {
 }
 
 bool GPU::emulateGpuCycles(int cycles) {
+    if (irqPending.load(std::memory_order_relaxed)) {
+        sync();
+    }
+
     gpuDot += cycles;
 
     int newLines = gpuDot / 3413;
@@ -809,7 +1295,7 @@ bool GPU::emulateGpuCycles(int cycles) {
     gpuLine += newLines;
 
     if (gpuLine < linesPerFrame() - 20 - 1) {
-        if (gp1_08.verticalResolution == GP1_08::VerticalResolution::r480 && gp1_08.interlace) {
+        if (isInterlaced480()) {
             odd = (frames % 2) != 0;
         } else {
             odd = (gpuLine % 2) != 0;
@@ -819,6 +1305,8 @@ bool GPU::emulateGpuCycles(int cycles) {
     }
 
     if (gpuLine == linesPerFrame() - 1) {
+        // Frame is displayed from VRAM, primitives submitted so far skip lines of the previous field (see drawState)
+        flushRendering();
         gpuLine = 0;
         frames++;
         return true;
@@ -826,19 +1314,6 @@ bool GPU::emulateGpuCycles(int cycles) {
     return false;
 }
 
-int GPU::minDrawingX(int x) const { return std::max((int)drawingArea.left, std::max(0, x)); }
-
-int GPU::minDrawingY(int y) const { return std::max((int)drawingArea.top, std::max(0, y)); }
-
-int GPU::maxDrawingX(int x) const { return std::min((int)drawingArea.right, std::min(VRAM_WIDTH, x)); }
-
-int GPU::maxDrawingY(int y) const { return std::min((int)drawingArea.bottom, std::min(VRAM_HEIGHT, y)); }
-
-bool GPU::insideDrawingArea(int x, int y) const {
-    return (x >= drawingArea.left) && (x < drawingArea.right) && (x < VRAM_WIDTH) && (y >= drawingArea.top) && (y < drawingArea.bottom)
-           && (y < VRAM_HEIGHT);
-}
-
 bool GPU::isNtsc() const { return forceNtsc || gp1_08.videoMode == GP1_08::VideoMode::ntsc; }
 
 void GPU::dumpVram() {
@@ -1,15 +1,24 @@
 #pragma once
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include "color_depth.h"
+#include "command_log.h"
 #include "primitive.h"
 #include "psx_color.h"
 #include "registers.h"
+#include "render/texture_cache.h"
+#include "utils/spsc_queue.h"
 
 #define VRAM ((uint16_t(*)[VRAM_WIDTH])vram.data())
 
 struct System;
 class Render;
+class TileRenderer;
 class OpenGL;
 
 namespace gpu {
@@ -109,6 +118,46 @@ class GPU {
     bool softwareRendering;
     bool hardwareRendering;
 
+    // 4 and 8 bit texture pages decoded by the software renderer
+    TextureCache textureCache;
+
+    // Software rendering on worker threads, nullptr if primitives are drawn right away
+    std::unique_ptr<TileRenderer> tileRenderer;
+
+    // Asynchronous mode - GP0 words are decoded and drawn on the GPU thread, nullptr if GP0 is processed right away
+    static const size_t GP0_FIFO_SIZE = 64 * 1024;
+    std::unique_ptr<SpscQueue<uint32_t, GP0_FIFO_SIZE>> gp0Fifo;
+    std::thread thread;
+    std::mutex threadMutex;
+    std::condition_variable threadWakeUp;
+    bool threadExit = false;
+    std::atomic<bool> threadSleeping = false;
+    std::atomic<bool> irqPending = false;  // GP0(0x1f) executed on the GPU thread
+
+    // GP0 state visible in GPUSTAT, tracked by the emulation thread as words are pushed,
+    // so status reads don't have to wait for the GPU thread
+    struct GP0Shadow {
+        GP0_E1 e1;
+        GP0_E6 e6;
+        uint8_t command = 0;
+        size_t remaining = 0;   // Words left of the current command, 0 - ready for a new one
+        int argument = 0;       // Index of the next argument
+        uint32_t texpage = 0;   // Textured polygons copy texpage bits to E1
+        bool polyLine = false;  // Terminated by 0x5xxx5xxx word
+        bool copyData = false;  // Words left are CPU -> VRAM pixel data
+        bool vramRead = false;  // VRAM -> CPU transfer set up
+    };
+    GP0Shadow gp0Shadow;
+
+    void startThread();
+    void stopThread();
+    void threadFunc();
+    void pushGP0(const uint32_t* data, size_t count);
+    void trackGP0(const uint32_t* data, size_t count);
+    void loadGP0Shadow();
+    uint32_t texpageToE1(uint32_t texpage) const;
+    void sync();
+
     void reset();
     void cmdFillRectangle();
     void cmdPolygon(PolygonArgs arg);
@@ -116,24 +165,34 @@ class GPU {
     void cmdRectangle(RectangleArgs arg);
     void cmdCpuToVram1();
     void cmdCpuToVram2();
+    size_t cmdCpuToVram2(const uint32_t* data, size_t count);  // Returns number of words used by the transfer
     void cmdVramToCpu();
     void cmdVramToVram();
 
+    void loadClutCache(ColorDepth bits, ivec2 clut);
+    primitive::DrawState drawState(int bits = 0, ivec2 clut = {});
+    void useTextureCache(primitive::DrawState& state, int bits, ivec2 texpage, const TextureCache::Area& area, ivec2 min, ivec2 max);
+
     void drawTriangle(const primitive::Triangle& triangle);
     void drawLine(const primitive::Line& line);
     void drawRectangle(const primitive::Rect& rect);
 
     void writeGP0(uint32_t data);
+    void writeGP0(const uint32_t* data, size_t count);
+    void executeGP0();  // Runs the command once all of its arguments were written
     void writeGP1(uint32_t data);
 
     void reload();
     void maskedWrite(int x, int y, uint16_t value);
+    void maskedWrite(int x, int y, const uint8_t* pixels, int count);  // Pixels of single row, unaligned halfwords
 
     uint32_t readVramData();
+    size_t readVramData(uint32_t* data, size_t count);  // Returns number of words read before the transfer ended
     uint32_t getStat();
 
     float cyclesPerLine() const;
     int linesPerFrame() const;
+    bool isInterlaced480() const;
 
    public:
     GPU(System* sys);
@@ -142,17 +201,19 @@ class GPU {
     bool emulateGpuCycles(int cycles);
     uint32_t read(uint32_t address);
     void write(uint32_t address, uint32_t data);
+    void writePacket(const uint32_t* data, size_t count);  // GP0 words of DMA linked list packet or block
+    void readPacket(uint32_t* data, size_t count);         // GPUREAD words of DMA block
     bool isNtsc() const;
 
-    int minDrawingX(int x) const;
-    int minDrawingY(int y) const;
-    int maxDrawingX(int x) const;
-    int maxDrawingY(int y) const;
-    bool insideDrawingArea(int x, int y) const;
+    // Waits until submitted GP0 commands are processed and drawn to VRAM
+    void flushRendering();
 
-    // Debug && replay
-    bool gpuLogEnabled = true;
-    std::vector<LogEntry> gpuLogList;
+    // Must be called after VRAM was modified directly (not by GP0 commands)
+    void invalidateTextureCache();
+
+    // Debug && replay, commands are logged only during draw list capture
+    bool gpuLogEnabled = false;
+    CommandLog gpuLogList;
     std::array<uint16_t, VRAM_WIDTH * VRAM_HEIGHT> prevVram{};
 
     void clear() { vertices.clear(); }
@@ -160,6 +221,8 @@ class GPU {
 
     template <class Archive>
     void serialize(Archive& ar) {
+        flushRendering();
+
         ar(startX, startY);
         ar(endX, endY);
         ar(currX, currY);
@@ -190,6 +253,8 @@ class GPU {
         ar(textureDisableAllowed);
 
         ar(vram);
+        invalidateTextureCache();
+        if (gp0Fifo) loadGP0Shadow();
     }
 };
 
@@ -1,6 +1,8 @@
 #pragma once
+#include <algorithm>
 #include <cmath>
 #include <utility>
+#include "device/gpu/registers.h"
 #include "device/gpu/semi_transparency.h"
 #include "psx_color.h"
 #include "utils/vector.h"
@@ -65,4 +67,32 @@ struct Triangle {
         return cross < 0;
     }
 };
+
+// GPU state used by the software renderer, captured when primitive is submitted
+struct DrawState {
+    gpu::GP0_E1 drawMode;
+    gpu::GP0_E2 textureWindow;
+    gpu::GP0_E6 maskSettings;
+    gpu::Rect<int16_t> drawingArea;
+    gpu::Rect<int> clip;    // Pixels outside of this area are not drawn (VRAM or tile bounds, inclusive)
+    const uint16_t* clut;  // Color look-up table cache contents
+
+    // Texture page decoded with the CLUT (4 and 8 bit only), texels are read from VRAM if nullptr
+    const uint16_t* texture = nullptr;
+
+    // Parity of lines which are not drawn (field being displayed in 480i mode), -1 if every line is drawn
+    int skippedField = -1;
+
+    int minDrawingX(int x) const { return std::max({(int)drawingArea.left, clip.left, x}); }
+    int minDrawingY(int y) const { return std::max({(int)drawingArea.top, clip.top, y}); }
+    int maxDrawingX(int x) const { return std::min({(int)drawingArea.right, clip.right, x}); }
+    int maxDrawingY(int y) const { return std::min({(int)drawingArea.bottom, clip.bottom, y}); }
+
+    bool skipsLine(int y) const { return (y & 1) == skippedField; }
+
+    bool insideDrawingArea(int x, int y) const {
+        return (x >= drawingArea.left) && (x < drawingArea.right) && (y >= drawingArea.top) && (y < drawingArea.bottom)  //
+               && (x >= clip.left) && (x <= clip.right) && (y >= clip.top) && (y <= clip.bottom);
+    }
+};
 }  // namespace primitive
\ No newline at end of file
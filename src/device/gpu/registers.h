@@ -1,6 +1,8 @@
 #pragma once
+#include <vector>
 #include "device/device.h"
 #include "semi_transparency.h"
+#include "utils/vector.h"
 
 namespace gpu {
 
@@ -255,33 +257,4 @@ struct TextureInfo {
     SemiTransparency semiTransparencyBlending() const { return (SemiTransparency)((texpage & 0x600000) >> 21); }
 };
 
-// Debug/rewind
-struct LogEntry {
-    uint8_t type;  // 0 - gp0, 1 - gp1
-    std::vector<uint32_t> args;
-
-    LogEntry() = default;
-    LogEntry(uint32_t cmd) { args.push_back(cmd); }
-
-    static LogEntry GP0(uint32_t word) {
-        auto e = LogEntry();
-        e.type = 0;
-        e.args.push_back(word);
-        return e;
-    }
-
-    static LogEntry GP0(uint8_t cmd, uint32_t data) { return GP0((cmd << 24) | (data & 0x00ffffff)); }
-
-    static LogEntry GP1(uint32_t word) {
-        auto e = LogEntry();
-        e.type = 1;
-        e.args.push_back(word);
-        return e;
-    }
-
-    static LogEntry GP1(uint8_t cmd, uint32_t data) { return GP1((cmd << 24) | (data & 0x00ffffff)); }
-
-    uint8_t cmd() const { return (args[0] >> 24) & 0xff; }
-};
-
 }  // namespace gpu
\ No newline at end of file
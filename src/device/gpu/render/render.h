@@ -3,7 +3,10 @@
 
 class Render {
    public:
-    static void drawLine(gpu::GPU* gpu, const primitive::Line& line);
-    static void drawTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle);
-    static void drawRectangle(gpu::GPU* gpu, const primitive::Rect& rect);
+    inline static bool forceScalar = false;        // Use scalar rasterizer instead of SIMD version
+    inline static bool forceVramTextures = false;  // Read 4 and 8 bit texels from VRAM instead of decoded texture cache
+
+    static void drawLine(gpu::GPU* gpu, const primitive::Line& line, const primitive::DrawState& state);
+    static void drawTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle, const primitive::DrawState& state);
+    static void drawRectangle(gpu::GPU* gpu, const primitive::Rect& rect, const primitive::DrawState& state);
 };
\ No newline at end of file
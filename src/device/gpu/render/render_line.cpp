@@ -6,95 +6,178 @@
 #undef VRAM
 #define VRAM ((uint16_t(*)[gpu::VRAM_WIDTH])gpu->vram.data())
 
-void Render::drawLine(gpu::GPU* gpu, const primitive::Line& line) {
-    const auto transparency = gpu->gp0_e1.semiTransparency;
-    const bool checkMaskBeforeDraw = gpu->gp0_e6.checkMaskBeforeDraw;
-    const bool setMaskWhileDrawing = gpu->gp0_e6.setMaskWhileDrawing;
-    const bool dithering = gpu->gp0_e1.dither24to15;
-
-    int x0 = line.pos[0].x;
-    int y0 = line.pos[0].y;
-    int x1 = line.pos[1].x;
-    int y1 = line.pos[1].y;
+namespace {
+const int COLOR_PRECISION = 12;
+
+// Gouraud shaded color channel stepped once per pixel along the major axis
+struct Channel {
+    int value;
+    int step;
+
+    Channel(int c0, int c1, int length)
+        : value((c0 << COLOR_PRECISION) + (1 << (COLOR_PRECISION - 1))), step(length == 0 ? 0 : ((c1 - c0) << COLOR_PRECISION) / length) {}
+
+    int get() const { return value >> COLOR_PRECISION; }
+    void skip(int n) { value += n * step; }
+};
+};  // namespace
+
+/**
+ * Bresenham line walked along the major axis (x for shallow lines, y for steep ones) in runs of pixels with
+ * the same minor coordinate. Line is clipped against the drawing area once, before the first pixel is drawn -
+ * Bresenham state of the first visible pixel is calculated directly.
+ */
+template <bool isSemiTransparent, bool isGouraudShaded, bool checkMaskBeforeDraw, bool dithering, bool steep>
+INLINE void rasterizeLine(gpu::GPU* gpu, const primitive::Line& line, const primitive::DrawState& state) {
+    const auto transparency = state.drawMode.semiTransparency;
+    const bool setMaskWhileDrawing = state.maskSettings.setMaskWhileDrawing;
+
+    ivec2 p0 = line.pos[0];
+    ivec2 p1 = line.pos[1];
     RGB c0 = line.color[0];
     RGB c1 = line.color[1];
 
-    // TODO: Clip line in drawRectangle
-
-    // Skip rendering when distance between vertices is bigger than 1023x511
-    if (abs(x0 - x1) >= 1024) return;
-    if (abs(y0 - y1) >= 512) return;
-
-    bool steep = false;
-    if (std::abs(x0 - x1) < std::abs(y0 - y1)) {
-        std::swap(x0, y0);
-        std::swap(x1, y1);
-        steep = true;
-    }
-    if (x0 > x1) {
-        std::swap(x0, x1);
-        std::swap(y0, y1);
+    // Line is drawn from lower to higher major axis coordinate
+    auto major = [](ivec2 p) { return steep ? p.y : p.x; };
+    auto minor = [](ivec2 p) { return steep ? p.x : p.y; };
+    if (major(p0) > major(p1)) {
+        std::swap(p0, p1);
         std::swap(c0, c1);
     }
 
-    int dx = x1 - x0;
-    int dy = y1 - y0;
-    int derror = std::abs(dy) * 2;
-    int error = !steep;
-    int y = y0;
-
-    float length = sqrtf(powf(x1 - x0, 2) + powf(y1 - y0, 2));
-    if (length == 0) {
-        length = 1.f;  // Prevent NaN in getColor
+    const ivec2 areaMin(std::max((int)state.drawingArea.left, state.clip.left), std::max((int)state.drawingArea.top, state.clip.top));
+    const ivec2 areaMax(std::min((int)state.drawingArea.right, state.clip.right), std::min((int)state.drawingArea.bottom, state.clip.bottom));
+
+    const int dx = major(p1) - major(p0);
+    const int dy = minor(p1) - minor(p0);
+    const int derror = std::abs(dy) * 2;
+    const int initialError = !steep;
+    const int minorStep = dy > 0 ? 1 : -1;
+
+    // Range of major axis steps inside the drawing area
+    int begin = std::max(0, major(areaMin) - major(p0));
+    int end = std::min(dx, major(areaMax) - major(p0));
+
+    // Minor coordinate moves by one every time error exceeds dx, number of moves after n steps is
+    // floor((initialError + n * derror + dx - 1) / (2 * dx))
+    int movesMin = minorStep > 0 ? minor(areaMin) - minor(p0) : minor(p0) - minor(areaMax);
+    int movesMax = minorStep > 0 ? minor(areaMax) - minor(p0) : minor(p0) - minor(areaMin);
+    if (movesMax < 0) return;
+    if (derror == 0) {
+        if (movesMin > 0) return;
+    } else {
+        if (movesMin > 0) begin = std::max(begin, (2 * dx * movesMin - initialError - dx + 1 + derror - 1) / derror);
+        end = std::min(end, (2 * dx * (movesMax + 1) - initialError - dx) / derror);
+    }
+    if (begin > end) return;
+
+    // Bresenham state at the first visible pixel
+    const int moves = dx == 0 ? 0 : (initialError + begin * derror + dx - 1) / (2 * dx);
+    int error = initialError + begin * derror - 2 * dx * moves;
+    int m = major(p0) + begin;
+    int n = minor(p0) + moves * minorStep;
+
+    Channel r(c0.r, c1.r, dx), g(c0.g, c1.g, dx), b(c0.b, c1.b, dx);
+    if constexpr (isGouraudShaded) {
+        r.skip(begin);
+        g.skip(begin);
+        b.skip(begin);
     }
 
-    // TODO: Precalculate color stepping
-    auto getColor = [&](int x, int y) -> RGB {
-        if (!line.gouraudShading) {
-            return c0;
-        }
-        float relPos = sqrtf(powf(x0 - x, 2) + powf(y0 - y, 2));
-
-        float progress = relPos / length;
-
-        return c0 * (1.f - progress) + c1 * progress;
-    };
+    PSXColor flat(c0.r, c0.g, c0.b);
+    flat.k |= setMaskWhileDrawing;
 
-    auto putPixel = [&](int x, int y, RGB fullColor) {
-        PSXColor bg = VRAM[y][x];
-        if (unlikely(checkMaskBeforeDraw)) {
+    auto putPixel = [&](int x, int y) {
+        if (state.skipsLine(y)) return;
+        uint16_t& pixel = VRAM[y][x];
+        PSXColor bg = pixel;
+        if constexpr (checkMaskBeforeDraw) {
             if (bg.k) return;
         }
 
-        PSXColor c(fullColor.r, fullColor.g, fullColor.b);
-        if (dithering) {
-            c = PSXColor(                                //
-                ditherLUT[y & 3u][x & 3u][fullColor.r],  //
-                ditherLUT[y & 3u][x & 3u][fullColor.g],  //
-                ditherLUT[y & 3u][x & 3u][fullColor.b]   //
-            );
+        PSXColor c;
+        if constexpr (dithering) {
+            const auto& lut = ditherLUT[y & 3u][x & 3u];
+            if constexpr (isGouraudShaded) {
+                c = PSXColor(lut[r.get()], lut[g.get()], lut[b.get()]);
+            } else {
+                c = PSXColor(lut[c0.r], lut[c0.g], lut[c0.b]);
+            }
+        } else if constexpr (isGouraudShaded) {
+            c = PSXColor(r.get(), g.get(), b.get());
+        } else {
+            c = flat;
         }
 
-        if (line.isSemiTransparent) {
+        if constexpr (isSemiTransparent) {
             c = PSXColor::blend(bg, c, transparency);
         }
 
         c.k |= setMaskWhileDrawing;
-
-        VRAM[y][x] = c.raw;
+        pixel = c.raw;
     };
 
-    for (int x = x0; x <= x1; x++) {
-        if (steep) {
-            // TODO: Remove insideDrawingArea calls
-            if (gpu->insideDrawingArea(y, x)) putPixel(y, x, getColor(x, y));
+    for (int remaining = end - begin + 1; remaining > 0;) {
+        // Pixels drawn before minor coordinate changes
+        int run = derror == 0 ? remaining : std::min(remaining, std::max(0, dx - error) / derror + 1);
+
+        if constexpr (!steep && !isSemiTransparent && !isGouraudShaded && !checkMaskBeforeDraw && !dithering) {
+            if (!state.skipsLine(n)) std::fill_n(&VRAM[n][m], run, flat.raw);
+            m += run;
         } else {
-            if (gpu->insideDrawingArea(x, y)) putPixel(x, y, getColor(x, y));
+            for (int i = 0; i < run; i++, m++) {
+                if constexpr (steep) {
+                    putPixel(n, m);
+                } else {
+                    putPixel(m, n);
+                }
+                if constexpr (isGouraudShaded) {
+                    r.skip(1);
+                    g.skip(1);
+                    b.skip(1);
+                }
+            }
         }
-        error += derror;
+
+        remaining -= run;
+        error += run * derror;
         if (error > dx) {
-            y += (y1 > y0 ? 1 : -1);
+            n += minorStep;
             error -= dx * 2;
         }
     }
 }
+
+// Generate all permutations of rasterizeLine
+using rasterizeLine_t = void(gpu::GPU* gpu, const primitive::Line& line, const primitive::DrawState& state);
+
+#define E(isSemiTransparent, isGouraudShaded, checkMaskBit, dithering, steep) \
+    &rasterizeLine<isSemiTransparent, isGouraudShaded, checkMaskBit, dithering, steep>
+
+static constexpr rasterizeLine_t* rasterizeLineDispatchTable[2][2][2][2][2] =  //
+    {{{{{E(0, 0, 0, 0, 0), E(0, 0, 0, 0, 1)}, {E(0, 0, 0, 1, 0), E(0, 0, 0, 1, 1)}},
+       {{E(0, 0, 1, 0, 0), E(0, 0, 1, 0, 1)}, {E(0, 0, 1, 1, 0), E(0, 0, 1, 1, 1)}}},
+      {{{E(0, 1, 0, 0, 0), E(0, 1, 0, 0, 1)}, {E(0, 1, 0, 1, 0), E(0, 1, 0, 1, 1)}},
+       {{E(0, 1, 1, 0, 0), E(0, 1, 1, 0, 1)}, {E(0, 1, 1, 1, 0), E(0, 1, 1, 1, 1)}}}},
+     {{{{E(1, 0, 0, 0, 0), E(1, 0, 0, 0, 1)}, {E(1, 0, 0, 1, 0), E(1, 0, 0, 1, 1)}},
+       {{E(1, 0, 1, 0, 0), E(1, 0, 1, 0, 1)}, {E(1, 0, 1, 1, 0), E(1, 0, 1, 1, 1)}}},
+      {{{E(1, 1, 0, 0, 0), E(1, 1, 0, 0, 1)}, {E(1, 1, 0, 1, 0), E(1, 1, 0, 1, 1)}},
+       {{E(1, 1, 1, 0, 0), E(1, 1, 1, 0, 1)}, {E(1, 1, 1, 1, 0), E(1, 1, 1, 1, 1)}}}}};
+#undef E
+
+void Render::drawLine(gpu::GPU* gpu, const primitive::Line& line, const primitive::DrawState& state) {
+    const ivec2 delta(std::abs(line.pos[0].x - line.pos[1].x), std::abs(line.pos[0].y - line.pos[1].y));
+
+    // Skip rendering when distance between vertices is bigger than 1023x511
+    if (delta.x >= 1024 || delta.y >= 512) return;
+
+    auto isSemiTransparent = line.isSemiTransparent;
+    auto isGouraudShaded = line.gouraudShading;
+    auto checkMaskBit = state.maskSettings.checkMaskBeforeDraw;
+    auto dithering = state.drawMode.dither24to15;
+    auto steep = delta.x < delta.y;
+
+    auto rasterize = rasterizeLineDispatchTable[isSemiTransparent][isGouraudShaded][checkMaskBit][dithering][steep];
+
+    rasterize(gpu, line, state);
+}
@@ -1,17 +1,100 @@
+#include <algorithm>
 #include "../primitive.h"
 #include "render.h"
+#include "simd.h"
 #include "texture_utils.h"
 #include "utils/macros.h"
 
 #undef VRAM
 #define VRAM ((uint16_t(*)[gpu::VRAM_WIDTH])gpu->vram.data())
 
+INLINE void fillRow(uint16_t* dst, int count, uint16_t color) {
+    int i = 0;
+#ifdef RENDER_SIMD
+    const __m256i c = _mm256_set1_epi16(color);
+    for (; i + 16 <= count; i += 16) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), c);
+    }
+#endif
+    for (; i < count; i++) dst[i] = color;
+}
+
+// Transparent (0x0000) texels keep the background
+INLINE void copyRow(uint16_t* dst, const uint16_t* texels, int count, uint16_t mask) {
+    int i = 0;
+#ifdef RENDER_SIMD
+    const __m256i m = _mm256_set1_epi16(mask);
+    for (; i + 16 <= count; i += 16) {
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(texels + i));
+        __m256i bg = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i transparent = _mm256_cmpeq_epi16(t, _mm256_setzero_si256());
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_blendv_epi8(_mm256_or_si256(t, m), bg, transparent));
+    }
+#endif
+    for (; i < count; i++) {
+        if (texels[i] != 0) dst[i] = texels[i] | mask;
+    }
+}
+
+// Opaque untextured rectangle, every row is a single fill
+INLINE void fillRows(gpu::GPU* gpu, const primitive::Rect& rect, const primitive::DrawState& state, const ivec2 min, const ivec2 max) {
+    PSXColor c(rect.color.r, rect.color.g, rect.color.b);
+    c.k |= state.maskSettings.setMaskWhileDrawing;
+
+    for (int y = min.y; y <= max.y; y++) {
+        if (state.skipsLine(y)) continue;
+        fillRow(&VRAM[y][min.x], max.x - min.x + 1, c.raw);
+    }
+}
+
+// Opaque sprite with unmodulated texture, copied row by row.
+// Unflipped rows without texture window are copied straight from VRAM (16 bit) or decoded texture page (4 and 8 bit)
+// in runs between wrap arounds, other rows are fetched (and expanded with CLUT) into temporary row first.
+template <ColorDepth bits>
+INLINE void copyRows(gpu::GPU* gpu, const primitive::Rect& rect, const primitive::DrawState& state, const ivec2 min, const ivec2 max,
+                     const ivec2 uv, const int uStep, const int vStep) {
+    const auto textureWindow = state.textureWindow;
+    const uint16_t mask = state.maskSettings.setMaskWhileDrawing ? 0x8000 : 0;
+    const int width = max.x - min.x + 1;
+    const bool direct = uStep > 0 && textureWindow.maskX == 0 && (bits == ColorDepth::BIT_16 || state.texture != nullptr);
+
+    uint16_t row[gpu::VRAM_WIDTH];
+    for (int y = min.y, v = uv.y; y <= max.y; y++, v += vStep) {
+        if (state.skipsLine(y)) continue;
+        const int texelY = maskTexel(ivec2(0, v), textureWindow).y;
+        uint16_t* dst = &VRAM[y][min.x];
+
+        if (!direct) {
+            for (int i = 0, u = uv.x; i < width; i++, u += uStep) {
+                row[i] = fetchTex<bits>(gpu, ivec2(maskTexel(ivec2(u, v), textureWindow).x, texelY), rect.texpage, state).raw;
+            }
+            copyRow(dst, row, width, mask);
+            continue;
+        }
+
+        for (int i = 0, u = uv.x & 0xff; i < width;) {
+            int count = std::min(width - i, TextureCache::SIZE - u);
+            const uint16_t* texels;
+            if constexpr (bits == ColorDepth::BIT_16) {
+                const int x = (rect.texpage.x + u) & (gpu::VRAM_WIDTH - 1);
+                count = std::min(count, gpu::VRAM_WIDTH - x);
+                texels = &VRAM[(rect.texpage.y + texelY) & 511][x];
+            } else {
+                texels = state.texture + texelY * TextureCache::SIZE + u;
+            }
+            copyRow(dst + i, texels, count, mask);
+            i += count;
+            u = (u + count) & 0xff;
+        }
+    }
+}
+
 template <ColorDepth bits, bool isSemiTransparent, bool isBlended, bool checkMaskBeforeDraw>
-INLINE void rasterizeRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
+INLINE void rasterizeRectangle(gpu::GPU* gpu, const primitive::Rect& rect, const primitive::DrawState& state) {
     // Extract common GPU state
-    const auto transparency = gpu->gp0_e1.semiTransparency;
-    const bool setMaskWhileDrawing = gpu->gp0_e6.setMaskWhileDrawing;
-    const auto textureWindow = gpu->gp0_e2;
+    const auto transparency = state.drawMode.semiTransparency;
+    const bool setMaskWhileDrawing = state.maskSettings.setMaskWhileDrawing;
+    const auto textureWindow = state.textureWindow;
     constexpr bool isTextured = bits != ColorDepth::NONE;
 
     if (rect.size.x >= 1024 || rect.size.y >= 512) return;
@@ -21,33 +104,44 @@ INLINE void rasterizeRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
         rect.pos.y    //
     );
     const ivec2 min(              //
-        gpu->minDrawingX(pos.x),  //
-        gpu->minDrawingY(pos.y)   //
+        state.minDrawingX(pos.x),  //
+        state.minDrawingY(pos.y)   //
     );
     const ivec2 max(                                //
-        gpu->maxDrawingX(pos.x + rect.size.x - 1),  //
-        gpu->maxDrawingY(pos.y + rect.size.y - 1)   //
-    );
-
-    ivec2 uv(                         //
-        rect.uv.x + (min.x - pos.x),  // Add offset if part of rectange was cut off
-        rect.uv.y + (min.y - pos.y)   //
+        state.maxDrawingX(pos.x + rect.size.x - 1),  //
+        state.maxDrawingY(pos.y + rect.size.y - 1)   //
     );
-    int uStep = 1, vStep = 1;
 
     // Texture flipping
-    if (gpu->gp0_e1.texturedRectangleXFlip) {
+    const int uStep = state.drawMode.texturedRectangleXFlip ? -1 : 1;
+    const int vStep = state.drawMode.texturedRectangleYFlip ? -1 : 1;
+
+    ivec2 uv(                                 //
+        rect.uv.x + (min.x - pos.x) * uStep,  // Add offset if part of rectange was cut off
+        rect.uv.y + (min.y - pos.y) * vStep   //
+    );
+    if (uStep < 0) {
         uv.x += 1;
-        uStep = -1;
-    }
-    if (gpu->gp0_e1.texturedRectangleYFlip) {
-        vStep = -1;
     }
 
-    loadClutCacheIfRequired<bits>(gpu, rect.clut);
+    // Fast paths for the most common rectangles - flat fills and sprites
+    if constexpr (!isSemiTransparent && !checkMaskBeforeDraw) {
+        if (likely(!Render::forceScalar)) {
+            if constexpr (!isTextured) {
+                fillRows(gpu, rect, state, min, max);
+                return;
+            } else if constexpr (!isBlended) {
+                if (!drawsOverTexture<bits>(rect.texpage, min, max)) {
+                    copyRows<bits>(gpu, rect, state, min, max, uv, uStep, vStep);
+                    return;
+                }
+            }
+        }
+    }
 
     int x, y, u, v;
     for (y = min.y, v = uv.y; y <= max.y; y++, v += vStep) {
+        if (state.skipsLine(y)) continue;
         for (x = min.x, u = uv.x; x <= max.x; x++, u += uStep) {
             PSXColor bg = VRAM[y][x];
             if constexpr (checkMaskBeforeDraw) {
@@ -59,7 +153,7 @@ INLINE void rasterizeRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
                 c = PSXColor(rect.color.r, rect.color.g, rect.color.b);
             } else {
                 const ivec2 texel = maskTexel(ivec2(u, v), textureWindow);
-                c = fetchTex<bits>(gpu, texel, rect.texpage);
+                c = fetchTex<bits>(gpu, texel, rect.texpage, state);
                 if (c.raw == 0x0000) continue;
 
                 if constexpr (isBlended) {
@@ -81,7 +175,7 @@ INLINE void rasterizeRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
 }
 
 // Generate all permutations of rasterizeRectangle
-using rasterizeRectangle_t = void(gpu::GPU* gpu, const primitive::Rect& rect);
+using rasterizeRectangle_t = void(gpu::GPU* gpu, const primitive::Rect& rect, const primitive::DrawState& state);
 
 #define E(bits, isSemiTransparent, isBlended, checkMaskBit) \
     &rasterizeRectangle<bitsToDepth<bits>(), isSemiTransparent, isBlended, checkMaskBit>
@@ -110,13 +204,14 @@ static constexpr rasterizeRectangle_t* rasterizeRectangleDispatchTable[4][2][2][
       {{E(16, 1, 0, 0), E(16, 1, 0, 1)}, {E(16, 1, 1, 0), E(16, 1, 1, 1)}}}};
 #undef E
 
-void Render::drawRectangle(gpu::GPU* gpu, const primitive::Rect& rect) {
+void Render::drawRectangle(gpu::GPU* gpu, const primitive::Rect& rect, const primitive::DrawState& state) {
     auto bits = (int)bitsToDepth(rect.bits);
     auto isSemiTransparent = rect.isSemiTransparent;
-    auto isBlended = !rect.isRawTexture;
-    auto checkMaskBit = gpu->gp0_e6.checkMaskBeforeDraw;
+    // Texture modulated with neutral color (0x80) keeps texels unchanged
+    auto isBlended = !rect.isRawTexture && !(rect.color.r == 0x80 && rect.color.g == 0x80 && rect.color.b == 0x80);
+    auto checkMaskBit = state.maskSettings.checkMaskBeforeDraw;
 
     auto rasterize = rasterizeRectangleDispatchTable[bits][isSemiTransparent][isBlended][checkMaskBit];
 
-    rasterize(gpu, rect);
+    rasterize(gpu, rect, state);
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "render.h"
 #include <algorithm>
+#include <cstdlib>
 #include "device/gpu/psx_color.h"
 #include "dither.h"
+#include "simd.h"
 #include "texture_utils.h"
 #include "utils/macros.h"
 
@@ -26,102 +28,71 @@ void calculateFillRuleBias(int bias[3], const ivec2 pos[3]) {
     bias[2] = isTopLeft(D01) ? -1 : 0;
 }
 
-// TODO: Fixed point has some rounding issue, need more investigation
-// #define USE_FIXED_POINT
+// Attributes are interpolated in fixed point with 12 fractional bits (precision used by PS1 GPU).
+// Values wrap around, integer part is truncated to 8 bits just like colors and texture coordinates are.
+const int FP_PRECISION = 12;
+using fixed_t = uint32_t;
 
-#ifdef USE_FIXED_POINT
-#define FP_PRECISION 12
-#define FP_PADDING 12
-
-using delta_t = int32_t;
-#define TO_FP(x) ((x) * (1 << FP_PRECISION))
-#define FROM_FP(x) ((x) >> (FP_PRECISION + FP_PADDING))
-#define ADD_PADDING(x) ((delta_t)(x) << FP_PADDING)
-#else
-
-using delta_t = float;
-#define TO_FP(x) (x)
-#define FROM_FP(x) (x)
-#define ADD_PADDING(x) (x)
-#endif
+#define FROM_FP(x) static_cast<int>((x) >> FP_PRECISION)
 
 struct Attributes {
-    delta_t r, g, b;
-    delta_t u, v;
+    fixed_t r, g, b;
+    fixed_t u, v;
 };
 
 struct AttributeDeltas {
     struct Delta {
-        delta_t x, y;
+        fixed_t x, y;
     };
 
     Delta r, g, b;
     Delta u, v;
 };
 
+// Integer division by the triangle area (truncated towards zero), reciprocal is calculated once per triangle
+class AreaDivider {
+    int64_t divisor;
+    bool negative;
+    double reciprocal;
+
+   public:
+    explicit AreaDivider(int area) : divisor(std::abs(area)), negative(area < 0), reciprocal(1.0 / divisor) {}
+
+    int64_t divide(int64_t n) const {
+        bool negativeResult = (n < 0) != negative;
+        int64_t a = n < 0 ? -n : n;
+
+        // Rounded reciprocal might result in quotient off by one
+        int64_t q = static_cast<int64_t>(static_cast<double>(a) * reciprocal);
+        if (q * divisor > a) {
+            q--;
+        } else if ((q + 1) * divisor <= a) {
+            q++;
+        }
+        return negativeResult ? -q : q;
+    }
+};
+
 /**
  * p - vertex position
  * a - attribute values per vertex
  */
-delta_t calculateXDelta(const ivec2 p[3], const int a[3]) {
-    return (p[1].y - p[2].y) * a[0] + (p[2].y - p[0].y) * a[1] + (p[0].y - p[1].y) * a[2];
+int64_t calculateXDelta(const ivec2 p[3], const int a[3]) {
+    return static_cast<int64_t>(p[1].y - p[2].y) * a[0] + (p[2].y - p[0].y) * a[1] + (p[0].y - p[1].y) * a[2];
 }
 
-delta_t calculateYDelta(const ivec2 p[3], const int a[3]) {
-    return (p[2].x - p[1].x) * a[0] + (p[0].x - p[2].x) * a[1] + (p[1].x - p[0].x) * a[2];
+int64_t calculateYDelta(const ivec2 p[3], const int a[3]) {
+    return static_cast<int64_t>(p[2].x - p[1].x) * a[0] + (p[0].x - p[2].x) * a[1] + (p[1].x - p[0].x) * a[2];
 }
 
-AttributeDeltas::Delta calculateDelta(const int area, const ivec2 p[3], const int a[3]) {
-    delta_t x = ADD_PADDING(TO_FP(calculateXDelta(p, a)) / area);
-    delta_t y = ADD_PADDING(TO_FP(calculateYDelta(p, a)) / area);
+AttributeDeltas::Delta calculateDelta(const AreaDivider& divider, const ivec2 p[3], const int a[3]) {
+    fixed_t x = static_cast<fixed_t>(divider.divide(calculateXDelta(p, a) * (1 << FP_PRECISION)));
+    fixed_t y = static_cast<fixed_t>(divider.divide(calculateYDelta(p, a) * (1 << FP_PRECISION)));
 
     return {x, y};
 }
 
-delta_t calculateStartAttribute(const int area, const ivec2 p[3], const int bias[3], const int a[3]) {
-    float A = (p[1].x * p[2].y - p[2].x * p[1].y) * a[0] - bias[0];
-    float B = (p[2].x * p[0].y - p[0].x * p[2].y) * a[1] - bias[1];
-    float C = (p[0].x * p[1].y - p[1].x * p[0].y) * a[2] - bias[2];
-
-#ifdef USE_FIXED_POINT
-    auto half = (1 << (FP_PRECISION - 1));
-#else
-    auto half = 0.5f;
-#endif
-    return ADD_PADDING((TO_FP(A + B + C) / static_cast<float>(area)) + half);
-}
-
-template <bool isGouraudShaded, bool isTextured>
-Attributes calculateStartAttributes(const primitive::Triangle& triangle) {
-    ivec2 p[3] = {triangle.v[0].pos, triangle.v[1].pos, triangle.v[2].pos};
-
-    const int area = orient2d(p[0], p[1], p[2]);
-    if (area == 0) return {};
-
-    int bias[3];
-    calculateFillRuleBias(bias, p);
-
-    Attributes attrs = {};
-    if constexpr (isGouraudShaded) {
-        int r[3] = {triangle.v[0].color.r, triangle.v[1].color.r, triangle.v[2].color.r};
-        int g[3] = {triangle.v[0].color.g, triangle.v[1].color.g, triangle.v[2].color.g};
-        int b[3] = {triangle.v[0].color.b, triangle.v[1].color.b, triangle.v[2].color.b};
-
-        attrs.r = calculateStartAttribute(area, p, bias, r);
-        attrs.g = calculateStartAttribute(area, p, bias, g);
-        attrs.b = calculateStartAttribute(area, p, bias, b);
-    }
-
-    if constexpr (isTextured) {
-        int u[3] = {triangle.v[0].uv.x, triangle.v[1].uv.x, triangle.v[2].uv.x};
-        int v[3] = {triangle.v[0].uv.y, triangle.v[1].uv.y, triangle.v[2].uv.y};
-
-        attrs.u = calculateStartAttribute(area, p, bias, u);
-        attrs.v = calculateStartAttribute(area, p, bias, v);
-    }
-
-    return attrs;
-}
+fixed_t calculateStartAttribute(const int a) { return (static_cast<fixed_t>(a) << FP_PRECISION) + (1 << (FP_PRECISION - 1)); }
 
 template <bool isGouraudShaded, bool isTextured>
 AttributeDeltas calculateDeltas(const primitive::Triangle& triangle) {
@@ -130,30 +101,32 @@ AttributeDeltas calculateDeltas(const primitive::Triangle& triangle) {
     const int area = orient2d(p[0], p[1], p[2]);
     if (area == 0) return {};
 
+    const AreaDivider divider(area);
+
     AttributeDeltas deltas = {};
     if constexpr (isGouraudShaded) {
         int r[3] = {triangle.v[0].color.r, triangle.v[1].color.r, triangle.v[2].color.r};
         int g[3] = {triangle.v[0].color.g, triangle.v[1].color.g, triangle.v[2].color.g};
         int b[3] = {triangle.v[0].color.b, triangle.v[1].color.b, triangle.v[2].color.b};
 
-        deltas.r = calculateDelta(area, p, r);
-        deltas.g = calculateDelta(area, p, g);
-        deltas.b = calculateDelta(area, p, b);
+        deltas.r = calculateDelta(divider, p, r);
+        deltas.g = calculateDelta(divider, p, g);
+        deltas.b = calculateDelta(divider, p, b);
     }
 
     if constexpr (isTextured) {
         int u[3] = {triangle.v[0].uv.x, triangle.v[1].uv.x, triangle.v[2].uv.x};
         int v[3] = {triangle.v[0].uv.y, triangle.v[1].uv.y, triangle.v[2].uv.y};
 
-        deltas.u = calculateDelta(area, p, u);
-        deltas.v = calculateDelta(area, p, v);
+        deltas.u = calculateDelta(divider, p, u);
+        deltas.v = calculateDelta(divider, p, v);
     }
 
     return deltas;
 }
 
 template <bool isGouraudShaded, bool isTextured>
-void addXDeltas(Attributes& attrib, AttributeDeltas& deltas, int count = 1) {
+void addXDeltas(Attributes& attrib, const AttributeDeltas& deltas, int count = 1) {
     if constexpr (isGouraudShaded) {
         attrib.r += deltas.r.x * count;
         attrib.g += deltas.g.x * count;
@@ -166,7 +139,7 @@ void addXDeltas(Attributes& attrib, AttributeDeltas& deltas, int count = 1) {
 }
 
 template <bool isGouraudShaded, bool isTextured>
-void addYDeltas(Attributes& attrib, AttributeDeltas& deltas, int count = 1) {
+void addYDeltas(Attributes& attrib, const AttributeDeltas& deltas, int count = 1) {
     if constexpr (isGouraudShaded) {
         attrib.r += deltas.r.y * count;
         attrib.g += deltas.g.y * count;
@@ -178,6 +151,32 @@ void addYDeltas(Attributes& attrib, AttributeDeltas& deltas, int count = 1) {
     }
 }
 
+// Attribute values at given pixel, interpolated from the top vertex
+template <bool isGouraudShaded, bool isTextured>
+Attributes calculateStartAttributes(const primitive::Triangle& triangle, const AttributeDeltas& deltas, const ivec2 pixel) {
+    int topIndex = 0;
+    for (int i = 1; i < 3; i++) {
+        if (triangle.v[i].pos.y < triangle.v[topIndex].pos.y) topIndex = i;
+    }
+    const auto& top = triangle.v[topIndex];
+
+    Attributes attrs = {};
+    if constexpr (isGouraudShaded) {
+        attrs.r = calculateStartAttribute(top.color.r);
+        attrs.g = calculateStartAttribute(top.color.g);
+        attrs.b = calculateStartAttribute(top.color.b);
+    }
+
+    if constexpr (isTextured) {
+        attrs.u = calculateStartAttribute(top.uv.x);
+        attrs.v = calculateStartAttribute(top.uv.y);
+    }
+
+    addXDeltas<isGouraudShaded, isTextured>(attrs, deltas, pixel.x - top.pos.x);
+    addYDeltas<isGouraudShaded, isTextured>(attrs, deltas, pixel.y - top.pos.y);
+    return attrs;
+}
+
 RGB dither(const RGB color, const ivec2 p) {
     uint8_t r = ditherLUT[p.y & 3u][p.x & 3u][color.r];
     uint8_t g = ditherLUT[p.y & 3u][p.x & 3u][color.g];
@@ -185,12 +184,173 @@ RGB dither(const RGB color, const ivec2 p) {
     return RGB(r, g, b);
 }
 
+#ifdef RENDER_SIMD
+// Attribute values of 8 consecutive pixels
+struct AttributeLanes {
+    __m256i r, g, b;
+    __m256i u, v;
+
+    static __m256i lanes(fixed_t start, fixed_t delta) {
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        return _mm256_add_epi32(_mm256_set1_epi32(start), _mm256_mullo_epi32(lane, _mm256_set1_epi32(delta)));
+    }
+
+    static void step(__m256i& value, fixed_t delta) { value = _mm256_add_epi32(value, _mm256_set1_epi32(delta * 8)); }
+
+    template <bool isGouraudShaded, bool isTextured>
+    void init(const Attributes& start, const AttributeDeltas& deltas) {
+        if constexpr (isGouraudShaded) {
+            r = lanes(start.r, deltas.r.x);
+            g = lanes(start.g, deltas.g.x);
+            b = lanes(start.b, deltas.b.x);
+        }
+        if constexpr (isTextured) {
+            u = lanes(start.u, deltas.u.x);
+            v = lanes(start.v, deltas.v.x);
+        }
+    }
+
+    // Move by 8 pixels
+    template <bool isGouraudShaded, bool isTextured>
+    void step(const AttributeDeltas& deltas) {
+        if constexpr (isGouraudShaded) {
+            step(r, deltas.r.x);
+            step(g, deltas.g.x);
+            step(b, deltas.b.x);
+        }
+        if constexpr (isTextured) {
+            step(u, deltas.u.x);
+            step(v, deltas.v.x);
+        }
+    }
+};
+
+// Interpolated color channel (truncated to 8 bits like RGB constructor does), dithered if needed
+template <bool isDithered>
+INLINE __m256i colorChannel(__m256i value, __m256i ditherOffset) {
+    __m256i c = _mm256_and_si256(_mm256_srli_epi32(value, FP_PRECISION), _mm256_set1_epi32(0xff));
+    if constexpr (isDithered) {
+        c = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(c, ditherOffset), _mm256_setzero_si256()), _mm256_set1_epi32(255));
+    }
+    return c;
+}
+
+// Vectorised inner loop of rasterizeTriangle, 8 pixels are processed in every iteration
+template <ColorDepth bits, bool isSemiTransparent, bool isGouraudShaded, bool isBlended, bool checkMaskBeforeDraw, bool dithering>
+void rasterizeTriangleSimd(gpu::GPU* gpu, const primitive::Triangle& triangle, const primitive::DrawState& state, const ivec2 min,
+                           const ivec2 max, int CY[3], const ivec2 D[3], Attributes startAttributes, const AttributeDeltas& deltas) {
+    const auto transparency = triangle.transparency;
+    const __m256i setMask = _mm256_set1_epi32(state.maskSettings.setMaskWhileDrawing ? 0x8000 : 0);
+    const simd::TextureWindow textureWindow(state.textureWindow);
+    constexpr bool isTextured = bits != ColorDepth::NONE;
+    constexpr bool isDithered = dithering && isBlended;
+
+    const RGB colorFlat = triangle.v[0].color;
+    const __m256i flatR = _mm256_set1_epi32(colorFlat.r);
+    const __m256i flatG = _mm256_set1_epi32(colorFlat.g);
+    const __m256i flatB = _mm256_set1_epi32(colorFlat.b);
+    const __m256i flatColor = _mm256_set1_epi32(PSXColor(colorFlat).raw);
+
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (int y = min.y; y <= max.y; y++) {
+        __m256i edge[3], edgeStep[3];
+        for (int i = 0; i < 3; i++) {
+            edge[i] = _mm256_add_epi32(_mm256_set1_epi32(CY[i]), _mm256_mullo_epi32(lane, _mm256_set1_epi32(D[i].y)));
+            edgeStep[i] = _mm256_set1_epi32(D[i].y * 8);
+        }
+
+        AttributeLanes attrib;
+        attrib.init<isGouraudShaded, isTextured>(startAttributes, deltas);
+
+        __m256i ditherOffset = zero;
+        if constexpr (isDithered) {
+            alignas(32) int32_t offsets[8];
+            for (int i = 0; i < 8; i++) offsets[i] = ditherLUT[y & 3u][(min.x + i) & 3u][128] - 128;
+            ditherOffset = _mm256_load_si256(reinterpret_cast<const __m256i*>(offsets));
+        }
+
+        const int endX = state.skipsLine(y) ? min.x - 1 : max.x;
+        for (int x = min.x; x <= endX; x += 8) {
+            __m256i draw = _mm256_cmpgt_epi32(_mm256_or_si256(_mm256_or_si256(edge[0], edge[1]), edge[2]), zero);
+            const int count = std::min(8, max.x - x + 1);
+            if (count < 8) draw = _mm256_and_si256(draw, _mm256_cmpgt_epi32(_mm256_set1_epi32(count), lane));
+
+            if (!_mm256_testz_si256(draw, draw)) {
+                // Last pixels of the row are copied so the load and store do not go past the drawing area
+                alignas(16) uint16_t tail[8];
+                uint16_t* pixels = &VRAM[y][x];
+                if (count < 8) {
+                    std::copy(pixels, pixels + count, tail);
+                    pixels = tail;
+                }
+
+                const __m256i bg = simd::load(pixels);
+                if constexpr (checkMaskBeforeDraw) {
+                    draw = _mm256_andnot_si256(_mm256_cmpeq_epi32(simd::maskBit(bg), _mm256_set1_epi32(0x8000)), draw);
+                }
+
+                __m256i r, g, b;
+                if constexpr (isGouraudShaded) {
+                    r = colorChannel<isDithered>(attrib.r, ditherOffset);
+                    g = colorChannel<isDithered>(attrib.g, ditherOffset);
+                    b = colorChannel<isDithered>(attrib.b, ditherOffset);
+                } else {
+                    r = flatR;
+                    g = flatG;
+                    b = flatB;
+                }
+
+                __m256i c;
+                if constexpr (bits == ColorDepth::NONE) {
+                    if constexpr (!isGouraudShaded) {
+                        c = flatColor;
+                    } else {
+                        c = simd::toPSXColor(r, g, b);
+                    }
+                } else {
+                    const __m256i u = textureWindow.maskX(_mm256_srli_epi32(attrib.u, FP_PRECISION));
+                    const __m256i v = textureWindow.maskY(_mm256_srli_epi32(attrib.v, FP_PRECISION));
+                    c = simd::fetchTex<bits>(gpu, u, v, triangle.texpage, state);
+                    draw = _mm256_andnot_si256(_mm256_cmpeq_epi32(c, zero), draw);
+
+                    if constexpr (isBlended) {
+                        c = simd::modulate(c, r, g, b);
+                    }
+                }
+
+                if constexpr (isSemiTransparent) {
+                    const __m256i blended = simd::blend(bg, c, transparency);
+                    if constexpr (isTextured) {
+                        c = _mm256_blendv_epi8(c, blended, _mm256_cmpeq_epi32(simd::maskBit(c), _mm256_set1_epi32(0x8000)));
+                    } else {
+                        c = blended;
+                    }
+                }
+
+                c = _mm256_or_si256(c, setMask);
+
+                simd::store(pixels, _mm256_blendv_epi8(bg, c, draw));
+                if (count < 8) std::copy(tail, tail + count, &VRAM[y][x]);
+            }
+
+            for (int i = 0; i < 3; i++) edge[i] = _mm256_add_epi32(edge[i], edgeStep[i]);
+            attrib.step<isGouraudShaded, isTextured>(deltas);
+        }
+
+        for (int i = 0; i < 3; i++) CY[i] += D[i].x;
+        addYDeltas<isGouraudShaded, isTextured>(startAttributes, deltas);
+    }
+}
+#endif
+
 template <ColorDepth bits, bool isSemiTransparent, bool isGouraudShaded, bool isBlended, bool checkMaskBeforeDraw, bool dithering>
-void rasterizeTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle) {
+void rasterizeTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle, const primitive::DrawState& state) {
     // Extract common GPU state
     const auto transparency = triangle.transparency;
-    const bool setMaskWhileDrawing = gpu->gp0_e6.setMaskWhileDrawing;
-    const auto textureWindow = gpu->gp0_e2;
+    const bool setMaskWhileDrawing = state.maskSettings.setMaskWhileDrawing;
+    const auto textureWindow = state.textureWindow;
     constexpr bool isTextured = bits != ColorDepth::NONE;
     constexpr bool isDithered = dithering && isBlended;
 
@@ -200,8 +360,6 @@ void rasterizeTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle) {
     const int area = orient2d(pos[0], pos[1], pos[2]);
     if (area == 0) return;
 
-    loadClutCacheIfRequired<bits>(gpu, triangle.clut);
-
     ivec2 min(                                     //
         std::min({pos[0].x, pos[1].x, pos[2].x}),  //
         std::min({pos[0].y, pos[1].y, pos[2].y})   //
@@ -216,12 +374,12 @@ void rasterizeTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle) {
     if (size.x >= 1024 || size.y >= 512) return;
 
     min = ivec2(                  //
-        gpu->minDrawingX(min.x),  //
-        gpu->minDrawingY(min.y)   //
+        state.minDrawingX(min.x),  //
+        state.minDrawingY(min.y)   //
     );
     max = ivec2(                  //
-        gpu->maxDrawingX(max.x),  //
-        gpu->maxDrawingY(max.y)   //
+        state.maxDrawingX(max.x),  //
+        state.maxDrawingY(max.y)   //
     );
 
     // https://fgiesen.wordpress.com/2013/02/10/optimizing-the-basic-rasterizer/
@@ -242,18 +400,25 @@ void rasterizeTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle) {
         orient2d(pos[0], pos[1], min) + bias[2]   //
     };
 
-    Attributes startAttributes = calculateStartAttributes<isGouraudShaded, isTextured>(triangle);
-    AttributeDeltas deltas = calculateDeltas<isGouraudShaded, isTextured>(triangle);
+    const AttributeDeltas deltas = calculateDeltas<isGouraudShaded, isTextured>(triangle);
+    Attributes startAttributes = calculateStartAttributes<isGouraudShaded, isTextured>(triangle, deltas, min);
 
-    addYDeltas<isGouraudShaded, isTextured>(startAttributes, deltas, min.y);
-    addXDeltas<isGouraudShaded, isTextured>(startAttributes, deltas, min.x);
+#ifdef RENDER_SIMD
+    if (likely(!Render::forceScalar) && !drawsOverTexture<bits>(triangle.texpage, min, max)) {
+        const ivec2 D[3] = {D12, D20, D01};
+        rasterizeTriangleSimd<bits, isSemiTransparent, isGouraudShaded, isBlended, checkMaskBeforeDraw, dithering>(
+            gpu, triangle, state, min, max, CY, D, startAttributes, deltas);
+        return;
+    }
+#endif
 
     ivec2 p;
     for (p.y = min.y; p.y <= max.y; p.y++) {
         Attributes attrib = startAttributes;
         int CX[3] = {CY[0], CY[1], CY[2]};
 
-        for (p.x = min.x; p.x <= max.x; p.x++) {
+        const int endX = state.skipsLine(p.y) ? min.x - 1 : max.x;  // Only edge functions are stepped on skipped lines
+        for (p.x = min.x; p.x <= endX; p.x++) {
             if ((CX[0] | CX[1] | CX[2]) > 0) {
                 const PSXColor bg = VRAM[p.y][p.x];
                 if constexpr (checkMaskBeforeDraw) {
@@ -280,7 +445,7 @@ void rasterizeTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle) {
                 } else {
                     const ivec2 uv(FROM_FP(attrib.u), FROM_FP(attrib.v));
                     const ivec2 texel = maskTexel(uv, textureWindow);
-                    c = fetchTex<bits>(gpu, texel, triangle.texpage);
+                    c = fetchTex<bits>(gpu, texel, triangle.texpage, state);
                     if (c.raw == 0x0000) goto DONE;
 
                     if constexpr (isBlended) {
@@ -321,7 +486,7 @@ void rasterizeTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle) {
 }
 
 // Generate all permutations of rasterizeTriangle so that compiler can provide optimized versions of the function (no ifs in loop)
-using rasterizeTriangle_t = void(gpu::GPU* gpu, const primitive::Triangle& triangle);
+using rasterizeTriangle_t = void(gpu::GPU* gpu, const primitive::Triangle& triangle, const primitive::DrawState& state);
 
 #define E(bits, isSemiTransparent, isGouraudShaded, isBlended, checkMaskBit, dithering) \
     &rasterizeTriangle<bitsToDepth<bits>(), isSemiTransparent, isGouraudShaded, isBlended, checkMaskBit, dithering>
@@ -379,15 +544,15 @@ static constexpr rasterizeTriangle_t* rasterizeTriangleDispatchTable[4][2][2][2]
         {{E(16, 1, 1, 1, 0, 0), E(16, 1, 1, 1, 0, 1)}, {E(16, 1, 1, 1, 1, 0), E(16, 1, 1, 1, 1, 1)}}}}}};
 #undef E
 
-void Render::drawTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle) {
+void Render::drawTriangle(gpu::GPU* gpu, const primitive::Triangle& triangle, const primitive::DrawState& state) {
     auto bits = (int)bitsToDepth(triangle.bits);
     auto isSemiTransparent = triangle.isSemiTransparent;
     auto isGouraudShaded = triangle.gouraudShading;
     auto isBlended = !triangle.isRawTexture;
-    auto checkMaskBit = gpu->gp0_e6.checkMaskBeforeDraw;
-    auto dithering = gpu->gp0_e1.dither24to15;
+    auto checkMaskBit = state.maskSettings.checkMaskBeforeDraw;
+    auto dithering = state.drawMode.dither24to15;
 
     auto rasterize = rasterizeTriangleDispatchTable[bits][isSemiTransparent][isGouraudShaded][isBlended][checkMaskBit][dithering];
 
-    rasterize(gpu, triangle);
+    rasterize(gpu, triangle, state);
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+#include "device/gpu/gpu.h"
+#include "utils/macros.h"
+#include "../color_depth.h"
+
+#ifdef __AVX2__
+#define RENDER_SIMD
+#endif
+
+#ifdef RENDER_SIMD
+#include <immintrin.h>
+
+// AVX2 versions of per pixel operations (8 pixels at once), results are bit exact with scalar implementation.
+// Every 32bit lane holds one 15bit color with mask bit (PSXColor)
+namespace {
+namespace simd {
+INLINE __m256i load(const uint16_t* pixels) { return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels))); }
+
+INLINE void store(uint16_t* pixels, __m256i colors) {
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(colors, colors), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), _mm256_castsi256_si128(packed));
+}
+
+// Gathers 16bit values, 32bit words are always read from even index so no read goes past the end of the array
+INLINE __m256i gather16(const uint16_t* base, __m256i index) {
+    __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base), _mm256_srli_epi32(index, 1), 4);
+    __m256i shift = _mm256_slli_epi32(_mm256_and_si256(index, _mm256_set1_epi32(1)), 4);
+    return _mm256_and_si256(_mm256_srlv_epi32(words, shift), _mm256_set1_epi32(0xffff));
+}
+
+INLINE __m256i channel(__m256i color, int shift) { return _mm256_and_si256(_mm256_srli_epi32(color, shift), _mm256_set1_epi32(31)); }
+
+INLINE __m256i combine(__m256i r, __m256i g, __m256i b, __m256i k) {
+    return _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 5)), _mm256_or_si256(_mm256_slli_epi32(b, 10), k));
+}
+
+INLINE __m256i maskBit(__m256i color) { return _mm256_and_si256(color, _mm256_set1_epi32(0x8000)); }
+
+// 8bit RGB to PSXColor
+INLINE __m256i toPSXColor(__m256i r, __m256i g, __m256i b) {
+    return combine(_mm256_srli_epi32(r, 3), _mm256_srli_epi32(g, 3), _mm256_srli_epi32(b, 3), _mm256_setzero_si256());
+}
+
+// Texture window (maskTexel), texel coordinates are wrapped to 256x256
+struct TextureWindow {
+    __m256i andX, orX, andY, orY;
+
+    TextureWindow(const gpu::GP0_E2 window)
+        : andX(_mm256_set1_epi32(255 & ~(window.maskX * 8))),
+          orX(_mm256_set1_epi32((window.offsetX & window.maskX) * 8)),
+          andY(_mm256_set1_epi32(255 & ~(window.maskY * 8))),
+          orY(_mm256_set1_epi32((window.offsetY & window.maskY) * 8)) {}
+
+    INLINE __m256i maskX(__m256i x) const { return _mm256_or_si256(_mm256_and_si256(x, andX), orX); }
+    INLINE __m256i maskY(__m256i y) const { return _mm256_or_si256(_mm256_and_si256(y, andY), orY); }
+};
+
+template <ColorDepth bits>
+INLINE __m256i fetchTex(gpu::GPU* gpu, __m256i x, __m256i y, const ivec2 texPage, const primitive::DrawState& state) {
+    if constexpr (bits != ColorDepth::BIT_16) {
+        if (state.texture != nullptr) return gather16(state.texture, _mm256_or_si256(_mm256_slli_epi32(y, 8), x));
+    }
+
+    constexpr int shift = bits == ColorDepth::BIT_4 ? 2 : bits == ColorDepth::BIT_8 ? 1 : 0;
+
+    __m256i row = _mm256_and_si256(_mm256_add_epi32(y, _mm256_set1_epi32(texPage.y)), _mm256_set1_epi32(511));
+    __m256i column = _mm256_add_epi32(_mm256_srli_epi32(x, shift), _mm256_set1_epi32(texPage.x));
+    column = _mm256_and_si256(column, _mm256_set1_epi32(1023));
+    __m256i texel = gather16(gpu->vram.data(), _mm256_or_si256(_mm256_slli_epi32(row, 10), column));
+
+    if constexpr (bits == ColorDepth::BIT_16) {
+        return texel;
+    } else {
+        constexpr int indexBits = 16 >> shift;
+        const __m256i indexMask = _mm256_set1_epi32((1 << indexBits) - 1);
+        __m256i indexShift = _mm256_mullo_epi16(_mm256_and_si256(x, _mm256_set1_epi32((1 << shift) - 1)), _mm256_set1_epi32(indexBits));
+        __m256i entry = _mm256_and_si256(_mm256_srlv_epi32(texel, indexShift), indexMask);
+        return gather16(state.clut, entry);
+    }
+}
+
+// PSXColor * RGB (texture modulation)
+INLINE __m256i modulate(__m256i color, __m256i r, __m256i g, __m256i b) {
+    // Products fit in 16 bits
+    const __m256i max = _mm256_set1_epi32(31);
+    auto mul = [&](__m256i c, __m256i m) { return _mm256_min_epi32(_mm256_srli_epi32(_mm256_mullo_epi16(c, m), 7), max); };
+    return combine(mul(channel(color, 0), r), mul(channel(color, 5), g), mul(channel(color, 10), b), maskBit(color));
+}
+
+INLINE __m256i blend(__m256i bg, __m256i c, gpu::SemiTransparency transparency) {
+    const __m256i max = _mm256_set1_epi32(31);
+    auto blendChannel = [&](int shift) {
+        __m256i b = channel(bg, shift);
+        __m256i f = channel(c, shift);
+        switch (transparency) {
+            case gpu::SemiTransparency::Bby2plusFby2: return _mm256_srli_epi32(_mm256_add_epi32(b, f), 1);
+            case gpu::SemiTransparency::BplusF: return _mm256_min_epi32(_mm256_add_epi32(b, f), max);
+            case gpu::SemiTransparency::BminusF: return _mm256_max_epi32(_mm256_sub_epi32(b, f), _mm256_setzero_si256());
+            case gpu::SemiTransparency::BplusFby4:
+            default: return _mm256_min_epi32(_mm256_add_epi32(b, _mm256_srli_epi32(f, 2)), max);
+        }
+    };
+    return combine(blendChannel(0), blendChannel(5), blendChannel(10), maskBit(c));
+}
+};  // namespace simd
+};  // namespace
+#endif
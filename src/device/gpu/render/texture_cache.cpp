@@ -0,0 +1,132 @@
+#include "texture_cache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Range of single axis, window mask bits are replaced with the offset bits
+void axis(int min, int max, int mask, int offset, int& start, int& count) {
+    if (mask != 0) {
+        // Free bits of masked coordinate are below the fixed ones only when mask is contiguous, this is a superset otherwise
+        start = (offset & mask) * 8;
+        count = (255 & ~(mask * 8)) + 1;
+    } else if (max - min + 1 >= TextureCache::SIZE) {
+        start = 0;
+        count = TextureCache::SIZE;
+    } else {
+        start = min & (TextureCache::SIZE - 1);
+        count = max - min + 1;
+    }
+}
+};  // namespace
+
+TextureCache::Area TextureCache::Area::of(ivec2 min, ivec2 max, gpu::GP0_E2 window) {
+    Area area;
+    axis(min.x, max.x, window.maskX, window.offsetX, area.start.x, area.count.x);
+    axis(min.y, max.y, window.maskY, window.offsetY, area.start.y, area.count.y);
+    return area;
+}
+
+bool TextureCache::isStale(const Entry& entry) const {
+    int columns = entry.bits == ColorDepth::BIT_8 ? 128 / BLOCK_WIDTH : 64 / BLOCK_WIDTH;
+    for (int row = 0; row < SIZE / BLOCK_HEIGHT; row++) {
+        for (int column = 0; column < columns; column++) {
+            int bx = (entry.texpage.x / BLOCK_WIDTH + column) % BLOCKS_X;
+            int by = (entry.texpage.y / BLOCK_HEIGHT + row) % BLOCKS_Y;
+            if (blockWrites[by * BLOCKS_X + bx] > entry.decodedAt) return true;
+        }
+    }
+    return false;
+}
+
+TextureCache::Entry* TextureCache::find(ColorDepth bits, ivec2 texpage, ivec2 clutPos, const uint16_t* clut) {
+    for (auto& entry : entries) {
+        if (entry.bits != bits || entry.texpage != texpage || entry.clutPos != clutPos) continue;
+        if (memcmp(entry.clut.data(), clut, clutSize(bits) * sizeof(uint16_t)) != 0) return nullptr;
+        if (isStale(entry)) return nullptr;
+
+        entry.lastUse = ++uses;
+        return &entry;
+    }
+    return nullptr;
+}
+
+TextureCache::Entry& TextureCache::replace(ColorDepth bits, ivec2 texpage, ivec2 clutPos, const uint16_t* clut) {
+    Entry* entry = nullptr;
+    for (auto& e : entries) {
+        if (e.bits == bits && e.texpage == texpage && e.clutPos == clutPos) {
+            entry = &e;
+            break;
+        }
+    }
+
+    if (entry == nullptr) {
+        if (entries.size() < MAX_ENTRIES) {
+            entry = &entries.emplace_back();
+            entry->texels = std::make_unique<std::array<uint16_t, SIZE * SIZE>>();
+        } else {
+            entry = &*std::min_element(entries.begin(), entries.end(), [](auto& a, auto& b) { return a.lastUse < b.lastUse; });
+        }
+    }
+
+    entry->bits = bits;
+    entry->texpage = texpage;
+    entry->clutPos = clutPos;
+    std::copy(clut, clut + clutSize(bits), entry->clut.begin());
+    entry->decodedAt = writes;
+    entry->lastUse = ++uses;
+    entry->decoded.reset();
+    return *entry;
+}
+
+void TextureCache::decodeChunk(Entry& entry, const uint16_t* vram, int v, int chunk) {
+    const uint16_t* row = vram + ((entry.texpage.y + v) & 511) * 1024;
+    uint16_t* texels = entry.texels->data() + v * SIZE + chunk * CHUNK;
+    const int u = chunk * CHUNK;
+
+    if (entry.bits == ColorDepth::BIT_4) {
+        for (int i = 0; i < CHUNK / 4; i++) {
+            uint16_t index = row[(entry.texpage.x + u / 4 + i) & 1023];
+            for (int j = 0; j < 4; j++) {
+                texels[i * 4 + j] = entry.clut[(index >> (j * 4)) & 0xf];
+            }
+        }
+    } else {
+        for (int i = 0; i < CHUNK / 2; i++) {
+            uint16_t index = row[(entry.texpage.x + u / 2 + i) & 1023];
+            texels[i * 2 + 0] = entry.clut[index & 0xff];
+            texels[i * 2 + 1] = entry.clut[index >> 8];
+        }
+    }
+}
+
+void TextureCache::decode(Entry& entry, const uint16_t* vram, const Area& area) {
+    const int firstChunk = area.start.x / CHUNK;
+    const int chunks = std::min((area.start.x + area.count.x - 1) / CHUNK - firstChunk + 1, CHUNKS);
+
+    for (int y = 0; y < area.count.y; y++) {
+        const int v = (area.start.y + y) % SIZE;
+        for (int c = 0; c < chunks; c++) {
+            const int chunk = (firstChunk + c) % CHUNKS;
+            const size_t bit = v * CHUNKS + chunk;
+            if (entry.decoded[bit]) continue;
+
+            decodeChunk(entry, vram, v, chunk);
+            entry.decoded.set(bit);
+        }
+    }
+}
+
+void TextureCache::invalidate(int x, int y, int w, int h) {
+    if (w <= 0 || h <= 0) return;
+
+    const uint64_t stamp = ++writes;
+    const int columns = std::min((x + w - 1) / BLOCK_WIDTH - x / BLOCK_WIDTH + 1, BLOCKS_X);
+    const int rows = std::min((y + h - 1) / BLOCK_HEIGHT - y / BLOCK_HEIGHT + 1, BLOCKS_Y);
+    for (int by = 0; by < rows; by++) {
+        for (int bx = 0; bx < columns; bx++) {
+            int column = (x / BLOCK_WIDTH + bx) % BLOCKS_X;
+            int row = (y / BLOCK_HEIGHT + by) % BLOCKS_Y;
+            blockWrites[row * BLOCKS_X + column] = stamp;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <memory>
+#include <vector>
+#include "device/gpu/color_depth.h"
+#include "device/gpu/registers.h"
+#include "utils/vector.h"
+
+/**
+ * 4 and 8 bit texture pages expanded to 16 bit colors with their CLUT,
+ * so fetching a texel is a single read from linear 256x256 buffer (texture window is applied to texel coordinates).
+ *
+ * Texels are decoded lazily, in chunks covering the area sampled by primitives.
+ * VRAM writes are tracked in blocks - page is decoded again once any of its blocks was written.
+ */
+class TextureCache {
+   public:
+    static const int SIZE = 256;  // Texture page size in texels
+
+    // Texels that might be sampled by a primitive, both axes wrap around the page
+    struct Area {
+        ivec2 start;  // 0 - 255
+        ivec2 count;  // 1 - 256
+
+        // Area covering coordinates from min to max (inclusive) after texture window was applied
+        static Area of(ivec2 min, ivec2 max, gpu::GP0_E2 window);
+    };
+
+    struct Entry {
+        ColorDepth bits = ColorDepth::NONE;
+        ivec2 texpage;
+        ivec2 clutPos;
+        std::array<uint16_t, 256> clut;
+        uint64_t decodedAt = 0;  // Page blocks written after that invalidate the entry
+        uint64_t lastUse = 0;
+        std::bitset<SIZE * SIZE / 32> decoded;  // Decoded chunks
+        std::unique_ptr<std::array<uint16_t, SIZE * SIZE>> texels;
+    };
+
+    // Valid entry for the page with given CLUT cache contents, nullptr if it has to be (re)created with replace
+    Entry* find(ColorDepth bits, ivec2 texpage, ivec2 clutPos, const uint16_t* clut);
+
+    // Reuses stale or least recently used entry for the page, texels of the old entry are overwritten
+    Entry& replace(ColorDepth bits, ivec2 texpage, ivec2 clutPos, const uint16_t* clut);
+
+    // Decodes chunks of the area which were not decoded yet
+    void decode(Entry& entry, const uint16_t* vram, const Area& area);
+
+    // Marks VRAM area as written (coordinates wrap around VRAM)
+    void invalidate(int x, int y, int w, int h);
+
+   private:
+    static const int CHUNK = 32;  // Texels decoded at once
+    static const int CHUNKS = SIZE / CHUNK;
+    static const int BLOCK_WIDTH = 64;
+    static const int BLOCK_HEIGHT = 16;
+    static const int BLOCKS_X = 1024 / BLOCK_WIDTH;
+    static const int BLOCKS_Y = 512 / BLOCK_HEIGHT;
+    static const size_t MAX_ENTRIES = 64;
+
+    std::vector<Entry> entries;
+    std::array<uint64_t, BLOCKS_X * BLOCKS_Y> blockWrites{};  // Value of writes counter when the block was last written
+    uint64_t writes = 0;
+    uint64_t uses = 0;
+
+    static int clutSize(ColorDepth bits) { return bits == ColorDepth::BIT_8 ? 256 : 16; }
+    bool isStale(const Entry& entry) const;
+    void decodeChunk(Entry& entry, const uint16_t* vram, int v, int chunk);
+};
@@ -6,50 +6,31 @@
 
 #define gpuVRAM ((uint16_t(*)[gpu::VRAM_WIDTH])gpu->vram.data())
 
-template <ColorDepth bits>
-void loadClutCacheIfRequired(gpu::GPU* gpu, ivec2 clut) {
-    // Only paletted textures should reload the color look-up table cache
-    if constexpr (bits != ColorDepth::BIT_4 && bits != ColorDepth::BIT_8) {
-        return;
-    }
-
-    bool textureFormatRequireReload = bits > gpu->clutCacheColorDepth;
-    bool clutPositionChanged = gpu->clutCachePos != clut;
-
-    if (!textureFormatRequireReload && !clutPositionChanged) {
-        return;
-    }
-
-    gpu->clutCacheColorDepth = bits;
-    gpu->clutCachePos = clut;
-
-    constexpr int entries = (bits == ColorDepth::BIT_8) ? 256 : 16;
-    for (int i = 0; i < entries; i++) {
-        gpu->clutCache[i] = gpuVRAM[clut.y][clut.x + i];
-    }
-}
-
 namespace {
-INLINE uint16_t tex4bit(gpu::GPU* gpu, ivec2 tex, ivec2 texPage) {
+INLINE uint16_t tex4bit(gpu::GPU* gpu, ivec2 tex, ivec2 texPage, const uint16_t* clut) {
     uint16_t index = gpuVRAM[(texPage.y + tex.y) & 511][(texPage.x + tex.x / 4) & 1023];
     uint8_t entry = (index >> ((tex.x & 3) * 4)) & 0xf;
-    return gpu->clutCache[entry];
+    return clut[entry];
 }
 
-INLINE uint16_t tex8bit(gpu::GPU* gpu, ivec2 tex, ivec2 texPage) {
+INLINE uint16_t tex8bit(gpu::GPU* gpu, ivec2 tex, ivec2 texPage, const uint16_t* clut) {
     uint16_t index = gpuVRAM[(texPage.y + tex.y) & 511][(texPage.x + tex.x / 2) & 1023];
     uint8_t entry = (index >> ((tex.x & 1) * 8)) & 0xff;
-    return gpu->clutCache[entry];
+    return clut[entry];
 }
 
 INLINE uint16_t tex16bit(gpu::GPU* gpu, ivec2 tex, ivec2 texPage) { return gpuVRAM[(texPage.y + tex.y) & 511][(texPage.x + tex.x) & 1023]; }
 
 template <ColorDepth bits>
-INLINE PSXColor fetchTex(gpu::GPU* gpu, ivec2 texel, const ivec2 texPage) {
+INLINE PSXColor fetchTex(gpu::GPU* gpu, ivec2 texel, const ivec2 texPage, const primitive::DrawState& state) {
+    if constexpr (bits == ColorDepth::BIT_4 || bits == ColorDepth::BIT_8) {
+        if (state.texture != nullptr) return state.texture[texel.y * TextureCache::SIZE + texel.x];
+    }
+
     if constexpr (bits == ColorDepth::BIT_4) {
-        return tex4bit(gpu, texel, texPage);
+        return tex4bit(gpu, texel, texPage, state.clut);
     } else if constexpr (bits == ColorDepth::BIT_8) {
-        return tex8bit(gpu, texel, texPage);
+        return tex8bit(gpu, texel, texPage, state.clut);
     } else if constexpr (bits == ColorDepth::BIT_16) {
         return tex16bit(gpu, texel, texPage);
     } else {
@@ -69,6 +50,21 @@ INLINE ivec2 maskTexel(ivec2 texel, const gpu::GP0_E2 textureWindow) {
 
     return texel;
 }
+// Primitive covering min - max might write texels it samples later, fast paths which fetch texels
+// ahead of writing them must not be used then
+template <ColorDepth bits>
+INLINE bool drawsOverTexture(const ivec2 texpage, const ivec2 min, const ivec2 max) {
+    if constexpr (bits == ColorDepth::NONE) {
+        return false;
+    } else {
+        constexpr int width = bits == ColorDepth::BIT_4 ? 64 : bits == ColorDepth::BIT_8 ? 128 : 256;
+        auto intersects = [&](int begin, int end) { return begin <= max.x && end > min.x; };
+
+        if (texpage.y > max.y || texpage.y + 256 <= min.y) return false;
+        // Texture page wraps at VRAM width
+        return intersects(texpage.x, texpage.x + width) || intersects(texpage.x - gpu::VRAM_WIDTH, texpage.x + width - gpu::VRAM_WIDTH);
+    }
+}
 };  // namespace
 
 #undef gpuVRAM
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "tile_renderer.h"
+#include <algorithm>
+#include <cstring>
+#include "render.h"
+
+TileRenderer::TileRenderer(gpu::GPU* gpu, int threads) : gpu(gpu) {
+    commands.reserve(MAX_COMMANDS);
+    activeTiles.reserve(TILES_X * TILES_Y);
+
+    // Emulation thread draws tiles as well while waiting for the flush
+    for (int i = 1; i < threads; i++) {
+        workers.emplace_back(&TileRenderer::workerFunc, this);
+    }
+}
+
+TileRenderer::~TileRenderer() {
+    flush();
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        exit = true;
+        hasWork.notify_all();
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+TileRenderer::Tiles TileRenderer::tilesOf(int x, int y, int w, int h) {
+    Tiles tiles;
+    if (w <= 0 || h <= 0) return tiles;
+
+    int columns = std::min((x + w - 1) / TILE_SIZE - x / TILE_SIZE + 1, TILES_X);
+    int rows = std::min((y + h - 1) / TILE_SIZE - y / TILE_SIZE + 1, TILES_Y);
+    for (int ty = 0; ty < rows; ty++) {
+        for (int tx = 0; tx < columns; tx++) {
+            int column = (x / TILE_SIZE + tx) % TILES_X;
+            int row = (y / TILE_SIZE + ty) % TILES_Y;
+            tiles.set(row * TILES_X + column);
+        }
+    }
+    return tiles;
+}
+
+TileRenderer::Tiles TileRenderer::textureTiles(int bits, ivec2 texpage) {
+    if (bits == 0) return {};
+
+    // Texture page is 256x256 texels, 4 and 8 bit texels are packed in VRAM halfwords
+    int width = bits == 4 ? 64 : bits == 8 ? 128 : 256;
+    return tilesOf(texpage.x, texpage.y, width, 256);
+}
+
+void TileRenderer::drawTriangle(const primitive::Triangle& triangle, const primitive::DrawState& state) {
+    const auto& v = triangle.v;
+    ivec2 min(std::min({v[0].pos.x, v[1].pos.x, v[2].pos.x}), std::min({v[0].pos.y, v[1].pos.y, v[2].pos.y}));
+    ivec2 max(std::max({v[0].pos.x, v[1].pos.x, v[2].pos.x}), std::max({v[0].pos.y, v[1].pos.y, v[2].pos.y}));
+
+    // Skip rendering when distance between vertices is bigger than 1023x511
+    const ivec2 size = max - min;
+    if (size.x >= 1024 || size.y >= 512) return;
+
+    min = ivec2(state.minDrawingX(min.x), state.minDrawingY(min.y));
+    max = ivec2(state.maxDrawingX(max.x), state.maxDrawingY(max.y));
+
+    auto writes = tilesOf(min.x, min.y, max.x - min.x + 1, max.y - min.y + 1);
+    if (writes.none()) return;
+
+    submit({triangle, state}, writes, textureTiles(triangle.bits, triangle.texpage));
+}
+
+void TileRenderer::drawRectangle(const primitive::Rect& rect, const primitive::DrawState& state) {
+    if (rect.size.x >= 1024 || rect.size.y >= 512) return;
+
+    const ivec2 min(state.minDrawingX(rect.pos.x), state.minDrawingY(rect.pos.y));
+    const ivec2 max(state.maxDrawingX(rect.pos.x + rect.size.x - 1), state.maxDrawingY(rect.pos.y + rect.size.y - 1));
+
+    auto writes = tilesOf(min.x, min.y, max.x - min.x + 1, max.y - min.y + 1);
+    if (writes.none()) return;
+
+    submit({rect, state}, writes, textureTiles(rect.bits, rect.texpage));
+}
+
+void TileRenderer::drawLine(const primitive::Line& line, const primitive::DrawState& state) {
+    const auto& p = line.pos;
+    if (std::abs(p[0].x - p[1].x) >= 1024 || std::abs(p[0].y - p[1].y) >= 512) return;
+
+    const ivec2 min(state.minDrawingX(std::min(p[0].x, p[1].x)), state.minDrawingY(std::min(p[0].y, p[1].y)));
+    const ivec2 max(state.maxDrawingX(std::max(p[0].x, p[1].x)), state.maxDrawingY(std::max(p[0].y, p[1].y)));
+
+    auto writes = tilesOf(min.x, min.y, max.x - min.x + 1, max.y - min.y + 1);
+    if (writes.none()) return;
+
+    submit({line, state}, writes, {});
+}
+
+void TileRenderer::submit(Command command, const Tiles& writes, const Tiles& reads) {
+    if ((reads & pendingWrites).any() || (writes & pendingReads).any()) {
+        flush();
+    }
+
+    // Tiles of primitive drawing over its own texture would read texels written by other tiles
+    if ((reads & writes).any()) {
+        flush();
+        draw(command, command.state);
+        return;
+    }
+
+    // CLUT cache is reloaded between primitives, every queued one needs its own copy (unless texels were decoded already)
+    int bits = 0;
+    if (auto triangle = std::get_if<primitive::Triangle>(&command.primitive)) bits = triangle->bits;
+    if (auto rect = std::get_if<primitive::Rect>(&command.primitive)) bits = rect->bits;
+    if ((bits == 4 || bits == 8) && command.state.texture == nullptr) {
+        size_t size = (bits == 8 ? 256 : 16) * sizeof(uint16_t);
+        if (cluts.empty() || memcmp(cluts.back().data(), command.state.clut, size) != 0) {
+            auto& clut = cluts.emplace_back();
+            memcpy(clut.data(), command.state.clut, size);
+        }
+        command.state.clut = cluts.back().data();
+    }
+
+    auto index = static_cast<uint16_t>(commands.size());
+    commands.push_back(command);
+    for (size_t tile = 0; tile < writes.size(); tile++) {
+        if (writes[tile]) bins[tile].push_back(index);
+    }
+    pendingWrites |= writes;
+    pendingReads |= reads;
+
+    if (commands.size() >= MAX_COMMANDS) {
+        flush();
+    }
+}
+
+void TileRenderer::flush(int x, int y, int w, int h) {
+    if (((pendingWrites | pendingReads) & tilesOf(x, y, w, h)).any()) {
+        flush();
+    }
+}
+
+void TileRenderer::flush() {
+    if (commands.empty()) return;
+
+    activeTiles.clear();
+    for (int tile = 0; tile < TILES_X * TILES_Y; tile++) {
+        if (!bins[tile].empty()) activeTiles.push_back(tile);
+    }
+    nextTile = 0;
+    finishedTiles = 0;
+
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        running = true;
+        generation++;
+    }
+    hasWork.notify_all();
+
+    drawTiles();
+
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        workDone.wait(lk, [&] { return finishedTiles == activeTiles.size() && activeWorkers == 0; });
+        running = false;
+    }
+
+    for (int tile : activeTiles) bins[tile].clear();
+    commands.clear();
+    cluts.clear();
+    pendingWrites.reset();
+    pendingReads.reset();
+}
+
+void TileRenderer::draw(const Command& command, const primitive::DrawState& state) {
+    if (auto triangle = std::get_if<primitive::Triangle>(&command.primitive)) {
+        Render::drawTriangle(gpu, *triangle, state);
+    } else if (auto rect = std::get_if<primitive::Rect>(&command.primitive)) {
+        Render::drawRectangle(gpu, *rect, state);
+    } else if (auto line = std::get_if<primitive::Line>(&command.primitive)) {
+        Render::drawLine(gpu, *line, state);
+    }
+}
+
+void TileRenderer::drawTile(int tile) {
+    const int x = (tile % TILES_X) * TILE_SIZE;
+    const int y = (tile / TILES_X) * TILE_SIZE;
+
+    for (uint16_t index : bins[tile]) {
+        const auto& command = commands[index];
+
+        auto state = command.state;
+        state.clip.left = std::max(state.clip.left, x);
+        state.clip.top = std::max(state.clip.top, y);
+        state.clip.right = std::min(state.clip.right, x + TILE_SIZE - 1);
+        state.clip.bottom = std::min(state.clip.bottom, y + TILE_SIZE - 1);
+
+        draw(command, state);
+    }
+}
+
+void TileRenderer::drawTiles() {
+    for (;;) {
+        size_t i = nextTile++;
+        if (i >= activeTiles.size()) break;
+
+        drawTile(activeTiles[i]);
+
+        if (++finishedTiles == activeTiles.size()) {
+            std::unique_lock<std::mutex> lk(mutex);
+            workDone.notify_one();
+        }
+    }
+}
+
+void TileRenderer::workerFunc() {
+    uint32_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            hasWork.wait(lk, [&] { return exit || (running && generation != seen); });
+            if (exit) return;
+
+            seen = generation;
+            activeWorkers++;
+        }
+
+        drawTiles();
+
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            activeWorkers--;
+            workDone.notify_one();
+        }
+    }
+}
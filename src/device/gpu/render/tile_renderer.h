@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <variant>
+#include <vector>
+#include "device/gpu/gpu.h"
+
+/**
+ * Software renderer running on a worker pool.
+ * VRAM is divided into tiles, submitted primitives are queued in every tile they cover
+ * and drawn when the queue is flushed - tiles are rasterized in parallel, primitives within tile keep their order.
+ *
+ * Primitive sampling texture (or CLUT) written by queued primitive (and the other way around) flushes the queue first,
+ * so the result is the same as drawing every primitive right away.
+ * VRAM must not be accessed directly before the queue is flushed.
+ */
+class TileRenderer {
+   public:
+    static const int TILE_SIZE = 64;
+    static const int TILES_X = gpu::VRAM_WIDTH / TILE_SIZE;
+    static const int TILES_Y = gpu::VRAM_HEIGHT / TILE_SIZE;
+
+    TileRenderer(gpu::GPU* gpu, int threads);
+    ~TileRenderer();
+
+    void drawTriangle(const primitive::Triangle& triangle, const primitive::DrawState& state);
+    void drawRectangle(const primitive::Rect& rect, const primitive::DrawState& state);
+    void drawLine(const primitive::Line& line, const primitive::DrawState& state);
+
+    // Draws all queued primitives
+    void flush();
+
+    // Draws all queued primitives if any of them draws to or samples texture from given area (coordinates wrap around VRAM)
+    void flush(int x, int y, int w, int h);
+
+   private:
+    using Tiles = std::bitset<TILES_X * TILES_Y>;
+
+    // Queue is flushed when it gets this long, otherwise it would grow for the whole frame
+    static const size_t MAX_COMMANDS = 4096;
+
+    struct Command {
+        std::variant<primitive::Triangle, primitive::Rect, primitive::Line> primitive;
+        primitive::DrawState state;
+    };
+
+    gpu::GPU* gpu;
+
+    std::vector<Command> commands;
+    std::array<std::vector<uint16_t>, TILES_X * TILES_Y> bins;  // Indices of commands drawn in the tile
+    std::deque<std::array<uint16_t, 256>> cluts;                // CLUT cache contents used by queued commands
+    Tiles pendingWrites;
+    Tiles pendingReads;
+
+    // Worker pool
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable hasWork;
+    std::condition_variable workDone;
+    bool exit = false;
+    bool running = false;
+    uint32_t generation = 0;
+    int activeWorkers = 0;
+
+    std::vector<int> activeTiles;
+    std::atomic<size_t> nextTile = 0;
+    std::atomic<size_t> finishedTiles = 0;
+
+    static Tiles tilesOf(int x, int y, int w, int h);
+    static Tiles textureTiles(int bits, ivec2 texpage);
+
+    void submit(Command command, const Tiles& writes, const Tiles& reads);
+    void draw(const Command& command, const primitive::DrawState& state);
+    void drawTile(int tile);
+    void drawTiles();
+    void workerFunc();
+};
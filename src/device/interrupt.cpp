@@ -22,6 +22,7 @@ bool Interrupt::interruptPending() { return (status._reg & mask._reg) ? true : f
 void Interrupt::step() {
     // notify cop0
     sys->cpu->cop0.cause.interruptPending = interruptPending() ? 4 : 0;
+    sys->cpu->attention = true;
 }
 
 uint8_t Interrupt::read(uint32_t address) {
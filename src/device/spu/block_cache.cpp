@@ -0,0 +1,40 @@
+#include "block_cache.h"
+#include <algorithm>
+
+namespace spu {
+BlockCache::BlockCache() { clear(); }
+
+void BlockCache::decode(const uint8_t* ram, uint32_t address, int32_t prevSample[2], int16_t decoded[ADPCM::BLOCK_SAMPLES]) {
+    Entry& entry = entries[indexOf(address)];
+
+    if (entry.address != address || entry.prevSampleIn[0] != prevSample[0] || entry.prevSampleIn[1] != prevSample[1]) {
+        uint8_t block[16];
+        for (uint32_t i = 0; i < 16; i++) {
+            block[i] = ram[(address + i) % RAM_SIZE];
+        }
+
+        entry.address = address;
+        std::copy_n(prevSample, 2, entry.prevSampleIn);
+        std::copy_n(prevSample, 2, entry.prevSampleOut);
+        ADPCM::decode(block, entry.prevSampleOut, entry.samples.data());
+    }
+
+    std::copy_n(entry.prevSampleOut, 2, prevSample);
+    std::copy(entry.samples.begin(), entry.samples.end(), decoded);
+}
+
+void BlockCache::invalidate(uint32_t address) {
+    // Blocks are 8 byte aligned and 16 bytes long, two of them contain any byte
+    const uint32_t first = address & ~7u;
+    const uint32_t second = (first - 8) % RAM_SIZE;
+
+    for (uint32_t block : {first, second}) {
+        Entry& entry = entries[indexOf(block)];
+        if (entry.address == block) entry.address = NONE;
+    }
+}
+
+void BlockCache::clear() {
+    for (auto& entry : entries) entry.address = NONE;
+}
+}  // namespace spu
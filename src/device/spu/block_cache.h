@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "sound/adpcm.h"
+
+namespace spu {
+/**
+ * ADPCM blocks decoded from SPU RAM, so looped samples (instruments) are decoded once and reused.
+ * Decoded samples depend on block data and on the filter state (two previous samples) it was decoded with,
+ * entries are direct mapped by block address and invalidated by writes to SPU RAM.
+ */
+class BlockCache {
+   public:
+    static const uint32_t RAM_SIZE = 1024 * 512;  // Same as SPU::RAM_SIZE
+
+    BlockCache();
+
+    // Decodes 16 byte block at given address (8 byte aligned, wraps around RAM), prevSample is updated like in ADPCM::decode
+    void decode(const uint8_t* ram, uint32_t address, int32_t prevSample[2], int16_t decoded[ADPCM::BLOCK_SAMPLES]);
+
+    // Drops blocks containing written byte
+    void invalidate(uint32_t address);
+    void clear();
+
+   private:
+    static const uint32_t ENTRIES = 8192;
+    static const uint32_t NONE = 0xffffffff;
+
+    struct Entry {
+        uint32_t address = NONE;
+        int32_t prevSampleIn[2];
+        int32_t prevSampleOut[2];
+        std::array<int16_t, ADPCM::BLOCK_SAMPLES> samples;
+    };
+
+    std::array<Entry, ENTRIES> entries;
+
+    static uint32_t indexOf(uint32_t address) { return (address / 8) % ENTRIES; }
+};
+}  // namespace spu
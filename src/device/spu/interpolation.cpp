@@ -1,7 +1,8 @@
 #include "interpolation.h"
-#include <cstdlib>
-namespace {
-std::array<int16_t, 0x200> gauss = {
+
+namespace spu {
+// int32_t so it can be gathered by AVX2 code
+const std::array<int32_t, 0x200> gauss = {
     {-0x001, -0x001, -0x001, -0x001, -0x001, -0x001, -0x001, 0x001,  -0x001, -0x001, -0x001, -0x001, -0x001, -0x001, -0x001, 0x001,  0x0000,
      0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0001, 0x0001, 0x0001, 0x0001, 0x0002, 0x0002, 0x0002, 0x0003, 0x0003, 0x0003, 0x0004,
      0x0004, 0x0005, 0x0005, 0x0006, 0x0007, 0x0007, 0x0008, 0x0009, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F, 0x0010, 0x0011,
@@ -33,31 +34,4 @@ std::array<int16_t, 0x200> gauss = {
      0x573E, 0x5761, 0x5782, 0x57A3, 0x57C3, 0x57E2, 0x57FF, 0x581C, 0x5838, 0x5853, 0x586D, 0x5886, 0x589E, 0x58B5, 0x58CB, 0x58E0, 0x58F4,
      0x5907, 0x5919, 0x592A, 0x593A, 0x5949, 0x5958, 0x5965, 0x5971, 0x597C, 0x5986, 0x598F, 0x5997, 0x599E, 0x59A4, 0x59A9, 0x59AD, 0x59B0,
      0x59B2, 0x59B3}};
-};
-
-namespace spu {
-int16_t sample(Voice &v, int p) {
-    if (p < 0) {
-        if (v.prevDecodedSamples.empty()) return 0;
-
-        return v.prevDecodedSamples[v.prevDecodedSamples.size() - std::abs(p)];
-    }
-    return v.decodedSamples[p];
-}
-
-int16_t interpolate(Voice &v, int pos, int i) {
-    // Store two ADPCM rows? zero out if outside?
-    int16_t oldest = sample(v, pos - 3);
-    int16_t older = sample(v, pos - 2);
-    int16_t old = sample(v, pos - 1);
-    int16_t new_ = sample(v, pos);
-
-    int16_t out = 0;
-    out += (gauss[0x0ff - i] * oldest) >> 15;
-    out += (gauss[0x1ff - i] * older) >> 15;
-    out += (gauss[0x100 + i] * old) >> 15;
-    out += (gauss[0x000 + i] * new_) >> 15;
-
-    return out;
-}
-}  // namespace spu
\ No newline at end of file
+}  // namespace spu
@@ -1,6 +1,9 @@
 #pragma once
-#include "spu.h"
+#include <array>
+#include <cstdint>
 
 namespace spu {
-    int16_t interpolate(Voice &v, int pos, int i);
-}  // namespace spu
\ No newline at end of file
+// Gaussian interpolation table, taps of sample at pos use
+// gauss[0x0ff - i], gauss[0x1ff - i], gauss[0x100 + i], gauss[i] for samples pos-3..pos
+extern const std::array<int32_t, 0x200> gauss;
+}  // namespace spu
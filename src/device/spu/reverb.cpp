@@ -1,11 +1,22 @@
 #include "reverb.h"
-#include <vector>
-#include "adsr.h"
+#include <algorithm>
 #include "sample.h"
-#include "device/device.h"
-#include "utils/math.h"
+#include "spu.h"
 
 namespace spu {
+namespace {
+enum Tap {
+    // IIR
+    LSAME, RSAME, LDIFF, RDIFF,
+    LSAME_PREV, RSAME_PREV, LDIFF_PREV, RDIFF_PREV,
+    DLSAME, DRSAME, DLDIFF, DRDIFF,
+    // Comb filter
+    LCOMB1, RCOMB1, LCOMB2, RCOMB2, LCOMB3, RCOMB3, LCOMB4, RCOMB4,
+    // All pass filters
+    LAPF1, RAPF1, LAPF2, RAPF2,
+    LAPF1_SRC, RAPF1_SRC, LAPF2_SRC, RAPF2_SRC,
+};
+
 uint32_t wrap(SPU* spu, uint32_t address) {
     const uint32_t reverbBase = spu->reverbBase._reg * 8;
 
@@ -15,34 +26,102 @@ uint32_t wrap(SPU* spu, uint32_t address) {
     return (reverbBase + rel) & 0x7fffe;
 }
 
-void write(SPU* spu, uint32_t address, Sample sample) {
-    uint16_t clamped = sample;
+// Offsets of taps from the current address
+std::array<uint32_t, ReverbBlock::TAPS> tapOffsets(SPU* spu) {
+    const auto REG = [spu](int r) -> uint32_t {  //
+        return spu->reverbRegisters[r]._reg * 8;
+    };
+
+    const uint32_t dAPF1 = REG(0x00);
+    const uint32_t dAPF2 = REG(0x01);
+
+    std::array<uint32_t, ReverbBlock::TAPS> offsets;
+    offsets[LSAME] = REG(0x0A);
+    offsets[RSAME] = REG(0x0B);
+    offsets[LDIFF] = REG(0x12);
+    offsets[RDIFF] = REG(0x13);
+    for (int i = 0; i < 4; i++) offsets[LSAME_PREV + i] = offsets[LSAME + i] - 2;
+    offsets[DLSAME] = REG(0x10);
+    offsets[DRSAME] = REG(0x11);
+    offsets[DLDIFF] = REG(0x18);
+    offsets[DRDIFF] = REG(0x19);
+    offsets[LCOMB1] = REG(0x0C);
+    offsets[RCOMB1] = REG(0x0D);
+    offsets[LCOMB2] = REG(0x0E);
+    offsets[RCOMB2] = REG(0x0F);
+    offsets[LCOMB3] = REG(0x14);
+    offsets[RCOMB3] = REG(0x15);
+    offsets[LCOMB4] = REG(0x16);
+    offsets[RCOMB4] = REG(0x17);
+    offsets[LAPF1] = REG(0x1A);
+    offsets[RAPF1] = REG(0x1B);
+    offsets[LAPF2] = REG(0x1C);
+    offsets[RAPF2] = REG(0x1D);
+    offsets[LAPF1_SRC] = offsets[LAPF1] - dAPF1;
+    offsets[RAPF1_SRC] = offsets[RAPF1] - dAPF1;
+    offsets[LAPF2_SRC] = offsets[LAPF2] - dAPF2;
+    offsets[RAPF2_SRC] = offsets[RAPF2] - dAPF2;
+    return offsets;
+}
+
+void startBlock(SPU* spu, ReverbBlock& block) {
+    const uint32_t base = spu->reverbBase._reg * 8;
+    const uint32_t size = spu->RAM_SIZE - base;
+    const uint32_t current = spu->reverbCurrentAddress;
+    const auto offsets = tapOffsets(spu);
+
+    // Current address outside of work area (or not aligned) jumps on the next wrap, such samples are done one by one
+    const bool linear = current >= base && current % 2 == 0;
+
+    uint64_t length = ReverbBlock::MAX_LENGTH;
+    if (linear) length = std::min<uint64_t>(length, (size - (current - base)) / 2);
+
+    for (int i = 0; i < ReverbBlock::TAPS; i++) {
+        // Same as wrap, relative address can also overflow 32 bits when offset is negative
+        const uint32_t rel = current + offsets[i] - base;
+        block.address[i] = wrap(spu, current + offsets[i]);
+
+        length = std::min<uint64_t>(length, ((1ull << 32) - rel) / 2);
+        length = std::min<uint64_t>(length, (size - rel % size) / 2);
+    }
 
-    uint32_t addr = wrap(spu, spu->reverbCurrentAddress + address);
-    spu->ram[addr + 0] = clamped & 0xff;
-    spu->ram[addr + 1] = (clamped >> 8) & 0xff;
+    block.start = current;
+    block.length = linear ? static_cast<int>(length) : 1;
+    block.position = 0;
 }
 
 Sample read(SPU* spu, uint32_t address) {
-    uint32_t addr = wrap(spu, spu->reverbCurrentAddress + address);
-    uint16_t data = spu->ram[addr] | (spu->ram[addr + 1] << 8);
+    uint16_t data = spu->ram[address] | (spu->ram[address + 1] << 8);
     return data;
 }
 
+void write(SPU* spu, uint32_t address, Sample sample) {
+    uint16_t clamped = sample;
+
+    spu->ram[address + 0] = clamped & 0xff;
+    spu->ram[address + 1] = (clamped >> 8) & 0xff;
+    spu->blockCache.invalidate(address);  // Both bytes are in the same 8 byte unit
+}
+};  // namespace
+
 std::tuple<int16_t, int16_t> doReverb(SPU* spu, std::tuple<int16_t, int16_t> input) {
+    ReverbBlock& block = spu->reverbBlock;
+    if (block.position >= block.length || spu->reverbCurrentAddress != block.start + block.position * 2) {
+        startBlock(spu, block);
+    }
+    const uint32_t step = block.position * 2;
+
     const auto REG = [spu](int r) {  //
         return spu->reverbRegisters[r]._reg;
     };
-    const auto R = [spu](uint32_t addr) {  //
-        return read(spu, addr);
+    const auto R = [spu, &block, step](Tap tap) {  //
+        return read(spu, block.address[tap] + step);
     };
-    const auto W = [spu](uint32_t addr, Sample sample) {  //
+    const auto W = [spu, &block, step](Tap tap, Sample sample) {  //
         if (!spu->control.masterReverb) return;
-        return write(spu, addr, sample);
+        return write(spu, block.address[tap] + step, sample);
     };
 
-    const uint32_t dAPF1 = REG(0x00) * 8;
-    const uint32_t dAPF2 = REG(0x01) * 8;
     const Sample vIIR = REG(0x02);
     const Sample vCOMB1 = REG(0x03);
     const Sample vCOMB2 = REG(0x04);
@@ -51,56 +130,40 @@ std::tuple<int16_t, int16_t> doReverb(SPU* spu, std::tuple<int16_t, int16_t> inp
     const Sample vWALL = REG(0x07);
     const Sample vAPF1 = REG(0x08);
     const Sample vAPF2 = REG(0x09);
-    const uint32_t mLSAME = REG(0x0A) * 8;
-    const uint32_t mRSAME = REG(0x0B) * 8;
-    const uint32_t mLCOMB1 = REG(0x0C) * 8;
-    const uint32_t mRCOMB1 = REG(0x0D) * 8;
-    const uint32_t mLCOMB2 = REG(0x0E) * 8;
-    const uint32_t mRCOMB2 = REG(0x0F) * 8;
-    const uint32_t dLSAME = REG(0x10) * 8;
-    const uint32_t dRSAME = REG(0x11) * 8;
-    const uint32_t mLDIFF = REG(0x12) * 8;
-    const uint32_t mRDIFF = REG(0x13) * 8;
-    const uint32_t mLCOMB3 = REG(0x14) * 8;
-    const uint32_t mRCOMB3 = REG(0x15) * 8;
-    const uint32_t mLCOMB4 = REG(0x16) * 8;
-    const uint32_t mRCOMB4 = REG(0x17) * 8;
-    const uint32_t dLDIFF = REG(0x18) * 8;
-    const uint32_t dRDIFF = REG(0x19) * 8;
-    const uint32_t mLAPF1 = REG(0x1A) * 8;
-    const uint32_t mRAPF1 = REG(0x1B) * 8;
-    const uint32_t mLAPF2 = REG(0x1C) * 8;
-    const uint32_t mRAPF2 = REG(0x1D) * 8;
     const Sample vLIN = REG(0x1E);
     const Sample vRIN = REG(0x1F);
 
     Sample Lin = vLIN * std::get<0>(input);
     Sample Rin = vRIN * std::get<1>(input);
 
-    W(mLSAME, (Lin + R(dLSAME) * vWALL - R(mLSAME - 2)) * vIIR + R(mLSAME - 2));
-    W(mRSAME, (Rin + R(dRSAME) * vWALL - R(mRSAME - 2)) * vIIR + R(mRSAME - 2));
-
-    W(mLDIFF, (Lin + R(dRDIFF) * vWALL - R(mLDIFF - 2)) * vIIR + R(mLDIFF - 2));
-    W(mRDIFF, (Rin + R(dLDIFF) * vWALL - R(mRDIFF - 2)) * vIIR + R(mRDIFF - 2));
-
-    Sample Lout = vCOMB1 * R(mLCOMB1) + vCOMB2 * R(mLCOMB2) + vCOMB3 * R(mLCOMB3) + vCOMB4 * R(mLCOMB4);
-    Sample Rout = vCOMB1 * R(mRCOMB1) + vCOMB2 * R(mRCOMB2) + vCOMB3 * R(mRCOMB3) + vCOMB4 * R(mRCOMB4);
-
-    Lout = Lout - (vAPF1 * R(mLAPF1 - dAPF1));
-    W(mLAPF1, Lout);
-    Lout = Lout * vAPF1 + R(mLAPF1 - dAPF1);
-    Rout = Rout - (vAPF1 * R(mRAPF1 - dAPF1));
-    W(mRAPF1, Rout);
-    Rout = Rout * vAPF1 + R(mRAPF1 - dAPF1);
-
-    Lout = Lout - (vAPF2 * R(mLAPF2 - dAPF2));
-    W(mLAPF2, Lout);
-    Lout = Lout * vAPF2 + R(mLAPF2 - dAPF2);
-    Rout = Rout - (vAPF2 * R(mRAPF2 - dAPF2));
-    W(mRAPF2, Rout);
-    Rout = Rout * vAPF2 + R(mRAPF2 - dAPF2);
-
-    spu->reverbCurrentAddress = wrap(spu, spu->reverbCurrentAddress + 2);
+    W(LSAME, (Lin + R(DLSAME) * vWALL - R(LSAME_PREV)) * vIIR + R(LSAME_PREV));
+    W(RSAME, (Rin + R(DRSAME) * vWALL - R(RSAME_PREV)) * vIIR + R(RSAME_PREV));
+
+    W(LDIFF, (Lin + R(DRDIFF) * vWALL - R(LDIFF_PREV)) * vIIR + R(LDIFF_PREV));
+    W(RDIFF, (Rin + R(DLDIFF) * vWALL - R(RDIFF_PREV)) * vIIR + R(RDIFF_PREV));
+
+    Sample Lout = vCOMB1 * R(LCOMB1) + vCOMB2 * R(LCOMB2) + vCOMB3 * R(LCOMB3) + vCOMB4 * R(LCOMB4);
+    Sample Rout = vCOMB1 * R(RCOMB1) + vCOMB2 * R(RCOMB2) + vCOMB3 * R(RCOMB3) + vCOMB4 * R(RCOMB4);
+
+    Lout = Lout - (vAPF1 * R(LAPF1_SRC));
+    W(LAPF1, Lout);
+    Lout = Lout * vAPF1 + R(LAPF1_SRC);
+    Rout = Rout - (vAPF1 * R(RAPF1_SRC));
+    W(RAPF1, Rout);
+    Rout = Rout * vAPF1 + R(RAPF1_SRC);
+
+    Lout = Lout - (vAPF2 * R(LAPF2_SRC));
+    W(LAPF2, Lout);
+    Lout = Lout * vAPF2 + R(LAPF2_SRC);
+    Rout = Rout - (vAPF2 * R(RAPF2_SRC));
+    W(RAPF2, Rout);
+    Rout = Rout * vAPF2 + R(RAPF2_SRC);
+
+    if (++block.position < block.length) {
+        spu->reverbCurrentAddress += 2;
+    } else {
+        spu->reverbCurrentAddress = wrap(spu, spu->reverbCurrentAddress + 2);
+    }
 
     return std::make_tuple(                  //
         Lout * spu->reverbVolume.getLeft(),  //
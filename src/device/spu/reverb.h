@@ -1,7 +1,28 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <tuple>
-#include "spu.h"
 
 namespace spu {
+struct SPU;
+
+/**
+ * Reverb work area addresses (taps) used by consecutive reverb samples.
+ * They are computed once for a block of samples during which neither current address nor any tap wraps around,
+ * so n-th sample of the block uses address + n * 2 of every tap.
+ */
+struct ReverbBlock {
+    static const int MAX_LENGTH = 32;
+    static const int TAPS = 28;
+
+    std::array<uint32_t, TAPS> address;  // Taps of the first sample
+    uint32_t start = 0;                  // reverbCurrentAddress of the first sample
+    int length = 0;
+    int position = 0;
+
+    // Has to be called when reverb registers or work area are changed
+    void invalidate() { length = 0; }
+};
+
 std::tuple<int16_t, int16_t> doReverb(SPU* spu, std::tuple<int16_t, int16_t> input);
-}  // namespace spu
\ No newline at end of file
+}  // namespace spu
@@ -1,10 +1,10 @@
 #include "spu.h"
 #include <fmt/core.h>
+#include <algorithm>
 #include <array>
 #include <functional>
 #include <vector>
 #include "device/cdrom/cdrom.h"
-#include "interpolation.h"
 #include "reverb.h"
 #include "sample.h"
 #include "sound/adpcm.h"
@@ -20,6 +20,7 @@ SPU::SPU(System* sys) : sys(sys) {
     ram.fill(0);
     audioBufferPos = 0;
     captureBufferIndex = 0;
+    for (int v = 0; v < VOICE_COUNT; v++) lanes.load(v, voices[v]);
 }
 
 void SPU::step(device::cdrom::CDROM* cdrom) {
@@ -28,53 +29,47 @@ void SPU::step(device::cdrom::CDROM* cdrom) {
 
     noise.doNoise(control.noiseFrequencyStep, control.noiseFrequencyShift);
 
+    // Voices which finish playing in this step (envelope or KeyOff) are still mixed
+    const uint32_t active = lanes.active;
     for (int v = 0; v < VOICE_COUNT; v++) {
-        Voice& voice = voices[v];
-
-        if (voice.state == Voice::State::Off) continue;
-
-        if (voice.decodedSamples.empty()) {
-            auto block = readBlock(voice.currentAddress._reg * 8);
-            voice.decodedSamples = ADPCM::decode(block.data(), voice.prevSample);
-            voice.flagsParsed = false;
-        }
+        if ((active & (1u << v)) == 0 || voices[v].blockDecoded) continue;
+        decodeBlock(v);
+        voices[v].flagsParsed = false;
+    }
 
-        voice.processEnvelope();
+    const uint32_t phaseEnded = lanes.processEnvelopes();
+    for (int v = 0; v < VOICE_COUNT; v++) {
+        if ((phaseEnded & (1u << v)) == 0) continue;
+        voices[v].state = voices[v].nextState(voices[v].state);
+        lanes.adsrWaitCycles[v] = 0;
+        lanes.load(v, voices[v]);
+    }
 
-        uint32_t step = voice.sampleRate._reg;
-        if (voice.pitchModulation && v > 0) {
-            int32_t factor = voices[v - 1].sample + 0x8000;
-            step = (step * factor) >> 15;
-            step &= 0xffff;
-        }
-        if (step > 0x3fff) step = 0x4000;
+    const uint32_t blockEnded = lanes.mix(active, noise.getNoiseLevel());
 
-        Sample sample;
-        if (voice.mode == Voice::Mode::Noise) {
-            sample = noise.getNoiseLevel();
-        } else {
-            sample = interpolate(voice, voice.counter.sample, voice.counter.index);
-        }
-        sample *= voice.adsrVolume._reg;
-        voice.sample = sample;
+    // Saturated sums depend on the order of voices
+    for (int v = 0; v < VOICE_COUNT; v++) {
+        if ((active & (1u << v)) == 0) continue;
+        Voice& voice = voices[v];
 
         if (voice.enabled) {
-            sumLeft += sample * voice.volume.getLeft();
-            sumRight += sample * voice.volume.getRight();
+            const int16_t left = static_cast<int16_t>(lanes.left[v]);
+            const int16_t right = static_cast<int16_t>(lanes.right[v]);
+            sumLeft += left;
+            sumRight += right;
 
             if (voice.reverb) {
-                sumReverbLeft += sample * voice.volume.getLeft();
-                sumReverbRight += sample * voice.volume.getRight();
+                sumReverbLeft += left;
+                sumReverbRight += right;
             }
         }
 
-        voice.counter._reg += step;
-        if (voice.counter.sample >= 28) {
+        if (blockEnded & (1u << v)) {
             // Overflow, parse next ADPCM block
-            voice.counter.sample -= 28;
             voice.currentAddress._reg += 2;
-            voice.prevDecodedSamples = voice.decodedSamples;
-            voice.decodedSamples.clear();
+            auto& samples = lanes.samples[v];
+            std::copy_n(samples.begin() + ADPCM::BLOCK_SAMPLES, VoiceLanes::HISTORY, samples.begin());
+            voice.blockDecoded = false;
 
             if (voice.loadRepeatAddress) {
                 voice.loadRepeatAddress = false;
@@ -82,8 +77,10 @@ void SPU::step(device::cdrom::CDROM* cdrom) {
             }
         }
 
-        if (!voice.flagsParsed) {
-            voice.parseFlags(ram[voice.currentAddress._reg * 8 + 1]);
+        if (!voice.flagsParsed && voice.parseFlags(ram[voice.currentAddress._reg * 8 + 1])) {
+            lanes.adsrVolume[v] = 0;
+            lanes.adsrWaitCycles[v] = 0;
+            lanes.load(v, voice);
         }
     }
 
@@ -142,8 +139,8 @@ void SPU::step(device::cdrom::CDROM* cdrom) {
 
     memoryWrite16(cdLeftAddress, cdLeft);
     memoryWrite16(cdRightAddress, cdRight);
-    memoryWrite16(voice1Address, voices[1].sample);
-    memoryWrite16(voice3Address, voices[3].sample);
+    memoryWrite16(voice1Address, lanes.voiceSample(1));
+    memoryWrite16(voice3Address, lanes.voiceSample(3));
 }
 
 uint8_t SPU::readVoice(uint32_t address) const {
@@ -168,7 +165,11 @@ uint8_t SPU::readVoice(uint32_t address) const {
         case 11: return voices[voice].adsr.read(reg - 8);
 
         case 12:
-        case 13: return voices[voice].adsrVolume.read(reg - 12);
+        case 13: {
+            Reg16 adsrVolume;
+            adsrVolume._reg = lanes.adsrVolume[voice];
+            return adsrVolume.read(reg - 12);
+        }
 
         case 14:
         case 15: return voices[voice].repeatAddress.read(reg - 14);
@@ -187,7 +188,7 @@ void SPU::writeVoice(uint32_t address, uint8_t data) {
             case 5: return fmt::format("Sample rate: 0x{:04x}", voices[voice].sampleRate._reg);
             case 7: return fmt::format("Start address: 0x{:04x}", voices[voice].startAddress._reg);
             case 11: return fmt::format("ADSR: 0x{:08x}", voices[voice].adsr._reg);
-            case 13: return fmt::format("ADSR Volume: 0x{:04}", voices[voice].adsrVolume._reg);
+            case 13: return fmt::format("ADSR Volume: 0x{:04}", lanes.adsrVolume[voice]);
             case 15: return fmt::format("Repeat address: 0x{:04}", voices[voice].repeatAddress._reg);
             default: return std::string();
         }
@@ -209,25 +210,38 @@ void SPU::writeVoice(uint32_t address, uint8_t data) {
             if (reg == 3 && ((voices[voice].volume.left & 0x8000) || (voices[voice].volume.right & 0x8000))) {
                 fmt::print("[SPU][WARN] Volume Sweep enabled for voice {} (not implemented yet)\n", voice);
             }
+            lanes.load(voice, voices[voice]);
             return;
 
         case 4:
-        case 5: voices[voice].sampleRate.write(reg - 4, data); return;
+        case 5:
+            voices[voice].sampleRate.write(reg - 4, data);
+            lanes.load(voice, voices[voice]);
+            return;
 
         case 6:
         case 7:
-            voices[voice].counter._reg = 0;
-            voices[voice].prevDecodedSamples.clear();  // TODO: Not sure is this is what real hardware does
+            lanes.counter[voice] = 0;
+            lanes.clearHistory(voice);  // TODO: Not sure is this is what real hardware does
             voices[voice].startAddress.write(reg - 6, data);
             return;
 
         case 8:
         case 9:
         case 10:
-        case 11: voices[voice].adsr.write(reg - 8, data); return;
+        case 11:
+            voices[voice].adsr.write(reg - 8, data);
+            lanes.load(voice, voices[voice]);
+            return;
 
         case 12:
-        case 13: voices[voice].adsrVolume.write(reg - 12, data); return;
+        case 13: {
+            Reg16 adsrVolume;
+            adsrVolume._reg = lanes.adsrVolume[voice];
+            adsrVolume.write(reg - 12, data);
+            lanes.adsrVolume[voice] = adsrVolume._reg;
+            return;
+        }
 
         case 14:
         case 15:
@@ -386,7 +400,11 @@ void SPU::write(uint32_t address, uint8_t data) {
 
     if (address >= 0x1f801d88 && address <= 0x1f801d8b) {  // Voices Key On
         FOR_EACH_VOICE(address - 0x1f801d88, [&](int v, bool bit) {
-            if (control.spuEnable && bit) voices[v].keyOn(sys->cycles);
+            if (control.spuEnable && bit) {
+                voices[v].keyOn(sys->cycles);
+                lanes.keyOn(v);
+                lanes.load(v, voices[v]);
+            }
             if (bit && verbose) fmt::print("[SPU] W Voice {:2d}, KeyOn\n", v + 1);
         });
         return;
@@ -394,7 +412,10 @@ void SPU::write(uint32_t address, uint8_t data) {
 
     if (address >= 0x1f801d8c && address <= 0x1f801d8f) {  // Voices Key Off
         FOR_EACH_VOICE(address - 0x1f801d8c, [&](int v, bool bit) {
-            if (control.spuEnable && bit) voices[v].keyOff(sys->cycles);
+            if (control.spuEnable && bit && voices[v].keyOff(sys->cycles)) {
+                lanes.adsrWaitCycles[v] = 0;
+                lanes.load(v, voices[v]);
+            }
             if (bit && verbose) fmt::print("[SPU] W Voice {:2d}, KeyOff\n", v + 1);
         });
         return;
@@ -403,12 +424,16 @@ void SPU::write(uint32_t address, uint8_t data) {
     if (address >= 0x1F801D90 && address <= 0x1F801D93) {  // Pitch modulation enable flags
         FOR_EACH_VOICE(address - 0x1F801D90, [&](int v, bool bit) {
             if (v > 0) voices[v].pitchModulation = bit;
+            lanes.load(v, voices[v]);
         });
         return;
     }
 
     if (address >= 0x1F801D94 && address <= 0x1F801D97) {  // Voice noise mode
-        FOR_EACH_VOICE(address - 0x1F801D94, [&](int v, bool bit) { voices[v].mode = bit ? Voice::Mode::Noise : Voice::Mode::ADSR; });
+        FOR_EACH_VOICE(address - 0x1F801D94, [&](int v, bool bit) {
+            voices[v].mode = bit ? Voice::Mode::Noise : Voice::Mode::ADSR;
+            lanes.load(v, voices[v]);
+        });
         return;
     }
 
@@ -427,6 +452,7 @@ void SPU::write(uint32_t address, uint8_t data) {
 
     if (address >= 0x1F801DA2 && address <= 0x1F801DA3) {  // Reverb Work area start
         reverbBase.write(address - 0x1F801DA2, data);
+        reverbBlock.invalidate();
         if (address == 0x1F801DA3) {
             reverbCurrentAddress = reverbBase._reg * 8;
         }
@@ -461,9 +487,7 @@ void SPU::write(uint32_t address, uint8_t data) {
             status.irqFlag = false;
         }
         if (!control.spuEnable) {
-            for (auto& v : voices) {
-                v.adsrVolume._reg = 0;
-            }
+            lanes.adsrVolume.fill(0);
         }
         return;
     }
@@ -487,6 +511,7 @@ void SPU::write(uint32_t address, uint8_t data) {
         auto reg = (address - 0x1F801DC0) / 2;
         auto byte = (address - 0x1F801DC0) % 2;
         reverbRegisters[reg].write(byte, data);
+        reverbBlock.invalidate();
         return;
     }
 
@@ -504,6 +529,7 @@ uint8_t SPU::memoryRead8(uint32_t address) {
 
 void SPU::memoryWrite8(uint32_t address, uint8_t data) {
     ram[address] = data;
+    blockCache.invalidate(address);
 
     if (control.irqEnable && address == irqAddress._reg * 8) {
         status.irqFlag = true;
@@ -516,15 +542,16 @@ void SPU::memoryWrite16(uint32_t address, uint16_t data) {
     memoryWrite8(address + 1, (uint8_t)(data >> 8));
 }
 
-std::array<uint8_t, 16> SPU::readBlock(uint32_t address) {
+void SPU::decodeBlock(int v) {
+    Voice& voice = voices[v];
+    const uint32_t address = voice.currentAddress._reg * 8;
     if (control.irqEnable && address == irqAddress._reg * 8) {
         status.irqFlag = true;
         sys->interrupt->trigger(interrupt::SPU);
     }
 
-    std::array<uint8_t, 16> buf;
-    std::copy(ram.begin() + address, ram.begin() + address + 16, buf.begin());
-    return buf;
+    blockCache.decode(ram.data(), address, voice.prevSample, lanes.samples[v].data() + VoiceLanes::HISTORY);
+    voice.blockDecoded = true;
 }
 
 void SPU::dumpRam() {
@@ -1,9 +1,13 @@
 #pragma once
 #include <array>
+#include <cstddef>
+#include "block_cache.h"
 #include "device/device.h"
 #include "noise.h"
 #include "regs.h"
+#include "reverb.h"
 #include "voice.h"
+#include "voice_lanes.h"
 
 struct System;
 
@@ -21,6 +25,8 @@ struct SPU {
     int verbose;
 
     std::array<Voice, VOICE_COUNT> voices;
+    VoiceLanes lanes;
+    static_assert(VOICE_COUNT == VoiceLanes::COUNT, "VoiceLanes must have a lane for every voice");
 
     Volume mainVolume;
     Volume cdVolume;
@@ -42,6 +48,7 @@ struct SPU {
     Reg32 _keyOff;
 
     std::array<uint8_t, RAM_SIZE> ram;
+    BlockCache blockCache;  // Has to be invalidated on every RAM write
 
     Reg16 reverbBase;
     std::array<Reg16, 32> reverbRegisters;
@@ -49,6 +56,7 @@ struct SPU {
     int16_t reverbLeft = 0;
     int16_t reverbRight = 0;
     int reverbCounter = 0;
+    ReverbBlock reverbBlock;  // Not serialized
 
     bool bufferReady = false;
     size_t audioBufferPos;
@@ -71,12 +79,14 @@ struct SPU {
     uint8_t memoryRead8(uint32_t address);
     void memoryWrite8(uint32_t address, uint8_t data);
     void memoryWrite16(uint32_t address, uint16_t data);
-    std::array<uint8_t, 16> readBlock(uint32_t address);
+    void decodeBlock(int v);
     void dumpRam();
 
     template <class Archive>
     void serialize(Archive& ar) {
         ar(voices);
+        ar(lanes);
+        for (int v = 0; v < VOICE_COUNT; v++) lanes.load(v, voices[v]);
         ar(mainVolume._reg);
         ar(cdVolume._reg);
         ar(extVolume._reg);
@@ -92,10 +102,12 @@ struct SPU {
         ar(_keyOn);
         ar(_keyOff);
         ar(ram);
+        blockCache.clear();  // Not saved, loaded RAM might not match decoded blocks
 
         ar(reverbBase);
         ar(reverbRegisters);
         ar(reverbCurrentAddress);
+        reverbBlock.invalidate();
 
         ar(bufferReady);
         ar(audioBufferPos);
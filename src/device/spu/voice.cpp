@@ -10,20 +10,18 @@ Voice::Voice() {
     sampleRate._reg = 0;
     startAddress._reg = 0;
     adsr._reg = 0;
-    adsrVolume._reg = 0;
     repeatAddress._reg = 0;
     currentAddress._reg = 0;
     ignoreLoadRepeatAddress = false;
-    counter._reg = 0;
     state = State::Off;
     loopEnd = false;
     mode = Mode::ADSR;
     pitchModulation = false;
     reverb = false;
-    adsrWaitCycles = 0;
     loadRepeatAddress = false;
 
     prevSample[0] = prevSample[1] = 0;
+    blockDecoded = false;
 
     enabled = true;
 }
@@ -48,45 +46,7 @@ Voice::State Voice::nextState(Voice::State current) {
     }
 }
 
-void Voice::processEnvelope() {
-    using Mode = Envelope::Mode;
-    using Dir = Envelope::Direction;
-    if (state == State::Off) return;
-
-    Envelope e = getCurrentPhase();
-
-    if (adsrWaitCycles > 0) adsrWaitCycles--;
-
-    auto cycles = 1 << std::max(0, e.shift - 11);
-    int step = e.getStep() << std::max(0, 11 - e.shift);
-
-    if (e.mode == Mode::Exponential) {
-        if (e.direction == Dir::Increase && adsrVolume._reg > 0x6000) {
-            cycles *= 4;
-        }
-        if (e.direction == Dir::Decrease) {
-            // Note: Division by 0x8000 might cause value to become 0,
-            // using right shift by 15 ensures that minimum it can go is -1.
-            // Games affected: Doom (when paused music does not fade out)
-            // Little Princess - Marl Oukoku no Ningyou-hime 2 (voices stop playing after a while)
-            step = (step * adsrVolume._reg) >> 15;
-        }
-    }
-
-    if (adsrWaitCycles == 0) {
-        adsrWaitCycles = cycles;
-        adsrVolume._reg = clamp(static_cast<int32_t>(adsrVolume._reg) + step, 0, 0x7fff);
-
-        if (e.level != -1
-            && ((e.direction == Dir::Increase && adsrVolume._reg >= e.level)
-                || (e.direction == Dir::Decrease && adsrVolume._reg <= e.level))) {
-            state = nextState(state);
-            adsrWaitCycles = 0;
-        }
-    }
-}
-
-void Voice::parseFlags(uint8_t flags) {
+bool Voice::parseFlags(uint8_t flags) {
     flagsParsed = true;
 
     // Mark beginning of the loop
@@ -101,16 +61,14 @@ void Voice::parseFlags(uint8_t flags) {
 
         // if Repeat == 0 - force Release
         if (!(flags & ADPCM::Flag::Repeat) && mode != Mode::Noise) {
-            adsrVolume._reg = 0;
-            keyOff();
+            return keyOff();
         }
     }
+    return false;
 }
 
 void Voice::keyOn(uint64_t cycles) {
-    decodedSamples.clear();
-    counter.sample = 0;
-    adsrVolume._reg = 0;
+    blockDecoded = false;
 
     // INFO: Square games load repeatAddress before keyOn,
     // setting it here to startAddress causes glitched sample repetitions.
@@ -124,24 +82,22 @@ void Voice::keyOn(uint64_t cycles) {
     state = Voice::State::Attack;
     loopEnd = false;
     loadRepeatAddress = false;
-    adsrWaitCycles = 0;
 
     prevSample[0] = prevSample[1] = 0;
-    prevDecodedSamples.clear();
 
     this->cycles = cycles;
 }
 
-void Voice::keyOff(uint64_t cycles) {
+bool Voice::keyOff(uint64_t cycles) {
     // SPU seems to ignore KeyOff events that were fired close to KeyOn.
     // Value of 384 cycles was picked by listening to Dragon Ball Final Bout - BGM 29
     // and comparing it to recording from real HW.
     // It's not verified by any tests for now
     if (cycles != 0 && cycles - this->cycles < 384) {
-        return;
+        return false;
     }
     state = Voice::State::Release;
-    adsrWaitCycles = 0;
+    return true;
 }
 
 }  // namespace spu
\ No newline at end of file
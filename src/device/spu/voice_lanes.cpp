@@ -0,0 +1,231 @@
+#include "voice_lanes.h"
+#include <algorithm>
+#include "interpolation.h"
+#include "utils/macros.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace spu {
+namespace {
+const uint32_t COUNTER_SAMPLE_MASK = 0x1f << 12;
+const int32_t COUNTER_BLOCK = ADPCM::BLOCK_SAMPLES << 12;
+
+INLINE int32_t counterSample(int32_t counter) { return (counter >> 12) & 0x1f; }
+INLINE int32_t counterIndex(int32_t counter) { return (counter >> 4) & 0xff; }
+
+// (a * b) >> 15 truncated to 16 bits, same as Sample multiplication
+INLINE int16_t mul(int32_t a, int32_t b) { return static_cast<int16_t>((a * b) >> 15); }
+
+#ifdef __AVX2__
+INLINE __m256i loadLanes(const VoiceLanes::Lanes& a, int v) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(a.data() + v)); }
+
+INLINE void storeLanes(VoiceLanes::Lanes& a, int v, __m256i x) { _mm256_store_si256(reinterpret_cast<__m256i*>(a.data() + v), x); }
+
+// Lane i is set to all ones if bit i of mask is set
+INLINE __m256i laneMask(uint32_t mask) {
+    const __m256i bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(mask), bit), bit);
+}
+
+INLINE uint32_t bitMask(__m256i lanes) { return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(lanes))); }
+
+INLINE __m256i truncate16(__m256i x) { return _mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16); }
+
+INLINE __m256i mul(__m256i a, __m256i b) { return truncate16(_mm256_srai_epi32(_mm256_mullo_epi32(a, b), 15)); }
+
+INLINE __m256i isTrue(__m256i x) { return _mm256_cmpeq_epi32(x, _mm256_set1_epi32(1)); }
+#endif
+};  // namespace
+
+void VoiceLanes::load(int v, Voice& voice) {
+    const uint32_t bit = 1u << v;
+    auto set = [bit](uint32_t& mask, bool on) { mask = on ? (mask | bit) : (mask & ~bit); };
+    set(active, voice.state != Voice::State::Off);
+    set(noise, voice.mode == Voice::Mode::Noise);
+    set(pitchModulation, voice.pitchModulation);
+
+    sampleRate[v] = voice.sampleRate._reg;
+    volumeLeft[v] = voice.volume.getLeft();
+    volumeRight[v] = voice.volume.getRight();
+
+    Envelope e = voice.getCurrentPhase();
+    envelopeCycles[v] = 1 << std::max(0, e.shift - 11);
+    envelopeStep[v] = e.getStep() << std::max(0, 11 - e.shift);
+    envelopeLevel[v] = e.level;
+    envelopeExponential[v] = e.mode == Envelope::Mode::Exponential;
+    envelopeDecrease[v] = e.direction == Envelope::Direction::Decrease;
+}
+
+void VoiceLanes::keyOn(int v) {
+    counter[v] &= ~COUNTER_SAMPLE_MASK;
+    adsrVolume[v] = 0;
+    adsrWaitCycles[v] = 0;
+    clearHistory(v);
+}
+
+void VoiceLanes::clearHistory(int v) { std::fill_n(samples[v].begin(), HISTORY, 0); }
+
+uint32_t VoiceLanes::processEnvelopes() {
+    uint32_t reached = 0;
+    int v = 0;
+#ifdef __AVX2__
+    const __m256i zero = _mm256_setzero_si256();
+    for (; v < COUNT; v += 8) {
+        if (((active >> v) & 0xff) == 0) continue;
+
+        const __m256i mask = laneMask(active >> v);
+        const __m256i exponential = isTrue(loadLanes(envelopeExponential, v));
+        const __m256i decrease = isTrue(loadLanes(envelopeDecrease, v));
+        const __m256i level = loadLanes(envelopeLevel, v);
+        __m256i volume = loadLanes(adsrVolume, v);
+        __m256i wait = loadLanes(adsrWaitCycles, v);
+        __m256i cycles = loadLanes(envelopeCycles, v);
+        __m256i step = loadLanes(envelopeStep, v);
+
+        wait = _mm256_add_epi32(wait, _mm256_cmpgt_epi32(wait, zero));
+
+        // Exponential increase is 4 times slower above 0x6000, exponential decrease is proportional to the volume
+        __m256i slow = _mm256_andnot_si256(decrease, _mm256_and_si256(exponential, _mm256_cmpgt_epi32(volume, _mm256_set1_epi32(0x6000))));
+        cycles = _mm256_blendv_epi8(cycles, _mm256_slli_epi32(cycles, 2), slow);
+        step = _mm256_blendv_epi8(step, _mm256_srai_epi32(_mm256_mullo_epi32(step, volume), 15), _mm256_and_si256(exponential, decrease));
+
+        const __m256i update = _mm256_and_si256(mask, _mm256_cmpeq_epi32(wait, zero));
+        wait = _mm256_blendv_epi8(wait, cycles, update);
+        __m256i newVolume = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(volume, step), zero), _mm256_set1_epi32(0x7fff));
+        volume = _mm256_blendv_epi8(volume, newVolume, update);
+
+        const __m256i above = _mm256_cmpgt_epi32(volume, level);
+        const __m256i below = _mm256_cmpgt_epi32(level, volume);
+        __m256i hit = _mm256_blendv_epi8(_mm256_xor_si256(below, mask), _mm256_xor_si256(above, mask), decrease);
+        hit = _mm256_andnot_si256(_mm256_cmpeq_epi32(level, _mm256_set1_epi32(-1)), _mm256_and_si256(hit, update));
+
+        storeLanes(adsrVolume, v, volume);
+        storeLanes(adsrWaitCycles, v, wait);
+        reached |= bitMask(hit) << v;
+    }
+#endif
+    for (; v < COUNT; v++) {
+        if ((active & (1u << v)) == 0) continue;
+
+        if (adsrWaitCycles[v] > 0) adsrWaitCycles[v]--;
+
+        int cycles = envelopeCycles[v];
+        int step = envelopeStep[v];
+        if (envelopeExponential[v]) {
+            if (!envelopeDecrease[v] && adsrVolume[v] > 0x6000) cycles *= 4;
+            if (envelopeDecrease[v]) {
+                // Note: Division by 0x8000 might cause value to become 0,
+                // using right shift by 15 ensures that minimum it can go is -1.
+                // Games affected: Doom (when paused music does not fade out)
+                // Little Princess - Marl Oukoku no Ningyou-hime 2 (voices stop playing after a while)
+                step = (step * adsrVolume[v]) >> 15;
+            }
+        }
+
+        if (adsrWaitCycles[v] != 0) continue;
+
+        adsrWaitCycles[v] = cycles;
+        adsrVolume[v] = std::clamp(adsrVolume[v] + step, 0, 0x7fff);
+
+        const int level = envelopeLevel[v];
+        if (level != -1 && (envelopeDecrease[v] ? adsrVolume[v] <= level : adsrVolume[v] >= level)) {
+            reached |= 1u << v;
+        }
+    }
+    return reached;
+}
+
+uint32_t VoiceLanes::mix(uint32_t voices, int16_t noiseLevel) {
+    uint32_t finished = 0;
+    int v = 0;
+#ifdef __AVX2__
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const int* taps = reinterpret_cast<const int*>(samples[0].data());
+    for (; v < COUNT; v += 8) {
+        if (((voices >> v) & 0xff) == 0) continue;
+
+        const __m256i mask = laneMask(voices >> v);
+        __m256i position = loadLanes(counter, v);
+        const __m256i index = _mm256_and_si256(_mm256_srli_epi32(position, 4), _mm256_set1_epi32(0xff));
+        const __m256i pos = _mm256_and_si256(_mm256_srli_epi32(position, 12), _mm256_set1_epi32(0x1f));
+
+        // Taps pos-3..pos of the current block are at pos..pos+3 of the window,
+        // 32 bit words are gathered and their lower halves used
+        const __m256i tap = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(lane, _mm256_set1_epi32(v)), _mm256_set1_epi32(WINDOW)), pos);
+        const __m256i weight[4] = {
+            _mm256_sub_epi32(_mm256_set1_epi32(0x0ff), index),
+            _mm256_sub_epi32(_mm256_set1_epi32(0x1ff), index),
+            _mm256_add_epi32(_mm256_set1_epi32(0x100), index),
+            index,
+        };
+        __m256i s = _mm256_setzero_si256();
+        for (int t = 0; t < 4; t++) {
+            __m256i x = truncate16(_mm256_i32gather_epi32(taps, _mm256_add_epi32(tap, _mm256_set1_epi32(t)), 2));
+            __m256i w = _mm256_i32gather_epi32(gauss.data(), weight[t], 4);
+            s = _mm256_add_epi32(s, _mm256_srai_epi32(_mm256_mullo_epi32(w, x), 15));
+        }
+        s = truncate16(s);
+        s = _mm256_blendv_epi8(s, _mm256_set1_epi32(noiseLevel), laneMask(noise >> v));
+        s = mul(s, truncate16(loadLanes(adsrVolume, v)));
+
+        int32_t* out = sample.data() + 1 + v;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_blendv_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(out)), s, mask));
+        storeLanes(left, v, mul(s, loadLanes(volumeLeft, v)));
+        storeLanes(right, v, mul(s, loadLanes(volumeRight, v)));
+
+        // Pitch Modulation uses output of the previous voice, including the one just stored
+        const __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sample.data() + v));
+        const __m256i rate = loadLanes(sampleRate, v);
+        __m256i modulated = _mm256_srli_epi32(_mm256_mullo_epi32(rate, _mm256_add_epi32(previous, _mm256_set1_epi32(0x8000))), 15);
+        modulated = _mm256_and_si256(modulated, _mm256_set1_epi32(0xffff));
+        __m256i step = _mm256_blendv_epi8(rate, modulated, laneMask(pitchModulation >> v));
+        step = _mm256_min_epi32(step, _mm256_set1_epi32(0x4000));
+
+        position = _mm256_add_epi32(position, _mm256_and_si256(step, mask));
+        const __m256i samplePos = _mm256_and_si256(_mm256_srli_epi32(position, 12), _mm256_set1_epi32(0x1f));
+        const __m256i end = _mm256_and_si256(mask, _mm256_cmpgt_epi32(samplePos, _mm256_set1_epi32(ADPCM::BLOCK_SAMPLES - 1)));
+        position = _mm256_sub_epi32(position, _mm256_and_si256(end, _mm256_set1_epi32(COUNTER_BLOCK)));
+        storeLanes(counter, v, position);
+
+        finished |= bitMask(end) << v;
+    }
+#endif
+    for (; v < COUNT; v++) {
+        if ((voices & (1u << v)) == 0) continue;
+
+        const int pos = counterSample(counter[v]);
+        const int i = counterIndex(counter[v]);
+        const int16_t* taps = samples[v].data() + pos;
+
+        int16_t s = 0;
+        s += (gauss[0x0ff - i] * taps[0]) >> 15;
+        s += (gauss[0x1ff - i] * taps[1]) >> 15;
+        s += (gauss[0x100 + i] * taps[2]) >> 15;
+        s += (gauss[0x000 + i] * taps[3]) >> 15;
+
+        if (noise & (1u << v)) s = noiseLevel;
+        s = mul(s, static_cast<int16_t>(adsrVolume[v]));
+
+        sample[1 + v] = s;
+        left[v] = mul(s, volumeLeft[v]);
+        right[v] = mul(s, volumeRight[v]);
+
+        uint32_t step = sampleRate[v];
+        if (pitchModulation & (1u << v)) {
+            int32_t factor = sample[v] + 0x8000;
+            step = (step * factor) >> 15;
+            step &= 0xffff;
+        }
+        if (step > 0x3fff) step = 0x4000;
+
+        counter[v] += step;
+        if (counterSample(counter[v]) >= ADPCM::BLOCK_SAMPLES) {
+            counter[v] -= COUNTER_BLOCK;
+            finished |= 1u << v;
+        }
+    }
+    return finished;
+}
+}  // namespace spu
@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "voice.h"
+
+namespace spu {
+/**
+ * Playback state of all voices stored as structure of arrays (one lane per voice), so that envelopes,
+ * interpolation, volume and pitch counters of active voices are processed 8 at a time (AVX2, scalar fallback).
+ * Lanes are the only copy of the state that changes every sample,
+ * register derived values are reloaded from Voice with load() when registers or voice state change.
+ */
+struct VoiceLanes {
+    static const int COUNT = 24;
+    static const int WINDOW = 32;   // Samples stored per voice
+    static const int HISTORY = 3;   // Last samples of the previous block (oldest interpolation taps)
+
+    using Lanes = std::array<int32_t, COUNT>;
+
+    // State
+    alignas(32) Lanes adsrVolume{};  // Envelope level, 16 bit register value
+    alignas(32) Lanes adsrWaitCycles{};
+    alignas(32) Lanes counter{};  // Pitch counter, bits 4..11 - interpolation index, bits 12..16 - sample in block
+
+    // HISTORY samples of the previous block (0 if there was none) followed by the current block
+    alignas(32) std::array<std::array<int16_t, WINDOW>, COUNT> samples{};
+
+    // Voice output after envelope (used for Pitch Modulation and capture), voice n is stored at index n + 1,
+    // index 0 is read as the previous voice of voice 0
+    alignas(32) std::array<int32_t, 1 + COUNT> sample{};
+
+    // Register derived (see load())
+    alignas(32) Lanes sampleRate{};
+    alignas(32) Lanes volumeLeft{};
+    alignas(32) Lanes volumeRight{};
+    alignas(32) Lanes envelopeCycles{};
+    alignas(32) Lanes envelopeStep{};
+    alignas(32) Lanes envelopeLevel{};  // -1 - phase never ends
+    alignas(32) Lanes envelopeExponential{};
+    alignas(32) Lanes envelopeDecrease{};
+    uint32_t active = 0;  // Voices which are not Off
+    uint32_t noise = 0;
+    uint32_t pitchModulation = 0;
+
+    // Output of mix(), summed by SPU in voice order (saturated sums depend on it)
+    alignas(32) Lanes left{};
+    alignas(32) Lanes right{};
+
+    void load(int v, Voice& voice);
+    void keyOn(int v);  // Resets playback state, Voice::keyOn() resets the rest
+    void clearHistory(int v);
+
+    // Returns active voices which reached the level of current envelope phase
+    uint32_t processEnvelopes();
+
+    // Interpolates, applies envelope and volume, steps pitch counters of given voices.
+    // Returns voices which finished playing current block.
+    uint32_t mix(uint32_t voices, int16_t noiseLevel);
+
+    int16_t voiceSample(int v) const { return static_cast<int16_t>(sample[v + 1]); }
+
+    template <class Archive>
+    void serialize(Archive& ar) {
+        ar(adsrVolume, adsrWaitCycles, counter);
+        ar(samples);
+        ar(sample);
+    }
+};
+}  // namespace spu
@@ -1,63 +1,93 @@
 #include "timer.h"
 #include <fmt/core.h>
+#include <algorithm>
 #include "system.h"
 
 namespace device::timer {
 
-Timer::Timer(System* sys, int which) : which(which), sys(sys) {}
+Timer::Timer(System* sys, int which) : which(which), sys(sys) { rate = getRate(); }
 
-void Timer::step(int cycles) {
-    if (paused) return;
-    cnt += cycles;
-
-    uint32_t tval = current._reg;
+Timer::Rate Timer::getRate() const {
     if (which == 0) {
         auto clock = static_cast<CounterMode::ClockSource0>(mode.clockSource & 1);
         using modes = CounterMode::ClockSource0;
 
-        if (clock == modes::dotClock) {
-            tval += cnt / 6;
-            cnt %= 6;
-        } else {  // System Clock
-            tval += (int)(cnt / 1.5f);
-            cnt %= (int)1.5f;
-        }
+        if (clock == modes::dotClock) return {1, 6};
+        return {2, 3};  // System Clock
     } else if (which == 1) {
         auto clock = static_cast<CounterMode::ClockSource1>(mode.clockSource & 1);
         using modes = CounterMode::ClockSource1;
 
-        if (clock == modes::hblank) {
-            tval += cnt / 3413;
-            cnt %= 3413;
-        } else {  // System Clock
-            tval += (int)(cnt / 1.5f);
-            cnt %= (int)1.5f;
-        }
-    } else if (which == 2) {
+        if (clock == modes::hblank) return {1, 3413};
+        return {2, 3};  // System Clock
+    } else {
         auto clock = static_cast<CounterMode::ClockSource2>((mode.clockSource >> 1) & 1);
         using modes = CounterMode::ClockSource2;
 
-        if (clock == modes::systemClock_8) {
-            tval += (int)(cnt / (8 * 1.5f));
-            cnt %= (int)(8 * 1.5f);
-        } else {  // System Clock
-            tval += (int)(cnt * 1.5f);
-            cnt %= (int)1.5f;
-        }
+        if (clock == modes::systemClock_8) return {1, 12};
+        return {3, 2};  // System Clock
     }
+}
 
-    bool possibleIrq = false;
+void Timer::step(uint64_t cycles) {
+    if (paused) return;
+
+    uint64_t acc = cnt + cycles * rate.ticks;
+    if (acc < rate.cycles) {
+        cnt = static_cast<uint32_t>(acc);
+        return;
+    }
+    uint64_t ticks = acc / rate.cycles;
+    cnt = static_cast<uint32_t>(acc % rate.cycles);
 
-    if (tval >= target._reg) {
+    bool possibleIrq = false;
+    auto reachTarget = [&]() {
         mode.reachedTarget = true;
-        if (mode.resetToZero == CounterMode::ResetToZero::whenTarget) tval = 0;
         if (mode.irqWhenTarget) possibleIrq = true;
+    };
+
+    uint32_t tval = current._reg;
+    if (target._reg == 0 && mode.resetToZero == CounterMode::ResetToZero::whenTarget) {
+        // Counter is reset on every tick - it stays at 0 and reaches the target constantly
+        tval = 0;
+        ticks = 0;
+        reachTarget();
     }
 
-    if (tval >= 0xffff) {
-        mode.reachedFFFF = true;
-        if (mode.resetToZero == CounterMode::ResetToZero::whenFFFF) tval = 0;
-        if (mode.irqWhenFFFF) possibleIrq = true;
+    while (ticks > 0) {
+        if (tval == 0xffff) {  // Overflow without reset
+            tval = 0;
+            ticks--;
+            if (target._reg == 0) reachTarget();
+            continue;
+        }
+
+        // Count up to nearest point of interest - target or 0xffff
+        uint32_t limit = (tval < target._reg) ? target._reg : 0xffff;
+        if (ticks < limit - tval) {
+            tval += static_cast<uint32_t>(ticks);
+            break;
+        }
+        ticks -= limit - tval;
+        tval = limit;
+
+        if (tval == target._reg) {
+            reachTarget();
+            if (mode.resetToZero == CounterMode::ResetToZero::whenTarget) {
+                tval = 0;
+                ticks %= target._reg;
+            }
+        }
+
+        if (tval == 0xffff) {
+            mode.reachedFFFF = true;
+            if (mode.irqWhenFFFF) possibleIrq = true;
+            if (mode.resetToZero == CounterMode::ResetToZero::whenFFFF) {
+                tval = 0;
+                ticks %= 0xffff;
+                if (target._reg == 0) reachTarget();
+            }
+        }
     }
 
     if (possibleIrq) checkIrq();
@@ -65,6 +95,42 @@ void Timer::step(int cycles) {
     current._reg = (uint16_t)tval;
 }
 
+void Timer::update() {
+    uint64_t now = sys->scheduler.now();
+    if (now == lastUpdate) return;
+
+    step(now - lastUpdate);
+    lastUpdate = now;
+}
+
+void Timer::scheduleNext() {
+    // Without irq enabled reaching target/0xffff can be computed on next access
+    if (paused || !(mode.irqWhenTarget || mode.irqWhenFFFF)) {
+        sys->scheduler.cancel(mapEvent());
+        return;
+    }
+
+    uint32_t tval = current._reg;
+    uint32_t ticks = 1;
+    if (target._reg == 0 && mode.resetToZero == CounterMode::ResetToZero::whenTarget) {
+        ticks = 1;  // Target is reached on every tick
+    } else if (tval < target._reg) {
+        ticks = target._reg - tval;
+    } else if (tval < 0xffff) {
+        ticks = 0xffff - tval;
+    }
+
+    int64_t remaining = std::max<int64_t>(0, (int64_t)ticks * rate.cycles - cnt);
+    uint64_t cycles = (remaining + rate.ticks - 1) / rate.ticks;
+    sys->scheduler.schedule(mapEvent(), lastUpdate + cycles);
+}
+
+void Timer::reschedule() {
+    rate = getRate();
+    lastUpdate = sys->scheduler.now();
+    scheduleNext();
+}
+
 void Timer::checkIrq() {
     if (mode.irqPulseMode == CounterMode::IrqPulseMode::toggle) {
         mode.interruptRequest = !mode.interruptRequest;
@@ -82,6 +148,7 @@ void Timer::checkIrq() {
 }
 
 uint8_t Timer::read(uint32_t address) {
+    if (address < 6) update();
     if (address < 2) {
         return current.read(address);
     }
@@ -100,11 +167,13 @@ uint8_t Timer::read(uint32_t address) {
 }
 
 void Timer::write(uint32_t address, uint8_t data) {
+    update();
     if (address < 2) {
         current.write(address, data);
     } else if (address >= 4 && address < 6) {
         current._reg = 0;
         mode.write(address - 4, data);  // BIOS uses 0x0148 for TIMER1
+        rate = getRate();
 
         paused = false;
         if (address == 5) {
@@ -137,6 +206,7 @@ void Timer::write(uint32_t address, uint8_t data) {
     } else if (address >= 8 && address < 10) {
         target.write(address - 8, data);
     }
+    scheduleNext();
 }
 
 };  // namespace device::timer
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <cassert>
 #include "interrupt.h"
+#include "scheduler.h"
 
 namespace gui::debug {
 class Timers;
@@ -85,6 +86,18 @@ class Timer {
 
     System* sys;
 
+    // Counter is updated lazily - on access and on scheduled target/overflow events
+    uint64_t lastUpdate = 0;
+
+    // Counter is incremented by "ticks" every "cycles" system cycles
+    struct Rate {
+        uint32_t ticks;
+        uint32_t cycles;
+    };
+    Rate rate;
+    Rate getRate() const;
+
+    void step(uint64_t cycles);
     void checkIrq();
     interrupt::IrqNumber mapIrqNumber() const {
         if (which == 0) return interrupt::TIMER0;
@@ -93,10 +106,19 @@ class Timer {
         assert(false);
         return interrupt::TIMER0;
     }
+    Scheduler::Event mapEvent() const {
+        if (which == 0) return Scheduler::Event::timer0;
+        if (which == 1) return Scheduler::Event::timer1;
+        if (which == 2) return Scheduler::Event::timer2;
+        assert(false);
+        return Scheduler::Event::timer0;
+    }
 
    public:
     Timer(System* sys, int which);
-    void step(int cycles);
+    void update();
+    void scheduleNext();
+    void reschedule();
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t data);
 
@@ -1,45 +1,38 @@
-#include <cassert>
 #include <cstdio>
+#include <cstdlib>
 #include <memory>
 #include <string>
-#include "mips.h"
+#include "config.h"
+#include "system.h"
+#include "system_tools.h"
 #include "utils/file.h"
 
 int main(int argc, char **argv) {
     if (argc < 2) {
-        printf("usage: Avocado psx.exe\n");
+        printf("usage: Avocado file [frames]\n");
         return 1;
     }
-    std::unique_ptr<mips::CPU> cpu = std::make_unique<mips::CPU>();
+    int frames = argc > 2 ? atoi(argv[2]) : 60 * 60;
 
-    if (!cpu->loadBios("SCPH1001.BIN")) {
+    if (config.bios.empty()) config.bios = "SCPH1001.BIN";
+    std::unique_ptr<System> sys = system_tools::hardReset();
+    if (!sys->isSystemReady()) {
+        printf("Cannot load bios %s\n", config.bios.c_str());
         return 1;
     }
 
-    // Breakpoint on BIOS Shell execution
-    cpu->addBreakpoint(0x80030000);
-
-    cpu->biosLog = false;
-    cpu->debugOutput = false;
-
-    // Emulate BIOS to GUI breakpoint
-    while (cpu->state == mips::CPU::State::run) {
-        cpu->emulateFrame();
-    }
-
-    if (!cpu->loadExeFile(argv[1])) {
-        printf("Cannot load %s\n", argv[1]);
-        return 1;
-    }
+    sys->state = System::State::run;
+    system_tools::loadFile(sys, argv[1]);
     printf("File %s loaded\n", getFilenameExt(argv[1]).c_str());
 
-    cpu->state = System::State::run;
-    cpu->debugOutput = false;
-    cpu->setPC(cpu->readMemory32(0x1f000000));
-
-    while (cpu->state == System::State::run) {
-        cpu->emulateFrame();
+    int frame = 0;
+    for (; frame < frames && sys->state == System::State::run; frame++) {
+        sys->emulateFrame();
     }
 
+    printf("Emulated %d frames, %llu instructions\n", frame, (unsigned long long)sys->cycles);
+    printf("Idle loops skipped: %llu instructions (%.1f%%)\n", (unsigned long long)sys->idleCycles,
+           sys->cycles != 0 ? 100.0 * sys->idleCycles / sys->cycles : 0.0);
+
     return 0;
 }
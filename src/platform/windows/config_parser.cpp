@@ -2,6 +2,7 @@
 #include <nlohmann/json.hpp>
 #include <fmt/core.h>
 #include "config.h"
+#include "cpu/cpu_mode.h"
 #include "device/controller/controller_type.h"
 #include "device/gpu/rendering_mode.h"
 #include "utils/file.h"
@@ -15,6 +16,7 @@ const char* CONFIG_NAME = "config.json";
 std::string configPath() { return avocado::PATH_USER + CONFIG_NAME; }
 
 JSON_ENUM(ControllerType);
+JSON_ENUM(CpuMode);
 JSON_ENUM(RenderingMode);
 
 void saveConfigFile() {
@@ -46,6 +48,8 @@ void saveConfigFile() {
         },
         {"vsync", g.vsync},
         {"forceNtsc", g.forceNtsc},
+        {"rendererThreads", g.rendererThreads},
+        {"asyncGpu", g.asyncGpu},
     };
 
     json["options"]["sound"] = {
@@ -59,6 +63,10 @@ void saveConfigFile() {
 
     json["options"]["system"] = {
         {"ram8mb", config.options.system.ram8mb},
+        {"cpuMode", config.options.system.cpuMode},
+        {"fastmem", config.options.system.fastmem},
+        {"biosHle", config.options.system.biosHle},
+        {"biosHleFunctions", config.options.system.biosHleFunctions},
     };
 
     auto l = config.debug.log;
@@ -120,6 +128,8 @@ void loadConfigFile() {
             config.options.graphics.resolution.height = g["resolution"]["height"];
             config.options.graphics.vsync = g["vsync"];
             config.options.graphics.forceNtsc = g["forceNtsc"];
+            if (auto t = g["rendererThreads"]; !t.is_null()) config.options.graphics.rendererThreads = t;
+            if (auto a = g["asyncGpu"]; !a.is_null()) config.options.graphics.asyncGpu = a;
         }
 
         if (auto s = json["options"]["sound"]; !s.is_null()) {
@@ -133,6 +143,12 @@ void loadConfigFile() {
 
         if (auto s = json["options"]["system"]; !s.is_null()) {
             config.options.system.ram8mb = s["ram8mb"];
+            if (auto m = s["cpuMode"]; !m.is_null()) config.options.system.cpuMode = m;
+            if (auto f = s["fastmem"]; !f.is_null()) config.options.system.fastmem = f;
+            if (auto h = s["biosHle"]; !h.is_null()) config.options.system.biosHle = h;
+            if (auto f = s["biosHleFunctions"]; !f.is_null()) {
+                config.options.system.biosHleFunctions = f.get<std::unordered_map<std::string, bool>>();
+            }
         }
 
         if (auto l = json["debug"]["log"]; !l.is_null()) {
@@ -0,0 +1,71 @@
+#include "bios.h"
+#include <fmt/core.h>
+#include <imgui.h>
+#include "config.h"
+#include "system.h"
+
+namespace gui::debug {
+void Bios::hleWindow(System* sys) {
+    ImGui::Begin("BIOS HLE", &hleWindowOpen, ImGuiWindowFlags_AlwaysAutoResize);
+
+    if (!config.options.system.biosHle) {
+        ImGui::TextUnformatted("BIOS HLE is disabled (Options -> System)");
+        ImGui::End();
+        return;
+    }
+
+    const char* tables[] = {"A", "B", "C"};
+    uint64_t totalHits = 0;
+    uint64_t totalInstructions = 0;
+
+    ImGui::Columns(4, "hle_functions", true);
+    ImGui::TextUnformatted("Enabled");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("Function");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("Hits");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("Instructions saved");
+    ImGui::NextColumn();
+    ImGui::Separator();
+
+    for (auto& f : sys->hle.functions) {
+        std::string name(f.name);
+        if (ImGui::Checkbox(fmt::format("##{}", name).c_str(), &f.enabled)) {
+            config.options.system.biosHleFunctions[name] = f.enabled;
+        }
+        ImGui::NextColumn();
+
+        ImGui::Text("%s(%02Xh) %s", tables[f.table], f.number, name.c_str());
+        ImGui::NextColumn();
+
+        ImGui::TextUnformatted(fmt::format("{}", f.hits).c_str());
+        ImGui::NextColumn();
+
+        ImGui::TextUnformatted(fmt::format("{}", f.instructions).c_str());
+        ImGui::NextColumn();
+
+        totalHits += f.hits;
+        totalInstructions += f.instructions;
+    }
+    ImGui::Separator();
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("Total");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted(fmt::format("{}", totalHits).c_str());
+    ImGui::NextColumn();
+    ImGui::TextUnformatted(fmt::format("{}", totalInstructions).c_str());
+    ImGui::NextColumn();
+    ImGui::Columns(1);
+
+    if (ImGui::Button("Reset counters")) {
+        sys->hle.resetCounters();
+    }
+
+    ImGui::End();
+}
+
+void Bios::displayWindows(System* sys) {
+    if (hleWindowOpen) hleWindow(sys);
+}
+}  // namespace gui::debug
@@ -0,0 +1,13 @@
+#pragma once
+
+struct System;
+
+namespace gui::debug {
+class Bios {
+    void hleWindow(System* sys);
+
+   public:
+    bool hleWindowOpen = false;
+    void displayWindows(System* sys);
+};
+}  // namespace gui::debug
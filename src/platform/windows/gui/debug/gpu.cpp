@@ -248,7 +248,7 @@ void colorBox(RGB color) {
 }
 };  // namespace
 
-void GPU::handlePolygonCommand(const gpu::PolygonArgs arg, const std::vector<uint32_t> &arguments) {
+void GPU::handlePolygonCommand(const gpu::PolygonArgs arg, const gpu::LogArgs &arguments) {
     int ptr = 1;
 
     primitive::Triangle::Vertex v[4];
@@ -312,7 +312,7 @@ void GPU::handlePolygonCommand(const gpu::PolygonArgs arg, const std::vector<uin
     }
 }
 
-void GPU::handleLineCommand(const gpu::LineArgs arg, const std::vector<uint32_t> &arguments) {
+void GPU::handleLineCommand(const gpu::LineArgs arg, const gpu::LogArgs &arguments) {
     int vertexCount;
     if (!arg.gouraudShading) {
         vertexCount = arguments.size() - 1;  // ignore arg[0] aka base color
@@ -342,7 +342,7 @@ void GPU::handleLineCommand(const gpu::LineArgs arg, const std::vector<uint32_t>
     }
 }
 
-void GPU::handleRectangleCommand(const gpu::RectangleArgs arg, const std::vector<uint32_t> &arguments) {
+void GPU::handleRectangleCommand(const gpu::RectangleArgs arg, const gpu::LogArgs &arguments) {
     int16_t w = arg.getSize();
     int16_t h = arg.getSize();
 
@@ -461,10 +461,11 @@ void GPU::logWindow(System *sys) {
     last_offset_y = sys->gpu->drawingOffsetY;
 
     int renderTo = -1;
-    ImGuiListClipper clipper((int)sys->gpu.get()->gpuLogList.size());
+    // Log is written by the GPU while capture is running
+    ImGuiListClipper clipper(GpuDrawList::isCapturing() ? 0 : (int)sys->gpu.get()->gpuLogList.size());
     while (clipper.Step()) {
         for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
-            auto &entry = sys->gpu.get()->gpuLogList[i];
+            auto entry = sys->gpu.get()->gpuLogList[i];
 
             bool nodeOpen = entryLine(i, entry, commandHasDetails(entry));
             bool isHovered = ImGui::IsItemHovered();
@@ -94,6 +94,7 @@ void channelsInfo(spu::SPU* spu, bool parseValues) {
     column("Flags");
     for (int i = 0; i < spu::SPU::VOICE_COUNT; i++) {
         auto& v = spu->voices[i];
+        const int32_t adsrVolume = spu->lanes.adsrVolume[i];
 
         if (v.state == Voice::State::Off) {
             ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.4f, 0.4f, 0.4f, 1.f));
@@ -146,12 +147,12 @@ void channelsInfo(spu::SPU* spu, bool parseValues) {
             bar(intToFloat(v.volume.getRight()));
             column(fmt::format("{:.0f}", intToFloat(v.volume.getRight()) * 100.f));
 
-            bar(intToFloat(v.adsrVolume._reg));
-            column(fmt::format("{:.0f}", (v.adsrVolume._reg / static_cast<float>(0x7fff)) * 100.f));
+            bar(intToFloat(adsrVolume));
+            column(fmt::format("{:.0f}", (adsrVolume / static_cast<float>(0x7fff)) * 100.f));
         } else {
             column(fmt::format("{:04x}", v.volume.left));
             column(fmt::format("{:04x}", v.volume.right));
-            column(fmt::format("{:04x}", v.adsrVolume._reg));
+            column(fmt::format("{:04x}", adsrVolume));
         }
 
         if (parseValues) {
@@ -202,6 +202,9 @@ void GUI::mainMenu(std::unique_ptr<System>& sys) {
         ImGui::MenuItem("SPU", nullptr, &spuDebug.spuWindowOpen);
         ImGui::MenuItem("VRAM", nullptr, &gpuDebug.vramWindowOpen);
         ImGui::MenuItem("Kernel", nullptr, &showKernelWindow);
+#ifdef ENABLE_BIOS_HOOKS
+        ImGui::MenuItem("BIOS HLE", nullptr, &biosDebug.hleWindowOpen);
+#endif
 
         ImGui::Separator();
         if (ImGui::MenuItem("Dump state")) {
@@ -265,6 +268,9 @@ void GUI::mainMenu(std::unique_ptr<System>& sys) {
     if (ImGui::IsItemHovered()) {
         ImGui::BeginTooltip();
         ImGui::TextUnformatted(fmt::format("Frame time: {:.2f} ms\nTab to disable frame limiting", (1000.0 / statusFps)).c_str());
+        if (sys->cycles != 0) {
+            ImGui::TextUnformatted(fmt::format("Idle loops skipped: {:.1f}% cycles", 100.0 * sys->idleCycles / sys->cycles).c_str());
+        }
         ImGui::EndTooltip();
     }
     ImGui::EndMainMenuBar();
@@ -284,6 +290,7 @@ void GUI::render(std::unique_ptr<System>& sys) {
         // Debug
         if (showKernelWindow) kernelWindow(sys.get());
 
+        biosDebug.displayWindows(sys.get());
         cdromDebug.displayWindows(sys.get());
         cpuDebug.displayWindows(sys.get());
         gpuDebug.displayWindows(sys.get());
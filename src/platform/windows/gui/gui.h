@@ -2,6 +2,7 @@
 #include <SDL.h>
 #include <optional>
 #include "file/open.h"
+#include "debug/bios.h"
 #include "debug/cdrom.h"
 #include "debug/cpu.h"
 #include "debug/gpu.h"
@@ -27,6 +28,7 @@ class GUI {
 
     gui::file::Open openFile;
 
+    gui::debug::Bios biosDebug;
     gui::debug::Cdrom cdromDebug;
     gui::debug::CPU cpuDebug;
     gui::debug::GPU gpuDebug;
@@ -2,6 +2,7 @@
 #include <fmt/core.h>
 #include <imgui.h>
 #include <magic_enum.hpp>
+#include <thread>
 #include <platform/windows/gui/gui.h>
 #include "config.h"
 #include "device/controller/controller_type.h"
@@ -91,6 +92,21 @@ void graphicsOptionsWindow() {
         bus.notify(Event::Config::Graphics{});
     }
 
+    if (config.options.graphics.renderingMode & RenderingMode::software) {
+        ImGui::Text("Renderer threads");
+        ImGui::SameLine();
+        ImGui::PushItemWidth(100);
+        int threads = config.options.graphics.rendererThreads;
+        if (ImGui::SliderInt("##renderer_threads", &threads, 0, std::thread::hardware_concurrency())) {
+            config.options.graphics.rendererThreads = threads;
+            bus.notify(Event::Config::Graphics{});
+        }
+        ImGui::PopItemWidth();
+        tooltip(
+            "Number of threads used by the software renderer.\n"
+            "0 draws everything on the emulation thread.");
+    }
+
     if (selectedRenderingMode != 0) {
         ImGui::Text("Internal resolution");
         ImGui::SameLine();
@@ -130,6 +146,15 @@ void graphicsOptionsWindow() {
         bus.notify(Event::Config::Gte{});
     }
 
+    bool asyncGpu = config.options.graphics.asyncGpu;
+    if (ImGui::Checkbox("Asynchronous GPU", &asyncGpu)) {
+        config.options.graphics.asyncGpu = asyncGpu;
+        bus.notify(Event::Config::Graphics{});
+    }
+    tooltip(
+        "Decode and draw GPU commands on a separate thread, in parallel with CPU emulation.\n"
+        "GPU interrupt (GP0 1Fh) is delayed until the next scanline.");
+
     bool vsync = config.options.graphics.vsync;
     if (ImGui::Checkbox("VSync", &vsync)) {
         config.options.graphics.vsync = vsync;
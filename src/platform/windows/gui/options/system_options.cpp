@@ -12,6 +12,23 @@ void System::displayWindows() {
         bus.notify(Event::System::HardReset{});
     }
 
+    const char* cpuModes[] = {"Interpreter", "Cached interpreter", "Recompiler"};
+    int cpuMode = static_cast<int>(config.options.system.cpuMode);
+    if (ImGui::Combo("CPU", &cpuMode, cpuModes, IM_ARRAYSIZE(cpuModes))) {
+        config.options.system.cpuMode = static_cast<CpuMode>(cpuMode);
+        bus.notify(Event::System::HardReset{});
+    }
+
+    if (ImGui::Checkbox("Fastmem", &config.options.system.fastmem)) {
+        bus.notify(Event::System::HardReset{});
+    }
+
+#ifdef ENABLE_BIOS_HOOKS
+    if (ImGui::Checkbox("BIOS HLE", &config.options.system.biosHle)) {
+        bus.notify(Event::System::HardReset{});
+    }
+#endif
+
     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.8f, 0.8f, 0.8f, 1.f));
     ImGui::Text(
         "Warning: Changing any of these settings\n"
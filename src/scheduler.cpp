@@ -0,0 +1,75 @@
+#include "scheduler.h"
+#include <algorithm>
+#include <functional>
+
+void Scheduler::schedule(Event event, uint64_t time) {
+    int e = static_cast<int>(event);
+    pending[e] = true;
+    heap.push_back({time, ++generation[e], event});
+    std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+
+    if (time < runEnd) {
+        runEnd = time;
+        yieldCpu = true;
+    }
+
+    // Frequently rescheduled events leave stale entries behind
+    if (heap.size() > EVENT_COUNT * 8) {
+        heap.erase(std::remove_if(heap.begin(), heap.end(),
+                                  [&](const Entry& entry) {
+                                      int i = static_cast<int>(entry.event);
+                                      return !pending[i] || entry.generation != generation[i];
+                                  }),
+                   heap.end());
+        std::make_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    }
+}
+
+void Scheduler::cancel(Event event) {
+    int e = static_cast<int>(event);
+    pending[e] = false;
+    generation[e]++;
+}
+
+void Scheduler::clear() {
+    heap.clear();
+    pending.fill(false);
+    for (auto& g : generation) g++;
+}
+
+void Scheduler::dropStale() {
+    while (!heap.empty()) {
+        const Entry& top = heap.front();
+        int e = static_cast<int>(top.event);
+        if (pending[e] && top.generation == generation[e]) return;
+
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        heap.pop_back();
+    }
+}
+
+uint64_t Scheduler::nextEventTime() {
+    dropStale();
+    if (heap.empty()) return NEVER;
+    return heap.front().time;
+}
+
+bool Scheduler::popDue(Event& event) {
+    if (nextEventTime() > now()) return false;
+
+    event = heap.front().event;
+    pending[static_cast<int>(event)] = false;
+    std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    heap.pop_back();
+    return true;
+}
+
+void Scheduler::beginRun(uint64_t end) {
+    runEnd = end;
+    yieldCpu = false;
+}
+
+void Scheduler::endRun() {
+    runEnd = 0;
+    yieldCpu = false;
+}
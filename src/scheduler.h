@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Scheduler - min-heap of timestamped device events.
+ *
+ * Time is counted in system cycles (unit used for GPU line timing),
+ * CPU executes one instruction every CYCLES_PER_INSTRUCTION cycles.
+ * Each event has at most one pending occurrence - scheduling it again replaces the previous one.
+ */
+class Scheduler {
+   public:
+    enum class Event : uint8_t { gpuLine, dma, cdrom, spu, controller, timer0, timer1, timer2, COUNT };
+
+    static const int CYCLES_PER_INSTRUCTION = 3;
+    static constexpr uint64_t NEVER = UINT64_MAX;
+
+   private:
+    struct Entry {
+        uint64_t time;
+        uint32_t generation;
+        Event event;
+
+        bool operator>(const Entry& other) const { return time > other.time; }
+    };
+
+    static const int EVENT_COUNT = static_cast<int>(Event::COUNT);
+
+    const uint64_t& instructions;
+    std::vector<Entry> heap;
+    // Entries with outdated generation were rescheduled or cancelled and are dropped when they reach the top
+    std::array<uint32_t, EVENT_COUNT> generation = {};
+    std::array<bool, EVENT_COUNT> pending = {};
+
+    uint64_t runEnd = 0;
+
+    void dropStale();
+
+   public:
+    // Set when an event earlier than end of current CPU run was scheduled, CPU should return as soon as possible
+    bool yieldCpu = false;
+
+    Scheduler(const uint64_t& instructions) : instructions(instructions) {}
+
+    uint64_t now() const { return instructions * CYCLES_PER_INSTRUCTION; }
+
+    void schedule(Event event, uint64_t time);
+    void scheduleIn(Event event, uint64_t cycles) { schedule(event, now() + cycles); }
+    void cancel(Event event);
+    bool isPending(Event event) const { return pending[static_cast<int>(event)]; }
+    void clear();
+
+    // Time of the earliest pending event (NEVER if there is none)
+    uint64_t nextEventTime();
+    // Removes earliest event if its time has come
+    bool popDue(Event& event);
+
+    void beginRun(uint64_t end);
+    void endRun();
+};
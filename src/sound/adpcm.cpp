@@ -13,10 +13,7 @@ int16_t clamp_16bit(int32_t sample) {
     return (int16_t)sample;
 }
 
-std::vector<int16_t> decode(uint8_t buffer[16], int32_t prevSample[2]) {
-    std::vector<int16_t> decoded;
-    decoded.reserve(28);
-
+void decode(const uint8_t buffer[16], int32_t prevSample[2], int16_t decoded[BLOCK_SAMPLES]) {
     // Read ADPCM header
     auto shift = buffer[0] & 0x0f;
     auto filter = (buffer[0] & 0x70) >> 4;  // 0x40 for xa adpcm
@@ -27,7 +24,7 @@ std::vector<int16_t> decode(uint8_t buffer[16], int32_t prevSample[2]) {
     auto filterPos = filterTablePos[filter];
     auto filterNeg = filterTableNeg[filter];
 
-    for (auto n = 0; n < 28; n++) {
+    for (auto n = 0; n < BLOCK_SAMPLES; n++) {
         // Read currently decoded nibble
         int16_t nibble = buffer[2 + n / 2];
         if (n % 2 == 0) {
@@ -46,14 +43,12 @@ std::vector<int16_t> decode(uint8_t buffer[16], int32_t prevSample[2]) {
         sample += (prevSample[0] * filterPos + prevSample[1] * filterNeg + 32) / 64;
 
         // clamp to -0x8000 +0x7fff
-        decoded.push_back(clamp_16bit(sample));
+        decoded[n] = clamp_16bit(sample);
 
         // Move previous samples forward
         prevSample[1] = prevSample[0];
         prevSample[0] = sample;
     }
-
-    return decoded;
 }
 
 // Separate buffers and counters for left and right channels
@@ -17,6 +17,8 @@ enum Flag {
                          // 1 - Load currentAddress to repeatAddress
                          // 0 - Nothing
 };
-std::vector<int16_t> decode(uint8_t buffer[16], int32_t prevSample[2]);
+const int BLOCK_SAMPLES = 28;
+
+void decode(const uint8_t buffer[16], int32_t prevSample[2], int16_t decoded[BLOCK_SAMPLES]);
 std::vector<std::pair<int16_t, int16_t>> decodeXA(uint8_t buffer[128 * 18], cd::Codinginfo codinginfo);
 };  // namespace ADPCM
\ No newline at end of file
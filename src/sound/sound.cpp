@@ -0,0 +1,62 @@
+#include "sound.h"
+#include <algorithm>
+#include <atomic>
+
+namespace Sound {
+SpscQueue<Frame, BUFFER_SIZE> buffer;
+
+namespace {
+const size_t TARGET_FILL = 2048;     // Frames queued during steady playback (~46ms)
+const double MAX_ADJUSTMENT = 0.005;  // Maximum change of playback rate
+
+std::atomic<bool> clearRequested = false;
+
+// Consumer state
+bool buffering = true;  // Waiting for the ring to fill up to TARGET_FILL, after start or underrun
+double position = 0.0;  // Fraction between buffer.peek(0) and buffer.peek(1)
+
+int16_t lerp(int16_t a, int16_t b, double t) { return static_cast<int16_t>(a + (b - a) * t); }
+};  // namespace
+
+void clearBuffer() { clearRequested.store(true, std::memory_order_release); }
+
+void readBuffer(Frame* output, size_t count) {
+    if (clearRequested.exchange(false, std::memory_order_acquire)) {
+        buffer.pop(buffer.size());
+        buffering = true;
+        position = 0.0;
+    }
+
+    size_t fill = buffer.size();
+    if (buffering && fill < TARGET_FILL) {
+        std::fill_n(output, count, Frame{0, 0});
+        return;
+    }
+    buffering = false;
+
+    // Fuller ring is played faster, emptier one slower (full adjustment at half of the target away from it)
+    double deviation = std::clamp((static_cast<double>(fill) - TARGET_FILL) / (TARGET_FILL / 2), -1.0, 1.0);
+    double step = 1.0 + deviation * MAX_ADJUSTMENT;
+
+    size_t i = 0;
+    for (; i < count; i++) {
+        if (fill < 2) {
+            buffering = true;
+            break;
+        }
+
+        const Frame& a = buffer.peek(0);
+        const Frame& b = buffer.peek(1);
+        output[i].left = lerp(a.left, b.left, position);
+        output[i].right = lerp(a.right, b.right, position);
+
+        position += step;
+        size_t consumed = static_cast<size_t>(position);
+        consumed = std::min(consumed, fill - 1);
+        buffer.pop(consumed);
+        fill -= consumed;
+        position -= consumed;
+    }
+    std::fill_n(output + i, count - i, Frame{0, 0});
+}
+};  // namespace Sound
@@ -1,26 +1,44 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
-#include <deque>
-#include <iterator>
-#include <mutex>
+#include "utils/spsc_queue.h"
 
 namespace Sound {
-extern std::deque<uint16_t> buffer;
-extern std::mutex audioMutex;
+struct Frame {
+    int16_t left;
+    int16_t right;
+};
+
+/**
+ * Audio frames produced by the emulation thread (SPU) and consumed by the audio callback.
+ * Consumer resamples them by up to +-0.5% depending on the fill level, which keeps latency steady
+ * when emulation runs slightly faster or slower than the audio device.
+ */
+const size_t BUFFER_SIZE = 8192;  // Frames (~186ms)
+extern SpscQueue<Frame, BUFFER_SIZE> buffer;
 
 void init();
 void play();
 void stop();
 void close();
+
+// Requests consumer to drop queued frames (producer side)
 void clearBuffer();
 
+// Producer, interleaved L/R samples. Frames which don't fit are dropped
 template <typename Iterator>
-void appendBuffer(const Iterator& start, const Iterator& end) {
-    std::unique_lock<std::mutex> lock(audioMutex);
-
-    if (buffer.size() > 512 * 32) {
-        buffer.clear();
+void appendBuffer(Iterator start, Iterator end) {
+    Frame frames[64];
+    while (start != end) {
+        size_t count = 0;
+        for (; start != end && count < 64; count++) {
+            frames[count].left = *start++;
+            frames[count].right = *start++;
+        }
+        buffer.push(frames, count);
     }
-    buffer.insert(buffer.end(), start, end);
 }
+
+// Consumer, fills output with resampled frames (silence when not enough frames are queued)
+void readBuffer(Frame* output, size_t count);
 };  // namespace Sound
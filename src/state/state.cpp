@@ -20,7 +20,7 @@ namespace state {
 const char* lastSaveName = "last.state";
 
 struct StateMetadata {
-    inline static const uint32_t SAVESTATE_VERSION = 8;
+    inline static const uint32_t SAVESTATE_VERSION = 9;
 
     uint32_t version = SAVESTATE_VERSION;
     std::string biosPath;
@@ -77,6 +77,10 @@ struct StateMetadata {
 };
 
 SaveState save(System* sys) {
+    // Bring lazily updated devices up to date
+    sys->cdrom->update();
+    for (auto& t : sys->timer) t->update();
+
     std::ostringstream oos;
     cereal::BinaryOutputArchive archive(oos);
 
@@ -99,6 +103,10 @@ bool load(System* sys, const SaveState& state) {
         sys->state = System::State::halted;
         return false;
     }
+    sys->mapMemory();
+    sys->cpu->invalidateAllCode();
+    sys->cpu->attention = true;
+    sys->scheduleEvents();
     return true;
 }
 
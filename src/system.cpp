@@ -1,5 +1,7 @@
 #include "system.h"
 #include <fmt/core.h>
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include "bios/functions.h"
@@ -11,10 +13,17 @@
 #include "utils/psx_exe.h"
 
 System::System() {
-    bios.fill(0);
-    ram.resize(!config.options.system.ram8mb ? RAM_SIZE_2MB : RAM_SIZE_8MB, 0);
+    if (config.options.system.fastmem) {
+        fastmemArena = fastmem::Arena::create();
+    }
+
+    // Guest memory has to be a shared memory object only to be mapped in the fastmem arena
+    fastmem::SharedAllocator<uint8_t> allocator(fastmemArena != nullptr);
+    bios = decltype(bios)(BIOS_SIZE, 0, allocator);
+    ram = decltype(ram)(!config.options.system.ram8mb ? RAM_SIZE_2MB : RAM_SIZE_8MB, 0, allocator);
     scratchpad.fill(0);
     expansion.fill(0);
+    mapMemory();
 
     cpu = std::make_unique<mips::CPU>(this);
     gpu = std::make_unique<gpu::GPU>(this);
@@ -36,8 +45,13 @@ System::System() {
 
     debugOutput = config.debug.log.system;
     biosLog = config.debug.log.bios;
+    hle.setEnabled(config.options.system.biosHle);
+    if (config.options.system.biosHle) {
+        for (auto& [name, enabled] : config.options.system.biosHleFunctions) hle.setEnabled(name, enabled);
+    }
 
     cycles = 0;
+    scheduleEvents();
 }
 
 // Note: stupid static_casts and asserts are only to suppress MSVC warnings
@@ -100,19 +114,19 @@ constexpr void write_io(Device& periph, uint32_t addr, T data) {
 #define LOG_IO(mode, size, addr, data, pc)
 #endif
 
-#define READ_IO(begin, end, periph)                                              \
-    if (addr >= (begin) && addr < (end)) {                                       \
-        auto data = read_io<T>((periph), addr - (begin));                        \
+#define READ_IO(periph)                                                          \
+    {                                                                            \
+        auto data = read_io<T>((periph), offset);                                \
                                                                                  \
         LOG_IO(IO_LOG_ENTRY::MODE::READ, sizeof(T) * 8, address, data, cpu->PC); \
         return data;                                                             \
     }
 
-#define READ_IO32(begin, end, periph)                                                                                    \
-    if (addr >= (begin) && addr < (end)) {                                                                               \
+#define READ_IO32(periph)                                                                                                \
+    {                                                                                                                    \
         T data = 0;                                                                                                      \
         if (sizeof(T) == 4) {                                                                                            \
-            data = (periph)->read(addr - (begin));                                                                       \
+            data = (periph)->read(offset);                                                                               \
         } else {                                                                                                         \
             fmt::print("[SYS] R Unsupported access to " #periph " with bit size {}\n", static_cast<int>(sizeof(T) * 8)); \
         }                                                                                                                \
@@ -121,18 +135,18 @@ constexpr void write_io(Device& periph, uint32_t addr, T data) {
         return data;                                                                                                     \
     }
 
-#define WRITE_IO(begin, end, periph)                                              \
-    if (addr >= (begin) && addr < (end)) {                                        \
-        write_io<T>((periph), addr - (begin), data);                              \
+#define WRITE_IO(periph)                                                          \
+    {                                                                             \
+        write_io<T>((periph), offset, data);                                      \
                                                                                   \
         LOG_IO(IO_LOG_ENTRY::MODE::WRITE, sizeof(T) * 8, address, data, cpu->PC); \
         return;                                                                   \
     }
 
-#define WRITE_IO32(begin, end, periph)                                                                                   \
-    if (addr >= (begin) && addr < (end)) {                                                                               \
+#define WRITE_IO32(periph)                                                                                               \
+    {                                                                                                                    \
         if (sizeof(T) == 4) {                                                                                            \
-            (periph)->write(addr - (begin), data);                                                                       \
+            (periph)->write(offset, data);                                                                               \
         } else {                                                                                                         \
             fmt::print("[SYS] W Unsupported access to " #periph " with bit size {}\n", static_cast<int>(sizeof(T) * 8)); \
         }                                                                                                                \
@@ -141,39 +155,106 @@ constexpr void write_io(Device& periph, uint32_t addr, T data) {
         return;                                                                                                          \
     }
 
+struct IoRange {
+    uint32_t begin;
+    uint32_t end;
+};
+
+// Indexed by System::IoDevice
+constexpr IoRange ioRanges[] = {
+    {0, 0},                    // none
+    {0x1f801000, 0x1f801024},  // memoryControl
+    {0x1f801040, 0x1f801050},  // controller
+    {0x1f801050, 0x1f801060},  // serial
+    {0x1f801060, 0x1f801064},  // ramControl
+    {0x1f801070, 0x1f801078},  // interrupt
+    {0x1f801080, 0x1f801100},  // dma
+    {0x1f801100, 0x1f801110},  // timer0
+    {0x1f801110, 0x1f801120},  // timer1
+    {0x1f801120, 0x1f801130},  // timer2
+    {0x1f801800, 0x1f801804},  // cdrom
+    {0x1f801810, 0x1f801818},  // gpu
+    {0x1f801820, 0x1f801828},  // mdec
+    {0x1f801C00, 0x1f802000},  // spu
+    {0x1f802000, 0x1f804000},  // expansion2
+};
+
+void System::mapMemory() {
+    readPages.assign(PAGE_COUNT, nullptr);
+    writePages.assign(PAGE_COUNT, nullptr);
+
+    auto map = [&](uint32_t base, uint32_t size, uint8_t* memory, uint32_t memorySize, bool writable) {
+        for (uint32_t offset = 0; offset < size; offset += PAGE_MASK + 1) {
+            uint8_t* page = memory + (offset & (memorySize - 1));
+            readPages[(base + offset) >> PAGE_SHIFT] = page;
+            if (writable) writePages[(base + offset) >> PAGE_SHIFT] = page;
+        }
+    };
+    map(RAM_BASE, RAM_SIZE_8MB, ram.data(), static_cast<uint32_t>(ram.size()), true);  // 2MB RAM is mirrored in 8MB region
+    map(EXPANSION_BASE, EXPANSION_SIZE, expansion.data(), EXPANSION_SIZE, true);
+    map(BIOS_BASE, BIOS_SIZE, bios.data(), BIOS_SIZE, false);
+
+    ioDevices.fill(IoDevice::none);
+    for (size_t device = 1; device < std::size(ioRanges); device++) {
+        for (uint32_t addr = ioRanges[device].begin; addr < ioRanges[device].end; addr += 4) {
+            ioDevices[(addr - IO_DEVICES_BASE) / 4] = static_cast<IoDevice>(device);
+        }
+    }
+
+    if (fastmemArena) {
+        fastmemArena->unmapAll();
+
+        bool ok = true;
+        for (uint32_t segment : {0x0000'0000u, 0x8000'0000u, 0xa000'0000u}) {
+            for (uint32_t offset = 0; offset < RAM_SIZE_8MB; offset += static_cast<uint32_t>(ram.size())) {
+                ok &= fastmemArena->map(segment + RAM_BASE + offset, ram.data(), ram.size(), true);
+            }
+            // Scratchpad is not mapped, 1KB of it doesn't fill a host page and accesses past it
+            // have to reach System::readMemory/writeMemory (they fault and are patched to the slow path)
+            ok &= fastmemArena->map(segment + BIOS_BASE, bios.data(), BIOS_SIZE, false);
+        }
+
+        if (!ok) {
+            fmt::print("[FASTMEM] Unable to map guest memory, fastmem disabled\n");
+            fastmemArena.reset();
+        }
+    }
+}
+
 template <typename T>
 INLINE T System::readMemory(uint32_t address) {
     static_assert(std::is_same<T, uint8_t>() || std::is_same<T, uint16_t>() || std::is_same<T, uint32_t>(), "Invalid type used");
 
     uint32_t addr = align_mips<T>(address);
 
-    if (in_range<RAM_BASE, RAM_SIZE_8MB>(addr)) {
-        return read_fast<T>(ram.data(), (addr - RAM_BASE) & (ram.size() - 1));
-    }
-    if (in_range<EXPANSION_BASE, EXPANSION_SIZE>(addr)) {
-        return read_fast<T>(expansion.data(), addr - EXPANSION_BASE);
+    if (uint8_t* page = readPages[addr >> PAGE_SHIFT]; likely(page != nullptr)) {
+        return read_fast<T>(page, addr & PAGE_MASK);
     }
     if (in_range<SCRATCHPAD_BASE, SCRATCHPAD_SIZE>(addr)) {
         return read_fast<T>(scratchpad.data(), addr - SCRATCHPAD_BASE);
     }
-    if (in_range<BIOS_BASE, BIOS_SIZE>(addr)) {
-        return read_fast<T>(bios.data(), addr - BIOS_BASE);
-    }
-
-    READ_IO(0x1f801000, 0x1f801024, memoryControl);
-    READ_IO(0x1f801040, 0x1f801050, controller);
-    READ_IO(0x1f801050, 0x1f801060, serial);
-    READ_IO(0x1f801060, 0x1f801064, ramControl);
-    READ_IO(0x1f801070, 0x1f801078, interrupt);
-    READ_IO(0x1f801080, 0x1f801100, dma);
-    READ_IO(0x1f801100, 0x1f801110, timer[0]);
-    READ_IO(0x1f801110, 0x1f801120, timer[1]);
-    READ_IO(0x1f801120, 0x1f801130, timer[2]);
-    READ_IO(0x1f801800, 0x1f801804, cdrom);
-    READ_IO32(0x1f801810, 0x1f801818, gpu);
-    READ_IO32(0x1f801820, 0x1f801828, mdec);
-    READ_IO(0x1f801C00, 0x1f802000, spu);
-    READ_IO(0x1f802000, 0x1f804000, expansion2);
+
+    if (in_range<IO_DEVICES_BASE, IO_DEVICES_SIZE>(addr)) {
+        auto device = ioDevices[(addr - IO_DEVICES_BASE) / 4];
+        uint32_t offset = addr - ioRanges[static_cast<int>(device)].begin;
+        switch (device) {
+            case IoDevice::memoryControl: READ_IO(memoryControl);
+            case IoDevice::controller: READ_IO(controller);
+            case IoDevice::serial: READ_IO(serial);
+            case IoDevice::ramControl: READ_IO(ramControl);
+            case IoDevice::interrupt: READ_IO(interrupt);
+            case IoDevice::dma: READ_IO(dma);
+            case IoDevice::timer0: READ_IO(timer[0]);
+            case IoDevice::timer1: READ_IO(timer[1]);
+            case IoDevice::timer2: READ_IO(timer[2]);
+            case IoDevice::cdrom: READ_IO(cdrom);
+            case IoDevice::gpu: READ_IO32(gpu);
+            case IoDevice::mdec: READ_IO32(mdec);
+            case IoDevice::spu: READ_IO(spu);
+            case IoDevice::expansion2: READ_IO(expansion2);
+            case IoDevice::none: break;
+        }
+    }
 
     if (in_range<0xfffe0130, 4>(address) && sizeof(T) == 4) {
         auto data = cacheControl->read(0);
@@ -199,30 +280,37 @@ INLINE void System::writeMemory(uint32_t address, T data) {
 
     uint32_t addr = align_mips<T>(address);
 
-    if (in_range<RAM_BASE, RAM_SIZE_8MB>(addr)) {
-        return write_fast<T>(ram.data(), (addr - RAM_BASE) & (ram.size() - 1), data);
-    }
-    if (in_range<EXPANSION_BASE, EXPANSION_SIZE>(addr)) {
-        return write_fast<T>(expansion.data(), addr - EXPANSION_BASE, data);
+    if (uint8_t* page = writePages[addr >> PAGE_SHIFT]; likely(page != nullptr)) {
+        if (in_range<RAM_BASE, RAM_SIZE_8MB>(addr)) {
+            cpu->invalidateCode((addr - RAM_BASE) & (ram.size() - 1));
+        }
+        return write_fast<T>(page, addr & PAGE_MASK, data);
     }
     if (in_range<SCRATCHPAD_BASE, SCRATCHPAD_SIZE>(addr)) {
         return write_fast<T>(scratchpad.data(), addr - SCRATCHPAD_BASE, data);
     }
 
-    WRITE_IO(0x1f801000, 0x1f801024, memoryControl);
-    WRITE_IO(0x1f801040, 0x1f801050, controller);
-    WRITE_IO(0x1f801050, 0x1f801060, serial);
-    WRITE_IO(0x1f801060, 0x1f801064, ramControl);
-    WRITE_IO(0x1f801070, 0x1f801078, interrupt);
-    WRITE_IO(0x1f801080, 0x1f801100, dma);
-    WRITE_IO(0x1f801100, 0x1f801110, timer[0]);
-    WRITE_IO(0x1f801110, 0x1f801120, timer[1]);
-    WRITE_IO(0x1f801120, 0x1f801130, timer[2]);
-    WRITE_IO(0x1f801800, 0x1f801804, cdrom);
-    WRITE_IO32(0x1f801810, 0x1f801818, gpu);
-    WRITE_IO32(0x1f801820, 0x1f801828, mdec);
-    WRITE_IO(0x1f801C00, 0x1f802000, spu);
-    WRITE_IO(0x1f802000, 0x1f804000, expansion2);
+    if (in_range<IO_DEVICES_BASE, IO_DEVICES_SIZE>(addr)) {
+        auto device = ioDevices[(addr - IO_DEVICES_BASE) / 4];
+        uint32_t offset = addr - ioRanges[static_cast<int>(device)].begin;
+        switch (device) {
+            case IoDevice::memoryControl: WRITE_IO(memoryControl);
+            case IoDevice::controller: WRITE_IO(controller);
+            case IoDevice::serial: WRITE_IO(serial);
+            case IoDevice::ramControl: WRITE_IO(ramControl);
+            case IoDevice::interrupt: WRITE_IO(interrupt);
+            case IoDevice::dma: WRITE_IO(dma);
+            case IoDevice::timer0: WRITE_IO(timer[0]);
+            case IoDevice::timer1: WRITE_IO(timer[1]);
+            case IoDevice::timer2: WRITE_IO(timer[2]);
+            case IoDevice::cdrom: WRITE_IO(cdrom);
+            case IoDevice::gpu: WRITE_IO32(gpu);
+            case IoDevice::mdec: WRITE_IO32(mdec);
+            case IoDevice::spu: WRITE_IO(spu);
+            case IoDevice::expansion2: WRITE_IO(expansion2);
+            case IoDevice::none: break;
+        }
+    }
 
     if (in_range<0xfffe0130, 4>(address) && sizeof(T) == 4) {
         cacheControl->write(0, data);
@@ -284,20 +372,20 @@ void System::printFunctionInfo(const char* functionNum, const bios::Function& f)
     fmt::print(")\n");
 }
 
-void System::handleBiosFunction() {
+int System::handleBiosFunction() {
     uint32_t maskedPC = cpu->PC & 0x1FFFFF;
     uint8_t functionNumber = cpu->reg[9];
     bool log = biosLog;
 
     int tableNum = (maskedPC - 0xA0) / 0x10;
-    if (tableNum > 2) return;
+    if (tableNum > 2) return 0;
 
     const auto& table = bios::tables[tableNum];
     const auto& function = table.find(functionNumber);
 
     if (function == table.end()) {
         fmt::print("  BIOS {:1X}(0x{:02X}): Unknown function!\n", 0xA + tableNum, functionNumber);
-        return;
+        return 0;
     }
     if (function->second.callback != nullptr) {
         log = function->second.callback(this);
@@ -307,6 +395,8 @@ void System::handleBiosFunction() {
         std::string type = fmt::format("BIOS {:1X}({:02X})", 0xA + tableNum, functionNumber);
         printFunctionInfo(type.c_str(), function->second);
     }
+
+    return hle.call(this, tableNum, functionNumber);
 }
 
 void System::handleSyscallFunction() {
@@ -331,17 +421,102 @@ void System::singleStep() {
     cpu->executeInstructions(1);
     state = State::pause;
 
-    dma->step();
-    cdrom->step(3);
-    timer[0]->step(3);
-    timer[1]->step(3);
-    timer[2]->step(3);
-    controller->step();
-    spu->step(cdrom.get());
+    handleEvents();
+}
+
+bool System::handleEvent(Scheduler::Event event) {
+    using Event = Scheduler::Event;
+    switch (event) {
+        case Event::gpuLine: {
+            uint64_t now = scheduler.now();
+            bool vblank = gpu->emulateGpuCycles(static_cast<int>(now - gpuLastUpdate));
+            gpuLastUpdate = now;
+            scheduler.schedule(Event::gpuLine, now + 3413 - gpu->gpuDot);
+
+            if (vblank) {
+                interrupt->trigger(interrupt::VBLANK);
+                return true;  // frame emulated
+            }
+
+            // TODO: Move this code to Timer class
+            if (gpu->gpuLine > gpu->linesPerFrame() - 20) {
+                auto& t = *timer[1];
+                if (t.mode.syncEnabled) {
+                    using modes = device::timer::CounterMode::SyncMode1;
+                    auto mode1 = static_cast<modes>(t.mode.syncMode);
+                    t.update();
+                    if (mode1 == modes::resetAtVblank || mode1 == modes::resetAtVblankAndPauseOutside) {
+                        t.current._reg = 0;
+                    } else if (mode1 == modes::pauseUntilVblankAndFreerun) {
+                        t.paused = false;
+                        t.mode.syncEnabled = false;
+                    }
+                    t.scheduleNext();
+                }
+            }
+            // Handle Timer1 - Reset on VBlank
+            break;
+        }
+
+        case Event::dma: dma->step(); break;
+        case Event::cdrom: cdrom->handleEvent(); break;
+        case Event::controller: controller->step(); break;
+        case Event::timer0:
+        case Event::timer1:
+        case Event::timer2: {
+            auto& t = timer[static_cast<int>(event) - static_cast<int>(Event::timer0)];
+            t->update();
+            t->scheduleNext();
+            break;
+        }
+
+        case Event::spu: {
+            spu->step(cdrom.get());
+
+            if (spu->bufferReady) {
+                spu->bufferReady = false;
+                Sound::appendBuffer(spu->audioBuffer.begin(), spu->audioBuffer.end());
+            }
+
+            // GPU lines are scheduled as 3413 cycles, so emulated frame takes more cycles than on real hardware.
+            // Sample interval is derived from the frame length (vblank is reported when the line counter reaches
+            // linesPerFrame() - 1), giving 44100 samples per second of frames displayed at the emulated frame rate.
+            // Remaining drift against the audio device is compensated by Sound resampler.
+            const double frameRate = gpu->isNtsc() ? timing::NTSC_FRAMERATE : timing::PAL_FRAMERATE;
+            const double frameCycles = 3413.0 * (gpu->linesPerFrame() - 1);
+            spuNextSample += frameCycles * frameRate / 44100.0;
+            scheduler.schedule(Event::spu, static_cast<uint64_t>(std::ceil(spuNextSample)));
+            break;
+        }
 
-    if (gpu->emulateGpuCycles(3)) {
-        interrupt->trigger(interrupt::VBLANK);
+        default: break;
     }
+    return false;
+}
+
+bool System::handleEvents() {
+    Scheduler::Event event;
+    while (scheduler.popDue(event)) {
+        if (handleEvent(event)) return true;
+    }
+    return false;
+}
+
+void System::scheduleEvents() {
+    using Event = Scheduler::Event;
+    scheduler.clear();
+
+    uint64_t now = scheduler.now();
+    gpuLastUpdate = now;
+    scheduler.schedule(Event::gpuLine, now + 3413 - gpu->gpuDot);
+
+    spuNextSample = static_cast<double>(now);
+    scheduler.schedule(Event::spu, now);
+
+    scheduler.schedule(Event::dma, now);
+    cdrom->reschedule();
+    controller->reschedule();
+    for (auto& t : timer) t->reschedule();
 }
 
 void System::emulateFrame() {
@@ -350,79 +525,39 @@ void System::emulateFrame() {
 #endif
     cpu->gte.log.clear();
 
-    if (GpuDrawList::currentFrame == 0) {
-        gpu->prevVram = gpu->vram;
-
-        // Save initial state
-        if (gpu->gpuLogEnabled) {
-            gpu->gpuLogList.clear();
-            GpuDrawList::dumpInitialState(gpu.get());
+    // Draw list capture requested from the debugger, GPU commands are not logged otherwise
+    if (GpuDrawList::isCapturing()) {
+        if (GpuDrawList::currentFrame == 0) {
+            GpuDrawList::beginCapture(gpu.get());
         }
-    }
 
-    if (++GpuDrawList::currentFrame >= GpuDrawList::framesToCapture) {
-        GpuDrawList::currentFrame = 0;
-        if (GpuDrawList::framesToCapture != 0) {
-            toast(fmt::format("{} frames capture complete", GpuDrawList::framesToCapture));
-            GpuDrawList::framesToCapture = 0;
+        if (++GpuDrawList::currentFrame > GpuDrawList::framesToCapture) {
+            int frames = GpuDrawList::framesToCapture;
+            GpuDrawList::endCapture(gpu.get());
+            toast(fmt::format("{} frames capture complete", frames));
             state = State::pause;
             return;
         }
     }
 
-    int systemCycles = 300;
+    // Run CPU until the earliest device event, devices schedule their next events when handled
     for (;;) {
-        if (!cpu->executeInstructions(systemCycles / 3)) {
-            return;
-        }
-
-        dma->step();
-        cdrom->step(systemCycles / 1.5f);
-        timer[0]->step(systemCycles);
-        timer[1]->step(systemCycles);
-        timer[2]->step(systemCycles);
-
-        static float spuCounter = 0;
-
-        float magicNumber = 1.575f;
-        if (!gpu->isNtsc()) {
-            // Hack to prevent crackling audio on PAL games
-            // Note - this overclocks SPU clock, bugs might appear.
-            magicNumber *= 50.f / 60.f;
-        }
-        spuCounter += (float)systemCycles / magicNumber / (float)0x300;
-        if (spuCounter >= 1.f) {
-            spu->step(cdrom.get());
-            spuCounter -= 1.0f;
-        }
-
-        if (spu->bufferReady) {
-            spu->bufferReady = false;
-            Sound::appendBuffer(spu->audioBuffer.begin(), spu->audioBuffer.end());
-        }
+        if (handleEvents()) return;  // frame emulated
 
-        controller->step();
+        uint64_t now = scheduler.now();
+        uint64_t next = scheduler.nextEventTime();
+        uint64_t instructions = (next - now + Scheduler::CYCLES_PER_INSTRUCTION - 1) / Scheduler::CYCLES_PER_INSTRUCTION;
 
-        if (gpu->emulateGpuCycles(systemCycles)) {
-            interrupt->trigger(interrupt::VBLANK);
-            return;  // frame emulated
-        }
+        // Cached interpreter and recompiler check for yield only between blocks,
+        // so the run (and the event handling) can be late by up to one block.
+        scheduler.beginRun(next);
+        bool running = cpu->executeInstructions(static_cast<int>(std::min<uint64_t>(instructions, INT32_MAX)));
+        scheduler.endRun();
 
-        // TODO: Move this code to Timer class
-        if (gpu->gpuLine > gpu->linesPerFrame() - 20) {
-            auto& t = *timer[1];
-            if (t.mode.syncEnabled) {
-                using modes = device::timer::CounterMode::SyncMode1;
-                auto mode1 = static_cast<modes>(timer[1]->mode.syncMode);
-                if (mode1 == modes::resetAtVblank || mode1 == modes::resetAtVblankAndPauseOutside) {
-                    timer[1]->current._reg = 0;
-                } else if (mode1 == modes::pauseUntilVblankAndFreerun) {
-                    timer[1]->paused = false;
-                    timer[1]->mode.syncEnabled = false;
-                }
-            }
+        if (!running) {
+            gpu->flushRendering();  // Paused mid-frame
+            return;
         }
-        // Handle Timer1 - Reset on VBlank
     }
 }
 
@@ -446,6 +581,7 @@ void System::softReset() {
     //    cpu->reset();
     cpu->setPC(0xBFC00000);
     cpu->inBranchDelay = false;
+    scheduleEvents();
     state = State::run;
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include "bios/hle.h"
 #include "cpu/cpu.h"
 #include "device/cache_control.h"
 #include "device/cdrom/cdrom.h"
@@ -14,6 +15,8 @@
 #include "device/serial.h"
 #include "device/spu/spu.h"
 #include "device/timer.h"
+#include "scheduler.h"
+#include "utils/fastmem.h"
 #include "utils/macros.h"
 #include "utils/timing.h"
 
@@ -38,7 +41,7 @@
  * Switch --enable-bios-hooks
  * Default: false
  *
- * Enables BIOS syscall hooking/logging
+ * Enables BIOS syscall hooking/logging and native BIOS functions (HLE)
  */
 
 namespace bios {
@@ -65,17 +68,59 @@ struct System {
     static const int SCRATCHPAD_SIZE = 1024;
     static const int EXPANSION_SIZE = 1 * 1024 * 1024;
     static const int IO_SIZE = 0x2000;
+
+    // Memory is mapped in 4KB pages, null page is handled by slow path (scratchpad, IO)
+    static const int PAGE_SHIFT = 12;
+    static const uint32_t PAGE_MASK = (1 << PAGE_SHIFT) - 1;
+    static const int PAGE_COUNT = 0x2000'0000 >> PAGE_SHIFT;
+
+    enum class IoDevice : uint8_t {
+        none,
+        memoryControl,
+        controller,
+        serial,
+        ramControl,
+        interrupt,
+        dma,
+        timer0,
+        timer1,
+        timer2,
+        cdrom,
+        gpu,
+        mdec,
+        spu,
+        expansion2,
+    };
+    static const int IO_DEVICES_BASE = 0x1f801000;
+    static const int IO_DEVICES_SIZE = 0x3000;  // Includes Expansion 2
+
     State state = State::stop;
 
-    std::array<uint8_t, BIOS_SIZE> bios;
-    std::vector<uint8_t> ram;
+    // Shared memory backed, so it can be mapped in fastmem arena
+    std::vector<uint8_t, fastmem::SharedAllocator<uint8_t>> bios;
+    std::vector<uint8_t, fastmem::SharedAllocator<uint8_t>> ram;
     std::array<uint8_t, SCRATCHPAD_SIZE> scratchpad;
     std::array<uint8_t, EXPANSION_SIZE> expansion;
 
+    // Host pointers for physical memory pages, indexed by (address >> PAGE_SHIFT)
+    std::vector<uint8_t*> readPages;
+    std::vector<uint8_t*> writePages;
+    // IO device handling each 32bit port
+    std::array<IoDevice, IO_DEVICES_SIZE / 4> ioDevices;
+
+    // Guest RAM and BIOS mapped at their KUSEG/KSEG0/KSEG1 addresses (nullptr if fastmem is disabled)
+    std::unique_ptr<fastmem::Arena> fastmemArena;
+
     bool debugOutput = true;  // Print BIOS logs
     bool biosLoaded = false;
 
     uint64_t cycles;
+    uint64_t idleCycles = 0;  // Part of cycles skipped in idle loops
+    Scheduler scheduler{cycles};
+
+    // Time of last GPU update and next SPU sample (in system cycles)
+    uint64_t gpuLastUpdate = 0;
+    double spuNextSample = 0;
 
     // Devices
     std::unique_ptr<mips::CPU> cpu;
@@ -99,7 +144,10 @@ struct System {
     template <typename T>
     INLINE void writeMemory(uint32_t address, T data);
     void singleStep();
-    void handleBiosFunction();
+    bool handleEvent(Scheduler::Event event);
+    bool handleEvents();
+    void scheduleEvents();
+    int handleBiosFunction();
     void handleSyscallFunction();
 
     System();
@@ -110,6 +158,7 @@ struct System {
     void writeMemory16(uint32_t address, uint16_t data);
     void writeMemory32(uint32_t address, uint32_t data);
     void printFunctionInfo(const char* functionNum, const bios::Function& f);
+    void mapMemory();
     void emulateFrame();
     void softReset();
     bool isSystemReady();
@@ -117,6 +166,7 @@ struct System {
     // Helpers
     std::string biosPath;
     int biosLog = 0;
+    bios::Hle hle;
     bool printStackTrace = false;
     bool loadBios(const std::string& name);
     bool loadExpansion(const std::vector<uint8_t>& _exe);
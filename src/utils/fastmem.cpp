@@ -0,0 +1,227 @@
+#include "fastmem.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FASTMEM_POSIX
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifndef __APPLE__
+#include <ucontext.h>
+#endif
+#endif
+
+#if defined(FASTMEM_POSIX) && (defined(__x86_64__) || defined(__aarch64__))
+#define FASTMEM_SUPPORTED
+#endif
+
+namespace fastmem {
+
+#ifdef FASTMEM_SUPPORTED
+namespace {
+struct SharedBlock {
+    int fd;
+    size_t size;
+};
+
+std::mutex blocksMutex;
+std::unordered_map<const void*, SharedBlock> blocks;
+
+size_t pageSize() {
+    static const size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+size_t alignToPage(size_t size) { return (size + pageSize() - 1) & ~(pageSize() - 1); }
+
+int createSharedObject(size_t size) {
+    int fd = -1;
+#if defined(__linux__)
+    fd = memfd_create("avocado", 0);
+#else
+    std::string name = fmt::format("/avocado.{}.{}", getpid(), static_cast<void*>(&fd));
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) shm_unlink(name.c_str());
+#endif
+    if (fd < 0) return -1;
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Arenas are looked up from signal handler, so no locks there
+const int MAX_ARENAS = 4;
+std::array<std::atomic<Arena*>, MAX_ARENAS> arenas = {};
+struct sigaction previousSegv, previousBus;
+std::once_flag handlerInstalled;
+
+uintptr_t& programCounter(void* ctx) {
+    auto uc = static_cast<ucontext_t*>(ctx);
+#if defined(__APPLE__) && defined(__x86_64__)
+    return reinterpret_cast<uintptr_t&>(uc->uc_mcontext->__ss.__rip);
+#elif defined(__APPLE__)
+    return reinterpret_cast<uintptr_t&>(uc->uc_mcontext->__ss.__pc);
+#elif defined(__x86_64__) && defined(__linux__)
+    return reinterpret_cast<uintptr_t&>(uc->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__x86_64__)
+    return reinterpret_cast<uintptr_t&>(uc->uc_mcontext.mc_rip);
+#else
+    return reinterpret_cast<uintptr_t&>(uc->uc_mcontext.pc);
+#endif
+}
+
+void signalHandler(int sig, siginfo_t* info, void* ctx) {
+    uintptr_t& pc = programCounter(ctx);
+    uintptr_t resume = handleFault(info->si_addr, pc);
+    if (resume != 0) {
+        pc = resume;
+        return;
+    }
+
+    // Not ours - restore previous handler and let the instruction fault again
+    sigaction(sig, sig == SIGSEGV ? &previousSegv : &previousBus, nullptr);
+}
+
+void installHandler() {
+    struct sigaction action = {};
+    action.sa_sigaction = signalHandler;
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &previousSegv);
+    sigaction(SIGBUS, &action, &previousBus);
+}
+};  // namespace
+
+uintptr_t handleFault(void* address, uintptr_t pc) {
+    auto addr = reinterpret_cast<uint8_t*>(address);
+    for (auto& entry : arenas) {
+        Arena* arena = entry.load(std::memory_order_acquire);
+        if (arena == nullptr || arena->faultHandler == nullptr) continue;
+        if (addr < arena->base || addr >= arena->base + Arena::SIZE) continue;
+
+        return arena->faultHandler(arena->faultContext, pc);
+    }
+    return 0;
+}
+
+void* allocateShared(size_t size) {
+    size_t allocSize = alignToPage(size == 0 ? 1 : size);
+    int fd = createSharedObject(allocSize);
+    if (fd < 0) throw std::bad_alloc();
+
+    void* ptr = mmap(nullptr, allocSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        close(fd);
+        throw std::bad_alloc();
+    }
+
+    std::lock_guard<std::mutex> lock(blocksMutex);
+    blocks[ptr] = {fd, allocSize};
+    return ptr;
+}
+
+void freeShared(void* ptr, size_t) {
+    if (ptr == nullptr) return;
+    std::lock_guard<std::mutex> lock(blocksMutex);
+    auto block = blocks.find(ptr);
+    if (block == blocks.end()) return;
+
+    munmap(ptr, block->second.size);
+    close(block->second.fd);
+    blocks.erase(block);
+}
+
+std::unique_ptr<Arena> Arena::create() {
+    void* ptr = mmap(nullptr, SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ptr == MAP_FAILED) {
+        fmt::print("[FASTMEM] Unable to reserve address space, fastmem disabled\n");
+        return nullptr;
+    }
+
+    auto arena = std::unique_ptr<Arena>(new Arena());
+    arena->base = static_cast<uint8_t*>(ptr);
+
+    bool registered = false;
+    for (auto& entry : arenas) {
+        Arena* expected = nullptr;
+        if (entry.compare_exchange_strong(expected, arena.get())) {
+            registered = true;
+            break;
+        }
+    }
+    if (!registered) {
+        fmt::print("[FASTMEM] Too many arenas, fastmem disabled\n");
+        return nullptr;
+    }
+
+    std::call_once(handlerInstalled, installHandler);
+    return arena;
+}
+
+Arena::~Arena() {
+    for (auto& entry : arenas) {
+        Arena* expected = this;
+        entry.compare_exchange_strong(expected, nullptr);
+    }
+    munmap(base, SIZE);
+}
+
+bool Arena::map(uint32_t address, const void* memory, size_t size, bool writable) {
+    int fd;
+    {
+        std::lock_guard<std::mutex> lock(blocksMutex);
+        auto block = blocks.find(memory);
+        if (block == blocks.end()) return false;
+        fd = block->second.fd;
+        size = std::min(alignToPage(size), block->second.size);
+    }
+
+    int prot = PROT_READ | (writable ? PROT_WRITE : 0);
+    void* ptr = mmap(base + address, size, prot, MAP_SHARED | MAP_FIXED, fd, 0);
+    return ptr != MAP_FAILED;
+}
+
+void Arena::unmapAll() {
+    // Replace whole range with fresh reservation, address range is kept
+    mmap(base, SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+}
+
+void Arena::setFaultHandler(FaultHandler handler, void* context) {
+    faultContext = context;
+    faultHandler = handler;
+}
+
+#else
+uintptr_t handleFault(void* address, uintptr_t pc) { return 0; }
+
+void* allocateShared(size_t size) { return ::operator new(size); }
+
+void freeShared(void* ptr, size_t size) { ::operator delete(ptr); }
+
+std::unique_ptr<Arena> Arena::create() {
+    fmt::print("[FASTMEM] Not supported on this platform, fastmem disabled\n");
+    return nullptr;
+}
+
+Arena::~Arena() {}
+
+bool Arena::map(uint32_t address, const void* memory, size_t size, bool writable) { return false; }
+
+void Arena::unmapAll() {}
+
+void Arena::setFaultHandler(FaultHandler handler, void* context) {
+    faultContext = context;
+    faultHandler = handler;
+}
+#endif
+};  // namespace fastmem
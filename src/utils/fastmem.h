@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+/**
+ * Fastmem - guest address space mirrored in 4GB of reserved host memory.
+ * Guest memory (allocated with SharedAllocator) is mapped at its guest addresses,
+ * everything else is left unmapped and accesses to it fault.
+ */
+namespace fastmem {
+
+// Returns memory backed by shared memory object (zero initialized), so it can be mapped again in the arena
+void* allocateShared(size_t size);
+void freeShared(void* ptr, size_t size);
+
+// Uses shared memory only when it is going to be mapped in the arena, plain heap memory otherwise
+template <typename T>
+struct SharedAllocator {
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    bool shared = false;
+
+    SharedAllocator() = default;
+    explicit SharedAllocator(bool shared) : shared(shared) {}
+    template <typename U>
+    SharedAllocator(const SharedAllocator<U>& other) : shared(other.shared) {}
+
+    T* allocate(size_t n) {
+        if (!shared) return std::allocator<T>().allocate(n);
+        return static_cast<T*>(allocateShared(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) {
+        if (!shared) return std::allocator<T>().deallocate(p, n);
+        freeShared(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const SharedAllocator<U>& other) const {
+        return shared == other.shared;
+    }
+    template <typename U>
+    bool operator!=(const SharedAllocator<U>& other) const {
+        return shared != other.shared;
+    }
+};
+
+// Called with host address of faulting instruction, returns address to continue execution from (or 0 if fault wasn't handled)
+typedef uintptr_t (*FaultHandler)(void* context, uintptr_t pc);
+
+// Dispatches host memory fault to the arena containing address
+uintptr_t handleFault(void* address, uintptr_t pc);
+
+class Arena {
+    uint8_t* base = nullptr;
+    FaultHandler faultHandler = nullptr;
+    void* faultContext = nullptr;
+
+    Arena() = default;
+    friend uintptr_t handleFault(void* address, uintptr_t pc);
+
+   public:
+    static const uint64_t SIZE = 0x1'0000'0000;
+
+    // Returns nullptr if host doesn't support fastmem
+    static std::unique_ptr<Arena> create();
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    uint8_t* data() const { return base; }
+
+    // memory must be allocated with SharedAllocator, size is rounded up to host page size
+    bool map(uint32_t address, const void* memory, size_t size, bool writable);
+    void unmapAll();
+
+    void setFaultHandler(FaultHandler handler, void* context);
+};
+};  // namespace fastmem
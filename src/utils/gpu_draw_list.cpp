@@ -25,19 +25,16 @@ bool load(System *sys, const std::string &path) {
     const int initialSetupCount = r32();
     for (int i = 0; i < initialSetupCount; i++) r32();
 
+    std::vector<uint32_t> args;
     const uint32_t commandCount = r32();
-    for (int i = 0; i < commandCount; i++) {
-        gpu::LogEntry entry;
+    for (uint32_t i = 0; i < commandCount; i++) {
         uint32_t header = r32();
         uint8_t type = (header >> 24) & 0xff;
-        uint8_t count = header & 0xffffff;
+        uint32_t count = header & 0xffffff;
 
-        entry.type = type;
-        for (int j = 0; j < count; j++) {
-            entry.args.push_back(r32());
-        }
-
-        log.push_back(entry);
+        args.resize(count);
+        fread(args.data(), sizeof(uint32_t), count, f);
+        log.push(type, args.data(), count);
     }
 
     fclose(f);
@@ -56,25 +53,25 @@ bool save(System *sys, const std::string &path) {
 
     w32(0);  // No initial setup
 
+    // Log is kept in file layout already
     auto &log = sys->gpu->gpuLogList;
     w32(log.size());
-    for (auto &entry : log) {
-        w32((entry.type << 24) | entry.args.size());
-
-        for (auto arg : entry.args) w32(arg);
-    }
+    fwrite(log.data().data(), sizeof(uint32_t), log.data().size(), f);
 
     fclose(f);
     return true;
 }
 
 void replayCommands(gpu::GPU *gpu, int to) {
+    gpu->flushRendering();
     gpu->vram = gpu->prevVram;
+    gpu->invalidateTextureCache();
 
+    bool logEnabled = gpu->gpuLogEnabled;
     gpu->gpuLogEnabled = false;
     if (to == -1) to = gpu->gpuLogList.size() - 1;
     for (int i = 0; i <= to; i++) {
-        auto entry = gpu->gpuLogList.at(i);
+        auto entry = gpu->gpuLogList[i];
 
         if (entry.args.size() == 0) continue;
         if (entry.type == 0 && entry.cmd() == 0xc0) {
@@ -86,14 +83,15 @@ void replayCommands(gpu::GPU *gpu, int to) {
             gpu->write(addr, arg);
         }
     }
-    gpu->gpuLogEnabled = true;
+    gpu->flushRendering();
+    gpu->gpuLogEnabled = logEnabled;
 }
 
 void dumpInitialState(gpu::GPU *gpu) {
     gpu->prevVram = gpu->vram;
 
-    auto gp0 = [&](uint8_t cmd, uint32_t data) { gpu->gpuLogList.push_back(gpu::LogEntry::GP0(cmd, data)); };
-    auto gp1 = [&](uint8_t cmd, uint32_t data) { gpu->gpuLogList.push_back(gpu::LogEntry::GP1(cmd, data)); };
+    auto gp0 = [&](uint8_t cmd, uint32_t data) { gpu->gpuLogList.pushGP0(cmd, data); };
+    auto gp1 = [&](uint8_t cmd, uint32_t data) { gpu->gpuLogList.pushGP1(cmd, data); };
     gp0(0xe1, gpu->gp0_e1._reg);
     gp0(0xe2, gpu->gp0_e2._reg);
     gp0(0xe3, ((gpu->drawingArea.top << 10) & 0xffc00) | (gpu->drawingArea.left & 0x3ff));
@@ -106,4 +104,24 @@ void dumpInitialState(gpu::GPU *gpu) {
     gp1(0x07, ((gpu->displayRangeY2 & 0x3ff) << 10) | (gpu->displayRangeY1 & 0x3ff));
     gp1(0x08, gpu->gp1_08._reg);
 }
+
+void beginCapture(gpu::GPU *gpu) {
+    // Commands submitted before the capture must not be logged (nor drawn into initial VRAM)
+    gpu->flushRendering();
+
+    gpu->gpuLogList.clear();
+    gpu->gpuLogList.reserve();
+    dumpInitialState(gpu);
+    gpu->gpuLogEnabled = true;
+}
+
+void endCapture(gpu::GPU *gpu) {
+    gpu->flushRendering();
+    gpu->gpuLogEnabled = false;
+
+    framesToCapture = 0;
+    currentFrame = 0;
+}
+
+bool isCapturing() { return framesToCapture != 0; }
 }  // namespace GpuDrawList
\ No newline at end of file
@@ -10,4 +10,9 @@ bool load(System *sys, const std::string &path);
 bool save(System *sys, const std::string &path);
 void replayCommands(gpu::GPU *gpu, int to = -1);
 void dumpInitialState(gpu::GPU *gpu);
+
+// GPU commands are logged only between these calls
+void beginCapture(gpu::GPU *gpu);
+void endCapture(gpu::GPU *gpu);
+bool isCapturing();
 }  // namespace GpuDrawList
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Lock-free queue for exactly one producer and one consumer thread.
+ * Consumer reads elements with peek() and releases them with pop() once it is done with them,
+ * so empty() (seen from the producer) means that every element was fully processed.
+ */
+template <typename T, size_t length>
+class SpscQueue {
+    static_assert((length & (length - 1)) == 0, "Length must be a power of two");
+
+    std::array<T, length> data;
+    alignas(64) std::atomic<size_t> head = 0;  // Written by producer
+    alignas(64) std::atomic<size_t> tail = 0;  // Written by consumer
+
+   public:
+    size_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+    // Producer
+    bool push(const T& t) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == length) {
+            return false;
+        }
+
+        data[h % length] = t;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pushes as many elements as there is free space for, returns their count
+    size_t push(const T* items, size_t count) {
+        size_t h = head.load(std::memory_order_relaxed);
+        count = std::min(count, length - (h - tail.load(std::memory_order_acquire)));
+
+        for (size_t i = 0; i < count; i++) {
+            data[(h + i) % length] = items[i];
+        }
+        head.store(h + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer
+    const T& peek(size_t i = 0) const { return data[(tail.load(std::memory_order_relaxed) + i) % length]; }
+    // Number of elements from peek(0) stored contiguously (before the wrap around)
+    size_t contiguous() const { return std::min(size(), length - tail.load(std::memory_order_relaxed) % length); }
+    void pop(size_t count = 1) { tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release); }
+};
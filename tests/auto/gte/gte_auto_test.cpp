@@ -7,6 +7,7 @@ void printHelp() {
 usage: avocado_autotest logfile.log
   --ignore-flag - ignore reg[63] differences
   --show-input  - print input data on failed assertion
+  --scalar      - use scalar reference implementation instead of SIMD one
   --help        - print help
 )");
 }
@@ -39,6 +40,7 @@ int main(int argc, char** argv) {
     std::string logfile;
     bool showInput = false;
     bool ignoreFlag = false;
+    bool scalar = false;
 
     for (int i = 0; i < argc; i++) {
         if (strcmp(argv[i], "--ignore-flag") == 0) {
@@ -49,6 +51,10 @@ int main(int argc, char** argv) {
             showInput = true;
             continue;
         }
+        if (strcmp(argv[i], "--scalar") == 0) {
+            scalar = true;
+            continue;
+        }
         if (strcmp(argv[i], "--help") == 0) {
             printHelp();
             return 0;
@@ -69,6 +75,7 @@ int main(int argc, char** argv) {
     printf("Test cases found: %zd\n", testCases.size());
 
     GTE gte;
+    gte.forceScalar = scalar;
 
     int testsFailed = 0;
     int testsSuccessful = 0;
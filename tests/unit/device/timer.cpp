@@ -0,0 +1,93 @@
+#include "device/timer.h"
+#include <catch2/catch.hpp>
+#include "system.h"
+
+namespace device::timer {
+
+namespace {
+const uint16_t RESET_WHEN_TARGET = 1 << 3;
+const uint16_t IRQ_WHEN_TARGET = 1 << 4;
+const uint16_t IRQ_REPEATEDLY = 1 << 6;
+const uint16_t REACHED_TARGET = 1 << 11;
+const uint16_t REACHED_FFFF = 1 << 12;
+
+void write16(Timer& timer, uint32_t address, uint16_t value) {
+    timer.write(address, value & 0xff);
+    timer.write(address + 1, value >> 8);
+}
+
+uint16_t read16(Timer& timer, uint32_t address) { return timer.read(address) | (timer.read(address + 1) << 8); }
+
+// Timer0 clocked by system clock counts 2 ticks every instruction
+void setup(System& sys, uint16_t target, uint16_t mode) {
+    sys.cycles = 0;
+    write16(*sys.timer[0], 8, target);
+    write16(*sys.timer[0], 4, mode);
+}
+}  // namespace
+
+TEST_CASE("Counter resets when target is crossed", "[timer]") {
+    System sys;
+    setup(sys, 100, RESET_WHEN_TARGET);
+
+    sys.cycles = 40;
+    REQUIRE(read16(*sys.timer[0], 0) == 80);
+    REQUIRE_FALSE(read16(*sys.timer[0], 4) & REACHED_TARGET);
+
+    sys.cycles = 70;
+    REQUIRE(read16(*sys.timer[0], 0) == 40);
+    REQUIRE(read16(*sys.timer[0], 4) & REACHED_TARGET);
+    REQUIRE_FALSE(read16(*sys.timer[0], 4) & REACHED_TARGET);  // Cleared on read
+}
+
+TEST_CASE("Counter crosses target and wraps at 0xffff", "[timer]") {
+    System sys;
+    setup(sys, 100, 0);
+
+    sys.cycles = 100;
+    REQUIRE(read16(*sys.timer[0], 0) == 200);
+    uint16_t mode = read16(*sys.timer[0], 4);
+    REQUIRE(mode & REACHED_TARGET);
+    REQUIRE_FALSE(mode & REACHED_FFFF);
+
+    sys.cycles = 0x8000;  // 0x10000 ticks
+    REQUIRE(read16(*sys.timer[0], 0) == 1);
+    REQUIRE(read16(*sys.timer[0], 4) & REACHED_FFFF);
+}
+
+TEST_CASE("Target 0 with reset on target is reached on every tick", "[timer]") {
+    System sys;
+    setup(sys, 0, RESET_WHEN_TARGET | IRQ_WHEN_TARGET | IRQ_REPEATEDLY);
+
+    for (uint64_t cycles : {1, 2, 1000}) {
+        sys.interrupt->write(0, 0);  // Acknowledge
+        sys.cycles = cycles;
+        REQUIRE(read16(*sys.timer[0], 0) == 0);
+        REQUIRE(read16(*sys.timer[0], 4) & REACHED_TARGET);
+        REQUIRE(sys.interrupt->read(0) & (1 << interrupt::TIMER0));
+    }
+}
+
+TEST_CASE("Target 0 with reset on 0xffff is reached when counter wraps", "[timer]") {
+    System sys;
+    setup(sys, 0, 0);
+
+    sys.cycles = 0x7fff;  // 0xfffe ticks
+    REQUIRE(read16(*sys.timer[0], 0) == 0xfffe);
+    REQUIRE_FALSE(read16(*sys.timer[0], 4) & REACHED_TARGET);
+
+    sys.cycles = 0x8000;
+    REQUIRE(read16(*sys.timer[0], 0) == 1);
+    REQUIRE(read16(*sys.timer[0], 4) & REACHED_TARGET);
+}
+
+TEST_CASE("Target irq is scheduled at the crossing", "[timer]") {
+    System sys;
+    sys.scheduler.clear();
+    setup(sys, 100, RESET_WHEN_TARGET | IRQ_WHEN_TARGET);
+
+    REQUIRE(sys.scheduler.isPending(Scheduler::Event::timer0));
+    REQUIRE(sys.scheduler.nextEventTime() == 150);  // 50 instructions
+}
+
+}  // namespace device::timer
@@ -0,0 +1,89 @@
+#include "scheduler.h"
+#include <catch2/catch.hpp>
+
+TEST_CASE("Events are popped in time order", "[scheduler]") {
+    uint64_t instructions = 0;
+    Scheduler scheduler(instructions);
+
+    scheduler.schedule(Scheduler::Event::spu, 30);
+    scheduler.schedule(Scheduler::Event::gpuLine, 10);
+    scheduler.schedule(Scheduler::Event::dma, 20);
+    REQUIRE(scheduler.nextEventTime() == 10);
+
+    Scheduler::Event event;
+    REQUIRE_FALSE(scheduler.popDue(event));
+
+    instructions = 10;  // 30 cycles
+    REQUIRE(scheduler.popDue(event));
+    REQUIRE(event == Scheduler::Event::gpuLine);
+    REQUIRE(scheduler.popDue(event));
+    REQUIRE(event == Scheduler::Event::dma);
+    REQUIRE(scheduler.popDue(event));
+    REQUIRE(event == Scheduler::Event::spu);
+    REQUIRE_FALSE(scheduler.popDue(event));
+    REQUIRE(scheduler.nextEventTime() == Scheduler::NEVER);
+}
+
+TEST_CASE("Scheduling event again replaces previous occurrence", "[scheduler]") {
+    uint64_t instructions = 0;
+    Scheduler scheduler(instructions);
+
+    scheduler.schedule(Scheduler::Event::timer0, 10);
+    scheduler.schedule(Scheduler::Event::timer0, 50);
+    REQUIRE(scheduler.nextEventTime() == 50);
+
+    instructions = 100;
+    Scheduler::Event event;
+    REQUIRE(scheduler.popDue(event));
+    REQUIRE(event == Scheduler::Event::timer0);
+    REQUIRE_FALSE(scheduler.popDue(event));
+    REQUIRE_FALSE(scheduler.isPending(Scheduler::Event::timer0));
+}
+
+TEST_CASE("Cancelled event is never popped", "[scheduler]") {
+    uint64_t instructions = 0;
+    Scheduler scheduler(instructions);
+
+    scheduler.schedule(Scheduler::Event::cdrom, 10);
+    scheduler.schedule(Scheduler::Event::controller, 20);
+    scheduler.cancel(Scheduler::Event::cdrom);
+    REQUIRE_FALSE(scheduler.isPending(Scheduler::Event::cdrom));
+    REQUIRE(scheduler.nextEventTime() == 20);
+
+    scheduler.clear();
+    REQUIRE(scheduler.nextEventTime() == Scheduler::NEVER);
+}
+
+TEST_CASE("Frequent rescheduling keeps only the latest occurrence", "[scheduler]") {
+    uint64_t instructions = 0;
+    Scheduler scheduler(instructions);
+
+    for (uint64_t time = 1000; time > 0; time--) {
+        scheduler.schedule(Scheduler::Event::spu, time);
+        scheduler.schedule(Scheduler::Event::dma, 2000 - time);
+    }
+    REQUIRE(scheduler.nextEventTime() == 1);
+
+    instructions = 1000;
+    Scheduler::Event event;
+    REQUIRE(scheduler.popDue(event));
+    REQUIRE(event == Scheduler::Event::spu);
+    REQUIRE(scheduler.popDue(event));
+    REQUIRE(event == Scheduler::Event::dma);
+    REQUIRE_FALSE(scheduler.popDue(event));
+}
+
+TEST_CASE("Event earlier than end of CPU run requests yield", "[scheduler]") {
+    uint64_t instructions = 0;
+    Scheduler scheduler(instructions);
+
+    scheduler.beginRun(100);
+    scheduler.schedule(Scheduler::Event::gpuLine, 150);
+    REQUIRE_FALSE(scheduler.yieldCpu);
+
+    scheduler.schedule(Scheduler::Event::controller, 50);
+    REQUIRE(scheduler.yieldCpu);
+
+    scheduler.endRun();
+    REQUIRE_FALSE(scheduler.yieldCpu);
+}
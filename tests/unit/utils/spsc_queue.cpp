@@ -0,0 +1,82 @@
+#include "utils/spsc_queue.h"
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Queue is empty after popping all pushed elements", "[spsc_queue]") {
+    SpscQueue<uint32_t, 4> queue;
+    REQUIRE(queue.empty());
+
+    REQUIRE(queue.push(1));
+    REQUIRE(queue.push(2));
+    REQUIRE(queue.size() == 2);
+    REQUIRE(queue.peek(0) == 1);
+    REQUIRE(queue.peek(1) == 2);
+
+    queue.pop(2);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Full queue rejects push", "[spsc_queue]") {
+    SpscQueue<uint32_t, 4> queue;
+    for (uint32_t i = 0; i < 4; i++) REQUIRE(queue.push(i));
+    REQUIRE_FALSE(queue.push(4));
+
+    uint32_t items[] = {5, 6, 7};
+    REQUIRE(queue.push(items, 3) == 0);
+
+    queue.pop();
+    REQUIRE(queue.push(items, 3) == 1);
+    REQUIRE(queue.peek(3) == 5);
+}
+
+TEST_CASE("Elements wrap around the end of the buffer", "[spsc_queue]") {
+    SpscQueue<uint32_t, 4> queue;
+    uint32_t first[] = {0, 1, 2};
+    REQUIRE(queue.push(first, 3) == 3);
+    queue.pop(3);
+
+    uint32_t second[] = {3, 4, 5};
+    REQUIRE(queue.push(second, 3) == 3);
+    REQUIRE(queue.size() == 3);
+    REQUIRE(queue.contiguous() == 1);
+    REQUIRE(queue.peek(0) == 3);
+    REQUIRE(queue.peek(1) == 4);
+    REQUIRE(queue.peek(2) == 5);
+
+    queue.pop(queue.contiguous());
+    REQUIRE(queue.contiguous() == 2);
+    REQUIRE(queue.peek() == 4);
+}
+
+TEST_CASE("Consumer thread receives elements in order", "[spsc_queue]") {
+    const uint32_t COUNT = 1000000;
+    SpscQueue<uint32_t, 64> queue;
+
+    bool ordered = true;
+    std::thread consumer([&] {
+        uint32_t expected = 0;
+        while (expected < COUNT) {
+            size_t n = queue.contiguous();
+            for (size_t i = 0; i < n; i++) {
+                if (queue.peek(i) != expected++) ordered = false;
+            }
+            queue.pop(n);
+            if (n == 0) std::this_thread::yield();
+        }
+    });
+
+    std::vector<uint32_t> batch(7);
+    for (uint32_t i = 0; i < COUNT;) {
+        for (size_t j = 0; j < batch.size(); j++) batch[j] = i + j;
+        size_t count = std::min<size_t>(batch.size(), COUNT - i);
+        size_t pushed = queue.push(batch.data(), count);
+        if (pushed == 0) std::this_thread::yield();
+        i += pushed;
+    }
+
+    consumer.join();
+    REQUIRE(ordered);
+    REQUIRE(queue.empty());
+}